@@ -0,0 +1,18 @@
+// HSOSC stub for simulation - iCE40UP5K 48 MHz internal oscillator
+//
+// The real primitive is a hard block that only exists in Radiant's library.
+// Here CLKHF is just `osc`, which sim_top drives from its clk port with a
+// downward reference (the stub itself reaches nowhere), so the design runs
+// cycle accurate on any Verilog simulator. CLKHF_DIV is accepted and ignored
+// (the project only uses "0b00", 48 MHz).
+module HSOSC #(
+    parameter CLKHF_DIV = "0b00"
+) (
+    input  logic CLKHFPU,
+    input  logic CLKHFEN,
+    output logic CLKHF
+);
+    logic osc;
+
+    assign CLKHF = osc & CLKHFPU & CLKHFEN;
+endmodule
@@ -0,0 +1,32 @@
+// SP256K stub for simulation - iCE40UP5K 16K x 16 single port RAM
+//
+// Behavioural model of the hard block: registered read, nibble write mask.
+// STDBY / SLEEP / PWROFF_N only stop the port here (the project ties them
+// off). Read-during-write returns the old word.
+module SP256K (
+    input  logic [13:0] AD,
+    input  logic [15:0] DI,
+    input  logic [3:0]  MASKWE,
+    input  logic        WE,
+    input  logic        CS,
+    input  logic        CK,
+    input  logic        STDBY,
+    input  logic        SLEEP,
+    input  logic        PWROFF_N,
+    output logic [15:0] DO
+);
+    logic [15:0] mem [0:16383];
+
+    always_ff @(posedge CK) begin
+        if (!PWROFF_N) begin
+            DO <= 16'd0;
+        end else if (CS && !STDBY && !SLEEP) begin
+            DO <= mem[AD];
+            if (WE) begin
+                for (int n = 0; n < 4; n++) begin
+                    if (MASKWE[n]) mem[AD][4*n +: 4] <= DI[4*n +: 4];
+                end
+            end
+        end
+    end
+endmodule
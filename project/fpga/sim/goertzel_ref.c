@@ -0,0 +1,125 @@
+// goertzel_ref.c
+// Bit-exact C model of goertzel_bank.sv, plus the coefficient generator
+//
+//   goertzel_ref --coef              goertzel_coef.mem for $readmemh
+//   goertzel_ref --tone <hz> <amp>   levels for one block of a sine tone
+
+#include "goertzel_ref.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Same band split as fpga_link.c on the MCU
+static const double bandEdges[GZ_NUM_BANDS + 1] = {
+    0, 170, 330, 500, 670, 830, 1000, 1170, 1340, 1500, 1670, 1840, 4000
+};
+
+static int16_t q14(double v) {
+    long r = lround(v * 16384.0);
+    if (r > 32767) r = 32767;
+    if (r < -32768) r = -32768;
+    return (int16_t)r;
+}
+
+static int16_t sat16(int32_t v) {
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return (int16_t)v;
+}
+
+void gzCoefs(GzCoef* coef) {
+    for (int k = 0; k < GZ_NUM_BINS; k++) {
+        int bin = k + 1;
+        double f = (double)bin * GZ_FS / GZ_N;
+        double w = 2.0 * M_PI * bin / GZ_N;
+
+        int band = 0;
+        while (band < GZ_NUM_BANDS - 1 && f > bandEdges[band + 1]) band++;
+
+        coef[k].c2 = q14(2.0 * cos(w));
+        coef[k].cos = q14(cos(w));
+        coef[k].sin = q14(sin(w));
+        coef[k].band = band;
+        coef[k].bin = bin;
+    }
+}
+
+int gzLog2Q3(uint32_t p) {
+    if (p == 0) return 0;
+    int msb = 31;
+    while (!(p & (1u << msb))) msb--;
+    int frac = msb >= 3 ? (p >> (msb - 3)) & 7 : (p << (3 - msb)) & 7;
+    return msb * 8 + frac;
+}
+
+uint8_t gzLevel(uint32_t p) {
+    int l = gzLog2Q3(p);
+    if (l <= GZ_LEVEL_FLOOR) return 0;
+    int level = (l - GZ_LEVEL_FLOOR) * GZ_LEVEL_GAIN;
+    return level > 255 ? 255 : (uint8_t)level;
+}
+
+void gzBlock(const GzCoef* coef, const int16_t* x, uint8_t* levels) {
+    memset(levels, 0, GZ_NUM_BANDS);
+
+    for (int k = 0; k < GZ_NUM_BINS; k++) {
+        // s[n] = x[n] + 2cos(w) s[n-1] - s[n-2], 32 bit wrap like the RTL
+        int32_t s1 = 0, s2 = 0;
+        for (int n = 0; n < GZ_N; n++) {
+            int64_t prod = (int64_t)coef[k].c2 * s1;
+            int32_t s = (int32_t)((uint32_t)x[n] + (uint32_t)(int32_t)(prod >> 14) - (uint32_t)s2);
+            s2 = s1;
+            s1 = s;
+        }
+
+        // y[N] = s1 - e^-jw s2
+        int32_t re = (int32_t)((uint32_t)s1 - (uint32_t)(int32_t)(((int64_t)coef[k].cos * s2) >> 14));
+        int32_t im = (int32_t)(((int64_t)coef[k].sin * s2) >> 14);
+        int16_t reS = sat16(re >> GZ_SCALE_SHIFT);
+        int16_t imS = sat16(im >> GZ_SCALE_SHIFT);
+        uint32_t p = (uint32_t)((int32_t)reS * reS) + (uint32_t)((int32_t)imS * imS);
+
+        uint8_t level = gzLevel(p);
+        if (level > levels[coef[k].band]) levels[coef[k].band] = level;
+    }
+}
+
+#ifndef GZ_REF_NO_MAIN
+int main(int argc, char** argv) {
+    GzCoef coef[GZ_NUM_BINS];
+    gzCoefs(coef);
+
+    if (argc >= 2 && strcmp(argv[1], "--coef") == 0) {
+        // {c2, cos, sin, band} per line, 52 bits, read by goertzel_bank.sv
+        for (int k = 0; k < GZ_NUM_BINS; k++) {
+            printf("%04x%04x%04x%x  // bin %d (%.1f Hz) band %d\n",
+                   (uint16_t)coef[k].c2, (uint16_t)coef[k].cos, (uint16_t)coef[k].sin,
+                   coef[k].band, coef[k].bin, (double)coef[k].bin * GZ_FS / GZ_N,
+                   coef[k].band);
+        }
+        return 0;
+    }
+
+    if (argc >= 4 && strcmp(argv[1], "--tone") == 0) {
+        double hz = atof(argv[2]);
+        double amp = atof(argv[3]);
+        int16_t x[GZ_N];
+        uint8_t levels[GZ_NUM_BANDS];
+        for (int n = 0; n < GZ_N; n++) {
+            x[n] = (int16_t)lround(amp * sin(2.0 * M_PI * hz * n / GZ_FS));
+        }
+        gzBlock(coef, x, levels);
+        for (int b = 0; b < GZ_NUM_BANDS; b++) printf("%d ", levels[b]);
+        printf("\n");
+        return 0;
+    }
+
+    fprintf(stderr, "usage: %s --coef | --tone <hz> <amp>\n", argv[0]);
+    return 1;
+}
+#endif
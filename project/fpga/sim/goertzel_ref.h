@@ -0,0 +1,38 @@
+// goertzel_ref.h
+// Bit-exact C model of goertzel_bank.sv
+
+#ifndef GOERTZEL_REF_H
+#define GOERTZEL_REF_H
+
+#include <stdint.h>
+
+#define GZ_N              256     // samples per block (one SPI frame 0x03)
+#define GZ_FS             8000    // sample rate of the MCU ADC
+#define GZ_NUM_BANDS      12
+#define GZ_NUM_BINS       (GZ_N / 2 - 1)  // every bin from 1 to Nyquist - 1
+#define GZ_SCALE_SHIFT    4       // y[N] >> 4 before squaring, keeps it in 16 bits
+#define GZ_LEVEL_FLOOR    165     // log2(power) in 1/8 steps mapped to level 0
+#define GZ_LEVEL_GAIN     5       // level steps per 1/8 log2 step (~6.6 per dB)
+
+typedef struct {
+    int16_t c2;     // 2cos(w), Q2.14
+    int16_t cos;    // cos(w),  Q1.14
+    int16_t sin;    // sin(w),  Q1.14
+    int band;       // LED band this bin feeds
+    int bin;        // DFT bin of this filter
+} GzCoef;
+
+/* Fills GZ_NUM_BINS coefficients, bins 1..GZ_NUM_BINS. Every bin is
+ * computed: with no window a tone on a bin centre is exactly zero in all
+ * other bins, so skipping bins would leave holes in a band. */
+void gzCoefs(GzCoef* coef);
+
+/* One block of GZ_N samples -> GZ_NUM_BANDS levels (0-255), same arithmetic
+ * as the hardware */
+void gzBlock(const GzCoef* coef, const int16_t* x, uint8_t* levels);
+
+/* log2 of p in 1/8 steps (0 for p = 0) and its level mapping */
+int gzLog2Q3(uint32_t p);
+uint8_t gzLevel(uint32_t p);
+
+#endif
@@ -0,0 +1,93 @@
+// history_decode.c
+// Reader for the history_buffer.sv UART dump
+//
+//   history_decode [--waterfall] <capture file | ->
+//
+// The capture is the raw serial stream from hist_tx (1 Mbaud 8N1), e.g.
+// stty -F /dev/ttyUSB0 1000000 raw && cat /dev/ttyUSB0 > dump.bin while the
+// MCU sends fpgaHistoryDump(). Prints CSV (frame, ms, 12 levels) or one text
+// line per frame with the bands as shades, oldest first.
+
+#include "history_decode.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int histParse(const uint8_t* buf, size_t len, HistRecord* out, int maxRecords) {
+    // Header: A5 5A count_hi count_lo bands
+    for (size_t i = 0; i + 5 <= len; i++) {
+        if (buf[i] != 0xA5 || buf[i + 1] != 0x5A || buf[i + 4] != HIST_NUM_BANDS) continue;
+
+        int count = (buf[i + 2] << 8) | buf[i + 3];
+        size_t body = i + 5;
+        if (count > HIST_MAX_RECORDS) continue;
+        if (body + (size_t)count * HIST_RECORD_BYTES + 1 > len) return -1;
+
+        uint8_t sum = 0;
+        for (size_t j = 0; j < (size_t)count * HIST_RECORD_BYTES; j++) sum += buf[body + j];
+        if (sum != buf[body + (size_t)count * HIST_RECORD_BYTES]) return -2;
+
+        int n = count < maxRecords ? count : maxRecords;
+        for (int r = 0; r < n; r++) {
+            const uint8_t* p = &buf[body + (size_t)r * HIST_RECORD_BYTES];
+            out[r].frame = (uint16_t)((p[0] << 8) | p[1]);
+            out[r].ms = (uint16_t)((p[2] << 8) | p[3]);
+            memcpy(out[r].levels, &p[4], HIST_NUM_BANDS);
+        }
+        return n;
+    }
+    return -1;
+}
+
+#ifndef HIST_NO_MAIN
+int main(int argc, char** argv) {
+    int waterfall = 0;
+    const char* path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--waterfall") == 0) waterfall = 1;
+        else path = argv[i];
+    }
+    if (path == NULL) {
+        fprintf(stderr, "usage: %s [--waterfall] <capture file | ->\n", argv[0]);
+        return 1;
+    }
+
+    FILE* f = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    size_t cap = 5 + HIST_MAX_RECORDS * HIST_RECORD_BYTES + 1 + 4096;
+    uint8_t* buf = malloc(cap);
+    size_t len = fread(buf, 1, cap, f);
+    if (f != stdin) fclose(f);
+
+    static HistRecord rec[HIST_MAX_RECORDS];
+    int n = histParse(buf, len, rec, HIST_MAX_RECORDS);
+    free(buf);
+    if (n < 0) {
+        fprintf(stderr, "%s\n", n == -2 ? "checksum error" : "no complete dump found");
+        return 1;
+    }
+
+    static const char shades[] = " .:-=+*#%@";
+    int gaps = 0;
+    for (int r = 0; r < n; r++) {
+        if (r > 0 && (uint16_t)(rec[r].frame - rec[r - 1].frame) != 1) gaps++;
+        if (waterfall) {
+            printf("%5u %5u |", rec[r].frame, rec[r].ms);
+            for (int b = 0; b < HIST_NUM_BANDS; b++) {
+                putchar(shades[rec[r].levels[b] * 10 / 256]);
+                putchar(shades[rec[r].levels[b] * 10 / 256]);
+            }
+            printf("|\n");
+        } else {
+            printf("%u,%u", rec[r].frame, rec[r].ms);
+            for (int b = 0; b < HIST_NUM_BANDS; b++) printf(",%u", rec[r].levels[b]);
+            printf("\n");
+        }
+    }
+    fprintf(stderr, "%d records, %d gaps\n", n, gaps);
+    return 0;
+}
+#endif
@@ -0,0 +1,25 @@
+// history_decode.h
+// Reader for the history_buffer.sv UART dump
+
+#ifndef HISTORY_DECODE_H
+#define HISTORY_DECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HIST_NUM_BANDS      12
+#define HIST_RECORD_BYTES   (4 + HIST_NUM_BANDS)
+#define HIST_MAX_RECORDS    2048    // history_buffer.sv RECORDS
+
+typedef struct {
+    uint16_t frame;     // capture count, gaps = frames not recorded
+    uint16_t ms;        // FPGA millisecond counter, wraps
+    uint8_t levels[HIST_NUM_BANDS];
+} HistRecord;
+
+/* Finds the first dump in buf and decodes up to maxRecords records.
+ * Returns the record count, -1 if there is no complete dump, -2 if the
+ * checksum is wrong. */
+int histParse(const uint8_t* buf, size_t len, HistRecord* out, int maxRecords);
+
+#endif
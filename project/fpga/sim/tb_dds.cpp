@@ -0,0 +1,152 @@
+// tb_dds.cpp
+// Verilator testbench for dds_voices.sv
+//
+// Loads a voice frame, then checks per voice: pulse spacing against the
+// ideal DDS period (error under one clock, no drift), pulse width, the
+// on-time clamp and the duty cycle holdoff.
+
+#include "Vdds_voices.h"
+#include "verilated.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+static const double CLK_HZ = 48e6;
+static const int NUM_VOICES = 4;
+static const int MAX_ON_CYCLES = 4800;
+static const int HOLDOFF_RATIO = 19;
+
+static Vdds_voices* dut;
+static uint64_t cycles = 0;
+
+static void tick() {
+    dut->clk = 0;
+    dut->eval();
+    dut->clk = 1;
+    dut->eval();
+    cycles++;
+}
+
+static void sendByte(int index, uint8_t data) {
+    dut->byte_valid = 1;
+    dut->byte_index = index;
+    dut->byte_data = data;
+    tick();
+    dut->byte_valid = 0;
+    for (int i = 0; i < 20; i++) tick();
+}
+
+static void sendVoices(const uint32_t* fword, const uint16_t* width) {
+    dut->frame_type = 0x04;
+    sendByte(0, 0x04);
+    sendByte(1, 0);
+    int idx = 2;
+    for (int v = 0; v < NUM_VOICES; v++) {
+        for (int b = 3; b >= 0; b--) sendByte(idx++, (uint8_t)(fword[v] >> (8 * b)));
+        sendByte(idx++, (uint8_t)(width[v] >> 8));
+        sendByte(idx++, (uint8_t)width[v]);
+    }
+    dut->frame_len = idx;
+    dut->frame_end = 1;
+    tick();
+    dut->frame_end = 0;
+}
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    dut = new Vdds_voices;
+
+    dut->reset = 1;
+    tick();
+    dut->reset = 0;
+    tick();
+
+    // 440 Hz / 50 us, 1 kHz asking for 200 us (clamped, duty limited),
+    // 2637.02 Hz / 10 us, voice 3 off
+    const double hz[NUM_VOICES] = {440.0, 1000.0, 2637.02, 0.0};
+    const uint16_t width[NUM_VOICES] = {2400, 9600, 480, 2400};
+    uint32_t fword[NUM_VOICES];
+    for (int v = 0; v < NUM_VOICES; v++) fword[v] = (uint32_t)llround(hz[v] * 4294967296.0 / CLK_HZ);
+    sendVoices(fword, width);
+
+    uint64_t rise[NUM_VOICES][64];
+    int rises[NUM_VOICES] = {0};       // recorded, first 64
+    int pulses[NUM_VOICES] = {0};      // all
+    uint64_t onCycles[NUM_VOICES] = {0};
+    int lastOn[NUM_VOICES] = {0};
+    uint64_t start = cycles;
+    int fails = 0;
+    int coilMismatch = 0;
+    int prevAny = 0;
+
+    for (uint64_t c = 0; c < 48000 * 40; c++) {    // 40 ms
+        tick();
+        int any = 0;
+        for (int v = 0; v < NUM_VOICES; v++) {
+            int on = (dut->voice_on >> v) & 1;
+            any |= on;
+            if (on) onCycles[v]++;
+            if (on && !lastOn[v]) {
+                pulses[v]++;
+                if (rises[v] < 64) rise[v][rises[v]++] = cycles;
+            }
+            lastOn[v] = on;
+        }
+        // coil_out is the OR of the voices one clock later
+        if (dut->coil_out != prevAny) coilMismatch++;
+        prevAny = any;
+    }
+    double secs = (cycles - start) / CLK_HZ;
+
+    for (int v = 0; v < NUM_VOICES; v++) {
+        int bad = 0;
+        double ideal = 4294967296.0 / fword[v];     // clocks per wrap
+        int expectWidth = width[v] > MAX_ON_CYCLES ? MAX_ON_CYCLES : width[v];
+        double duty = onCycles[v] / (secs * CLK_HZ);
+
+        if (fword[v] == 0) {
+            bad = pulses[v] != 0;
+            printf("%s voice %d off: %d pulses\n", bad ? "FAIL" : "ok  ", v, pulses[v]);
+            fails += bad;
+            continue;
+        }
+
+        // Pulses may only start on wraps, and stay within one clock of the
+        // ideal wrap time measured from the first pulse
+        double maxErr = 0;
+        for (int i = 1; i < rises[v]; i++) {
+            double wraps = std::round((rise[v][i] - rise[v][0]) / ideal);
+            double err = std::fabs((rise[v][i] - rise[v][0]) - wraps * ideal);
+            if (err > maxErr) maxErr = err;
+        }
+        if (maxErr >= 1.0) bad = 1;
+
+        // Holdoff: a new pulse at least width * (1 + ratio) after the last
+        double minGap = 1e18;
+        for (int i = 1; i < rises[v]; i++) {
+            double gap = (double)(rise[v][i] - rise[v][i - 1]);
+            if (gap < minGap) minGap = gap;
+        }
+        if (rises[v] > 1 && minGap < (double)expectWidth * (1 + HOLDOFF_RATIO)) bad = 1;
+        if (duty > 1.0 / (1 + HOLDOFF_RATIO) + 1e-6) bad = 1;
+
+        // Width: every pulse is expectWidth long, the last one may be cut
+        // off by the end of the run
+        if (onCycles[v] > (uint64_t)pulses[v] * expectWidth ||
+            onCycles[v] <= (uint64_t)(pulses[v] - 1) * expectWidth) bad = 1;
+
+        printf("%s voice %d %8.2f Hz: %d pulses, width %d, max edge error %.3f clk, duty %.2f%%\n",
+               bad ? "FAIL" : "ok  ", v, hz[v], pulses[v], expectWidth, maxErr, 100.0 * duty);
+        fails += bad;
+    }
+    if (coilMismatch) {
+        printf("FAIL coil_out differs from the voice OR on %d clocks\n", coilMismatch);
+        fails++;
+    }
+
+    printf("%s\n", fails ? "FAILED" : "PASSED");
+    dut->final();
+    delete dut;
+    return fails ? 1 : 0;
+}
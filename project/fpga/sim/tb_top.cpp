@@ -0,0 +1,243 @@
+// tb_top.cpp
+// Verilator harness for the whole display pipeline in top.sv
+//
+//   - square waves at chosen frequencies: the lit LED must be the bucket the
+//     reference model picks from the reciprocal counter thresholds, also
+//     with spikes on the line that the capture front end has to filter
+//   - SPI levels frames: every LED's sigma-delta duty must match
+//     gamma.mem[level widened to 10 bits] / 4096
+//   - reports simulated clock cycles per second of host time
+//
+// Runs from the RTL directory so $readmemh finds the .mem files.
+
+#include "Vsim_top.h"
+#include "verilated.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+static Vsim_top* dut;
+static uint64_t cycles = 0;
+
+// top.sv defaults: reciprocal counter, 4 edges, reset bucket table
+static const double CLK_HZ = 48e6;
+static const int N_EDGES = 4;
+static const int BUCKET_HZ[11] = {170, 340, 510, 680, 840, 1010, 1180, 1350, 1510, 1680, 1850};
+static const uint64_t WINDOW_CYCLES = 4800000;
+
+static int gamma_lut[1024];
+
+// Square wave generator state
+static uint32_t sq_half = 0;        // 0 = hold
+static uint32_t sq_count = 0;
+static uint32_t sq_spike = 0;       // spike this wide mid half period, 0 = none
+static int sq_level = 0;
+
+static void tick() {
+    if (sq_half) {
+        if (++sq_count >= sq_half) {
+            sq_count = 0;
+            sq_level ^= 1;
+        }
+        // Ringing: a short opposite pulse in the middle of each half period
+        int spike = sq_spike && sq_count >= sq_half / 2 && sq_count < sq_half / 2 + sq_spike;
+        dut->square = sq_level ^ spike;
+    }
+    dut->clk = 0;
+    dut->eval();
+    dut->clk = 1;
+    dut->eval();
+    cycles++;
+}
+
+static void run(uint64_t n) {
+    for (uint64_t i = 0; i < n; i++) tick();
+}
+
+static void resetDut() {
+    sq_half = 0;
+    sq_spike = 0;
+    sq_level = 0;
+    dut->square = 0;
+    dut->sck = 0;
+    dut->sdi = 0;
+    dut->cs_n = 1;
+    dut->reset_in = 0;
+    run(4);
+    dut->reset_in = 1;
+    run(4);
+}
+
+// High cycles of every LED over n clocks
+static void measureDuty(uint64_t n, uint32_t* high) {
+    for (int i = 0; i < 12; i++) high[i] = 0;
+    for (uint64_t c = 0; c < n; c++) {
+        tick();
+        for (int i = 0; i < 12; i++) high[i] += (dut->led >> i) & 1;
+    }
+}
+
+static int loadGamma(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+    for (int i = 0; i < 1024; i++) {
+        if (fscanf(f, "%x", &gamma_lut[i]) != 1) {
+            fclose(f);
+            return -1;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Reference model
+///////////////////////////////////////////////////////////////////////////////
+
+// Half period the generator uses for hz, and the period the counter sees
+static uint32_t halfCycles(double hz) {
+    return (uint32_t)lround(CLK_HZ / (2.0 * hz));
+}
+
+// -1 = no reading (slower than the counter timeout)
+static int refBucket(uint32_t half) {
+    uint64_t period = (uint64_t)2 * half * N_EDGES;
+    if (period > WINDOW_CYCLES) return -1;
+    int bucket = 0;
+    for (int k = 0; k < 11; k++) {
+        if (period < (uint64_t)(48000000ULL * N_EDGES / BUCKET_HZ[k])) bucket++;
+    }
+    return bucket;
+}
+
+// 8 bit frame level -> 10 bit brightness, as top.sv loads it
+static int widen(int level) {
+    return (level << 2) | (level >> 6);
+}
+
+// One exponential fade step on the 10 bit brightness, as in top.sv
+static int fadeStep(int b) {
+    return b > 0 ? b - ((b >> 4) + 1) : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Tests
+///////////////////////////////////////////////////////////////////////////////
+
+static int testSquare(double hz, uint32_t spike) {
+    resetDut();
+    sq_half = halfCycles(hz);
+    sq_spike = spike;
+    int expect = refBucket(sq_half);
+
+    // Long enough for a few measurements at the lowest frequency
+    run(3 * 2 * (uint64_t)sq_half * N_EDGES + 100000);
+
+    uint32_t high[12];
+    const uint64_t W = 4096 * 8;
+    measureDuty(W, high);
+
+    int lit = -1, others = 0;
+    for (int i = 0; i < 12; i++) {
+        if (high[i] > W / 2) {
+            if (lit >= 0) others++;
+            lit = i;
+        } else if (high[i] != 0) {
+            others++;
+        }
+    }
+    int bucket = lit >= 0 ? 11 - lit : -1;
+
+    int bad = (bucket != expect) || others;
+    printf("%s square %7.1f Hz%s  bucket %2d (expect %2d)%s\n", bad ? "FAIL" : "ok  ",
+           hz, spike ? " + spikes" : "", bucket, expect, others ? "  other LEDs on" : "");
+    return bad;
+}
+
+// SPI mode 0, MSB first, ~5 MHz (5 clocks per half bit)
+static void spiByte(uint8_t b) {
+    for (int i = 7; i >= 0; i--) {
+        dut->sdi = (b >> i) & 1;
+        run(5);
+        dut->sck = 1;
+        run(5);
+        dut->sck = 0;
+    }
+}
+
+static void spiFrame(const uint8_t* bytes, int len) {
+    dut->cs_n = 0;
+    run(5);
+    for (int i = 0; i < len; i++) spiByte(bytes[i]);
+    run(5);
+    dut->cs_n = 1;
+    run(10);    // synchronizer + commit
+}
+
+static int testLevels(const uint8_t* levels) {
+    resetDut();
+
+    uint8_t frame[14] = {0x01, 0x00};
+    for (int b = 0; b < 12; b++) frame[2 + b] = levels[b];
+    spiFrame(frame, 14);
+    run(64);    // gamma refresh: each LED every 12 clocks
+
+    uint32_t high[12];
+    const uint64_t W = 4096 * 4;
+    measureDuty(W, high);
+
+    int fails = 0;
+    for (int b = 0; b < 12; b++) {
+        uint32_t got = high[11 - b];
+        // A fade step may land inside the window: allow the faded level too
+        long e0 = (long)gamma_lut[widen(levels[b])] * (W / 4096);
+        long e1 = (long)gamma_lut[fadeStep(widen(levels[b]))] * (W / 4096);
+        long lo = (e1 < e0 ? e1 : e0) - 1, hi = (e1 > e0 ? e1 : e0) + 1;
+        int bad = (long)got < lo || (long)got > hi;
+        if (bad) {
+            printf("FAIL level %3d on band %2d: %u high of %llu, expect %ld\n",
+                   levels[b], b, got, (unsigned long long)W, e0);
+        }
+        fails += bad;
+    }
+    printf("%s SPI levels frame, 12 duties\n", fails ? "FAIL" : "ok  ");
+    return fails != 0;
+}
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    dut = new Vsim_top;
+
+    if (loadGamma("gamma.mem")) {
+        fprintf(stderr, "gamma.mem not found, run from source/impl_1\n");
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int fails = 0;
+
+    // Bucket selection across the range, near edges, and below the timeout
+    const double freqs[] = {30, 150, 175, 250, 440, 700, 1000, 1300, 1600, 1900, 3000};
+    for (double hz : freqs) fails += testSquare(hz, 0);
+
+    // Spikes under the deglitch width (24 clocks) must not add edges, which
+    // would double the frequency and move the bucket
+    fails += testSquare(440, 12);
+    fails += testSquare(1000, 23);
+
+    const uint8_t ramp[12] = {0, 1, 8, 32, 64, 96, 128, 160, 192, 224, 250, 255};
+    fails += testLevels(ramp);
+    const uint8_t single[12] = {0, 0, 0, 0, 0, 200, 0, 0, 0, 0, 0, 0};
+    fails += testLevels(single);
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%s, %llu cycles in %.2f s = %.2f M cycles/s (%.3fx real time)\n",
+           fails ? "FAILED" : "PASSED", (unsigned long long)cycles, secs,
+           cycles / secs / 1e6, cycles / secs / CLK_HZ);
+
+    dut->final();
+    delete dut;
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,232 @@
+// tb_ws2812.cpp
+// Verilator testbench for ws2812_bars.sv (+ ws2812_tx.sv)
+//
+// Decodes the dout waveform the way a WS2812 does and checks every bit is
+// exactly T0H / T1H high inside a TBIT period, the reset gap, and the pixels
+// against a C model of the renderer: for a bar frame, a Goertzel bin stream
+// and a short (rejected) bar frame. Then reports the measured frame rate and
+// the rate for other chain lengths from the same timing.
+
+#include "Vws2812_bars.h"
+#include "verilated.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static const double CLK_HZ = 48e6;
+static const int NUM_BANDS = 64;      // ws2812_bars.sv defaults
+static const int BAR_HEIGHT = 8;
+static const int BRIGHTNESS = 48;
+static const int NUM_LEDS = NUM_BANDS * BAR_HEIGHT;
+static const int TBIT = 60, T0H = 17, T1H = 34, TRESET = 14400;
+
+static Vws2812_bars* dut;
+static uint64_t cycles = 0;
+
+// dout decoder
+static std::vector<uint32_t> pixels;      // frame being received
+static std::vector<std::vector<uint32_t>> frames;
+static uint32_t shiftIn = 0;
+static int bitsIn = 0;
+static int lastDout = 0;
+static uint64_t riseAt = 0, lastRise = 0, fallAt = 0;
+static int timingErrors = 0;
+static uint64_t frameStarts[2] = {0, 0};
+static int nFrameStarts = 0;
+
+static void decode() {
+    int d = dut->dout;
+    if (d && !lastDout) {
+        uint64_t gap = cycles - fallAt;
+        if (gap >= (uint64_t)TRESET) {
+            // Reset gap: a new frame starts
+            if (!pixels.empty()) frames.push_back(pixels);
+            pixels.clear();
+            bitsIn = 0;
+            frameStarts[0] = frameStarts[1];
+            frameStarts[1] = cycles;
+            nFrameStarts++;
+        } else if (cycles - lastRise != (uint64_t)TBIT) {
+            timingErrors++;
+        }
+        lastRise = riseAt = cycles;
+    } else if (!d && lastDout) {
+        int high = (int)(cycles - riseAt);
+        int bit = 0;
+        if (high == T1H) bit = 1;
+        else if (high != T0H) timingErrors++;
+        shiftIn = (shiftIn << 1) | bit;
+        if (++bitsIn == 24) {
+            pixels.push_back(shiftIn & 0xFFFFFF);
+            bitsIn = 0;
+        }
+        fallAt = cycles;
+    }
+    lastDout = d;
+}
+
+static void tick() {
+    dut->clk = 0;
+    dut->eval();
+    dut->clk = 1;
+    dut->eval();
+    cycles++;
+    decode();
+}
+
+static void sendByte(int index, uint8_t data) {
+    dut->byte_valid = 1;
+    dut->byte_index = index > 63 ? 63 : index;
+    dut->byte_data = data;
+    tick();
+    dut->byte_valid = 0;
+    for (int i = 0; i < 20; i++) tick();
+}
+
+static void sendBars(const uint8_t* levels, int count) {
+    dut->frame_type = 0x05;
+    sendByte(0, 0x05);
+    sendByte(1, 0);
+    for (int b = 0; b < count; b++) sendByte(2 + b, levels[b]);
+    dut->frame_end = 1;
+    tick();
+    dut->frame_end = 0;
+    dut->frame_type = 0;
+    tick();
+}
+
+static void sendBins(const uint8_t* bins, int count) {
+    for (int k = 0; k < count; k++) {
+        dut->bin_valid = 1;
+        dut->bin_index = k;
+        dut->bin_level = bins[k];
+        tick();
+        dut->bin_valid = 0;
+        for (int i = 0; i < 5; i++) tick();    // goertzel_bank: one bin per 6 clocks
+    }
+    dut->bins_done = 1;
+    tick();
+    dut->bins_done = 0;
+}
+
+// C model of the renderer
+static void render(const uint8_t* levels, std::vector<uint32_t>& out) {
+    out.assign(NUM_LEDS, 0);
+    for (int p = 0; p < NUM_LEDS; p++) {
+        int band = p / BAR_HEIGHT;
+        int pos = p % BAR_HEIGHT;
+        int row = (band & 1) ? BAR_HEIGHT - 1 - pos : pos;
+
+        int t = row * 256 / (BAR_HEIGHT - 1);
+        int r = BRIGHTNESS * 2 * t / 256;
+        int g = BRIGHTNESS * 2 * (256 - t) / 256;
+        if (r > BRIGHTNESS) r = BRIGHTNESS;
+        if (g > BRIGHTNESS) g = BRIGHTNESS;
+        uint32_t base = ((uint32_t)g << 16) | ((uint32_t)r << 8);
+
+        int height = levels[band] == 0 ? 0 : (levels[band] + 1) * BAR_HEIGHT;
+        int full = height >> 8;
+        int part = (height >> 6) & 3;
+        uint32_t c = 0;
+        if (row < full) {
+            c = base;
+        } else if (row == full) {
+            for (int ch = 0; ch < 3; ch++) {
+                int v = (base >> (8 * ch)) & 0xFF;
+                int s = ((part & 2) ? v >> 1 : 0) + ((part & 1) ? v >> 2 : 0);
+                c |= (uint32_t)s << (8 * ch);
+            }
+        }
+        out[p] = c;
+    }
+}
+
+// Waits for two complete frames (the first may have been rendered before
+// the update) and compares the last one
+static int checkFrame(const char* name, const uint8_t* levels) {
+    size_t target = frames.size() + 2;
+    while (frames.size() < target) tick();
+
+    std::vector<uint32_t> expect;
+    render(levels, expect);
+    const std::vector<uint32_t>& got = frames.back();
+
+    int bad = 0;
+    if (got.size() != (size_t)NUM_LEDS) {
+        printf("FAIL %-20s %zu pixels, expected %d\n", name, got.size(), NUM_LEDS);
+        return 1;
+    }
+    for (int p = 0; p < NUM_LEDS; p++) {
+        if (got[p] != expect[p]) {
+            if (bad < 4) printf("     %s pixel %d: %06X, expected %06X\n", name, p, got[p], expect[p]);
+            bad++;
+        }
+    }
+    printf("%s %-20s %d/%d pixels wrong\n", bad ? "FAIL" : "ok  ", name, bad, NUM_LEDS);
+    return bad != 0;
+}
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    dut = new Vws2812_bars;
+
+    dut->reset = 1;
+    tick();
+    dut->reset = 0;
+    tick();
+
+    int fails = 0;
+    uint8_t levels[NUM_BANDS];
+
+    // Bar frame: a ramp through every level step plus full scale and zero
+    for (int b = 0; b < NUM_BANDS; b++) levels[b] = (uint8_t)(b * 255 / (NUM_BANDS - 1));
+    levels[1] = 0;
+    sendBars(levels, NUM_BANDS);
+    fails += checkFrame("bar frame", levels);
+
+    // Short bar frame: must be ignored, picture unchanged
+    uint8_t junk[NUM_BANDS];
+    for (int b = 0; b < NUM_BANDS; b++) junk[b] = 200;
+    sendBars(junk, NUM_BANDS - 1);
+    fails += checkFrame("short bar frame", levels);
+
+    // Goertzel bins: band = max of its 128 / NUM_BANDS bins
+    const int binsPerBand = 128 / NUM_BANDS;
+    uint8_t bins[127];
+    for (int k = 0; k < 127; k++) bins[k] = (uint8_t)((k * 37 + 11) % 256);
+    for (int b = 0; b < NUM_BANDS; b++) {
+        levels[b] = 0;
+        for (int k = b * binsPerBand; k < (b + 1) * binsPerBand && k < 127; k++) {
+            if (bins[k] > levels[b]) levels[b] = bins[k];
+        }
+    }
+    sendBins(bins, 127);
+    fails += checkFrame("goertzel bins", levels);
+
+    if (timingErrors) {
+        printf("FAIL %d bits off T0H / T1H / TBIT\n", timingErrors);
+        fails++;
+    }
+
+    // Frame rate: measured frame period vs NUM_LEDS * 24 * TBIT + TRESET + 1
+    uint64_t period = frameStarts[1] - frameStarts[0];
+    uint64_t expectPeriod = (uint64_t)NUM_LEDS * 24 * TBIT + TRESET + 1;
+    int badPeriod = period != expectPeriod;
+    printf("%s frame period %llu clocks (%.3f ms, %.1f fps), expected %llu\n",
+           badPeriod ? "FAIL" : "ok  ", (unsigned long long)period, period / CLK_HZ * 1e3,
+           CLK_HZ / period, (unsigned long long)expectPeriod);
+    fails += badPeriod;
+
+    printf("\nchain length   frame     fps\n");
+    const int lengths[] = {64, 128, 256, 384, 512, 768, 1024};
+    for (int len : lengths) {
+        double p = (double)len * 24 * TBIT + TRESET + 1;
+        printf("  %5d       %6.2f ms  %6.1f\n", len, p / CLK_HZ * 1e3, CLK_HZ / p);
+    }
+
+    printf("%s\n", fails ? "FAILED" : "PASSED");
+    dut->final();
+    delete dut;
+    return fails ? 1 : 0;
+}
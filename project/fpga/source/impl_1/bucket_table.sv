@@ -0,0 +1,109 @@
+// Bucket table - run-time programmable thresholds for the square wave input
+//
+// NUM_BUCKETS-1 thresholds live in a register file. Every threshold is
+// compared against the measurement in parallel, the resulting thermometer
+// code is registered, then popcounted into a bucket number. Both stages are
+// one compare / one adder tree deep no matter how many buckets there are, so
+// 24 or 48 buckets cost area, not clock speed. The table must be sorted
+// (ascending frequency) for the popcount to equal the bucket index.
+//
+// INVERT = 0: value is an edge count, passes threshold k if value >= thr[k]
+// INVERT = 1: value is a period,      passes threshold k if value <  thr[k]
+//
+// Load frame (type 0x02): [0x02][seq][thr0 hi][thr0 mid][thr0 lo]...
+// with exactly NUM_BUCKETS-1 big-endian 24 bit thresholds. The new table is
+// shadowed and only committed on a complete, correctly sized frame.
+module bucket_table #(
+    parameter int NUM_BUCKETS = 12,
+    parameter int WIDTH       = 23,
+    parameter bit INVERT      = 1'b0,
+    parameter logic [(NUM_BUCKETS-1)*WIDTH-1:0] DEFAULTS = '0  // thr[k] at [k*WIDTH +: WIDTH]
+) (
+    input  logic             clk,
+    input  logic             reset,
+    // Measurement in, bucket out two cycles later
+    input  logic             in_valid,
+    input  logic [WIDTH-1:0] value,
+    output logic             out_valid,
+    output logic [$clog2(NUM_BUCKETS)-1:0] bucket,
+    // SPI byte stream (spi_frame_rx)
+    input  logic             byte_valid,
+    input  logic [7:0]       byte_data,
+    input  logic [5:0]       byte_index,
+    input  logic [7:0]       frame_type,
+    input  logic             frame_end,
+    input  logic [5:0]       frame_len
+);
+    localparam [7:0] TYPE_THRESHOLDS = 8'h02;
+    localparam int   NUM_THR   = NUM_BUCKETS - 1;
+    localparam int   TABLE_LEN = 2 + 3 * NUM_THR;
+
+    logic [WIDTH-1:0] thr    [NUM_THR-1:0];
+    logic [23:0]      shadow [NUM_THR-1:0];
+    logic [NUM_THR-1:0] therm;
+    logic             therm_valid;
+
+    //===========================================
+    // LOADER: bytes into the shadow, commit on frame end
+    //===========================================
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            for (int k = 0; k < NUM_THR; k++) begin
+                shadow[k] <= 24'd0;
+            end
+        end else if (byte_valid && frame_type == TYPE_THRESHOLDS &&
+                     byte_index >= 6'd2 && byte_index < 6'(TABLE_LEN)) begin
+            // byte_index - 2 = 3*k + b, big-endian within each entry
+            for (int k = 0; k < NUM_THR; k++) begin
+                for (int b = 0; b < 3; b++) begin
+                    if (byte_index == 6'(2 + 3*k + b)) begin
+                        shadow[k][8*(2-b) +: 8] <= byte_data;
+                    end
+                end
+            end
+        end
+    end
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            for (int k = 0; k < NUM_THR; k++) begin
+                thr[k] <= DEFAULTS[k*WIDTH +: WIDTH];
+            end
+        end else if (frame_end && frame_type == TYPE_THRESHOLDS &&
+                     frame_len == 6'(TABLE_LEN)) begin
+            for (int k = 0; k < NUM_THR; k++) begin
+                // Saturate entries that do not fit WIDTH
+                thr[k] <= (shadow[k] >> WIDTH) != 0 ? '1 : shadow[k][WIDTH-1:0];
+            end
+        end
+    end
+
+    //===========================================
+    // STAGE 1: parallel compare into a thermometer code
+    //===========================================
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            therm       <= '0;
+            therm_valid <= 1'b0;
+        end else begin
+            therm_valid <= in_valid;
+            for (int k = 0; k < NUM_THR; k++) begin
+                therm[k] <= INVERT ? (value < thr[k]) : (value >= thr[k]);
+            end
+        end
+    end
+
+    //===========================================
+    // STAGE 2: popcount = bucket
+    //===========================================
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            bucket    <= '0;
+            out_valid <= 1'b0;
+        end else begin
+            out_valid <= therm_valid;
+            bucket    <= $countones(therm);
+        end
+    end
+
+endmodule
@@ -0,0 +1,163 @@
+// Capture front end - N input channels, each synchronized and deglitched,
+// with falling-edge pulses and optional edge timestamps in a shared FIFO
+//
+// Deglitch: a channel's clean level only follows the synchronized input once
+// the input has held the new level for MIN_PULSE clocks, so ringing and
+// spikes shorter than that never become edges. Every clean edge is delayed
+// by the same 2 + MIN_PULSE clocks, so periods and timestamps are exact.
+//
+// Timestamps: each clean falling edge stores the free-running TS_WIDTH
+// counter into a per-channel holding register, which is pushed into the FIFO
+// as {channel, timestamp} (lowest channel first if several are waiting).
+// An edge that arrives before its channel's previous one was pushed, or
+// finds the FIFO full, is counted in overflow. FIFO_DEPTH = 0 builds no
+// timestamp logic at all.
+module capture_frontend #(
+    parameter int N_CH       = 1,
+    parameter int MIN_PULSE  = 24,      // clocks, 0.5 us at 48 MHz
+    parameter int TS_WIDTH   = 32,
+    parameter int FIFO_DEPTH = 16       // power of 2, or 0 for no timestamps
+) (
+    input  logic                 clk,
+    input  logic                 reset,
+    input  logic [N_CH-1:0]      async_in,
+    output logic [N_CH-1:0]      level,       // deglitched input
+    output logic [N_CH-1:0]      fall,        // 1 cycle pulse per clean falling edge
+    // Timestamp FIFO (show-ahead: rd_data is valid whenever !empty)
+    input  logic                 rd_en,
+    output logic                 empty,
+    output logic [$clog2(N_CH > 1 ? N_CH : 2)-1:0] rd_channel,
+    output logic [TS_WIDTH-1:0]  rd_timestamp,
+    output logic [15:0]          overflow
+);
+    localparam int CW = $clog2(N_CH > 1 ? N_CH : 2);
+    localparam int GW = $clog2(MIN_PULSE > 1 ? MIN_PULSE : 2) + 1;
+
+    logic [N_CH-1:0] sync;
+
+    //===========================================
+    // PER CHANNEL: synchronizer + deglitch + edge
+    //===========================================
+    genvar ch;
+    generate
+        for (ch = 0; ch < N_CH; ch++) begin : gen_channel
+            logic [GW-1:0] glitch_count;
+
+            synchronizer input_synchronizer (
+                .clk(clk),
+                .reset(reset),
+                .async_in(async_in[ch]),
+                .sync_out(sync[ch])
+            );
+
+            always_ff @(posedge clk, posedge reset) begin
+                if (reset) begin
+                    level[ch]    <= 1'b0;
+                    fall[ch]     <= 1'b0;
+                    glitch_count <= '0;
+                end else begin
+                    fall[ch] <= 1'b0;
+                    if (sync[ch] == level[ch]) begin
+                        glitch_count <= '0;
+                    end else if (glitch_count >= GW'(MIN_PULSE - 1)) begin
+                        level[ch]    <= sync[ch];
+                        fall[ch]     <= level[ch] & ~sync[ch];
+                        glitch_count <= '0;
+                    end else begin
+                        glitch_count <= glitch_count + 1'b1;
+                    end
+                end
+            end
+        end
+    endgenerate
+
+    //===========================================
+    // TIMESTAMP FIFO
+    //===========================================
+    generate
+        if (FIFO_DEPTH > 0) begin : gen_timestamps
+            localparam int AW = $clog2(FIFO_DEPTH);
+
+            logic [TS_WIDTH-1:0]    ts;
+            logic [N_CH-1:0]        pending;
+            logic [TS_WIDTH-1:0]    held [N_CH-1:0];
+            logic [CW+TS_WIDTH-1:0] mem [0:FIFO_DEPTH-1];
+            logic [AW:0]            wr_ptr, rd_ptr;
+            logic                   full, push;
+            logic [CW-1:0]          push_ch;
+            logic [CW+1:0]          drops;
+
+            assign full  = (wr_ptr[AW] != rd_ptr[AW]) && (wr_ptr[AW-1:0] == rd_ptr[AW-1:0]);
+            assign empty = (wr_ptr == rd_ptr);
+            assign {rd_channel, rd_timestamp} = mem[rd_ptr[AW-1:0]];
+
+            // Lowest pending channel goes first
+            always_comb begin
+                push    = 1'b0;
+                push_ch = '0;
+                for (int i = N_CH - 1; i >= 0; i--) begin
+                    if (pending[i]) begin
+                        push    = 1'b1;
+                        push_ch = CW'(i);
+                    end
+                end
+            end
+
+            // Edges lost this cycle: a push into a full FIFO, plus every
+            // channel whose new edge lands on a holding register that is
+            // not being pushed. Summed here so overflow is written once.
+            always_comb begin
+                drops = '0;
+                if (push && full) drops = drops + 1'b1;
+                for (int i = 0; i < N_CH; i++) begin
+                    if (fall[i] && pending[i] && !(push && push_ch == CW'(i)))
+                        drops = drops + 1'b1;
+                end
+            end
+
+            always_ff @(posedge clk, posedge reset) begin
+                if (reset) begin
+                    ts       <= '0;
+                    pending  <= '0;
+                    wr_ptr   <= '0;
+                    rd_ptr   <= '0;
+                    overflow <= 16'd0;
+                    for (int i = 0; i < N_CH; i++) begin
+                        held[i] <= '0;
+                    end
+                end else begin
+                    ts <= ts + 1'b1;
+
+                    if (push) begin
+                        if (!full) begin
+                            mem[wr_ptr[AW-1:0]] <= {push_ch, held[push_ch]};
+                            wr_ptr <= wr_ptr + 1'b1;
+                        end
+                        pending[push_ch] <= 1'b0;
+                    end
+
+                    // Saturating
+                    if (overflow > 16'hFFFF - 16'(drops))
+                        overflow <= 16'hFFFF;
+                    else
+                        overflow <= overflow + 16'(drops);
+
+                    for (int i = 0; i < N_CH; i++) begin
+                        if (fall[i]) begin
+                            pending[i] <= 1'b1;
+                            held[i]    <= ts;
+                        end
+                    end
+
+                    if (rd_en && !empty) rd_ptr <= rd_ptr + 1'b1;
+                end
+            end
+        end else begin : gen_no_timestamps
+            assign empty        = 1'b1;
+            assign rd_channel   = '0;
+            assign rd_timestamp = '0;
+            assign overflow     = 16'd0;
+        end
+    endgenerate
+
+endmodule
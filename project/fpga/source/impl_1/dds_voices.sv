@@ -0,0 +1,128 @@
+// DDS voices - coil interrupter pulses from 32 bit phase accumulators
+//
+// Every voice adds its frequency word to a 32 bit phase each 48 MHz clock
+// (f = fword * 48 MHz / 2^32, 0.011 Hz steps) and fires a pulse on every
+// phase wrap. Pulse edges land on the first clock after the ideal time, so
+// timing error is under one clock (20.8 ns) and does not accumulate.
+// Changing the word keeps the phase, so note changes are glitch free.
+//
+// Limits, enforced here whatever the MCU sends:
+//   - on-time: pulse width is clamped to MAX_ON_CYCLES
+//   - duty: after a pulse a voice cannot fire again for HOLDOFF_RATIO times
+//     its width (19 = 5% max duty); wraps in that time are skipped
+//
+// Voice frame (type 0x04): [0x04][seq] then per voice
+// [fword 31:24][23:16][15:8][7:0][width 15:8][7:0], width in clocks, fword 0
+// = note off. All voices are committed together on a complete frame.
+module dds_voices #(
+    parameter int NUM_VOICES    = 4,
+    parameter int MAX_ON_CYCLES = 4800,   // 100 us
+    parameter int HOLDOFF_RATIO = 19
+) (
+    input  logic                  clk,
+    input  logic                  reset,
+    // SPI byte stream (spi_frame_rx)
+    input  logic                  byte_valid,
+    input  logic [7:0]            byte_data,
+    input  logic [5:0]            byte_index,
+    input  logic [7:0]            frame_type,
+    input  logic                  frame_end,
+    input  logic [5:0]            frame_len,
+    // Interrupter output: OR of all voices, registered
+    output logic                  coil_out,
+    output logic [NUM_VOICES-1:0] voice_on
+);
+    localparam [7:0] TYPE_VOICES = 8'h04;
+    localparam int   FRAME_LEN   = 2 + 6 * NUM_VOICES;
+
+    logic [47:0] shadow [NUM_VOICES-1:0];   // {fword, width}
+    logic [31:0] fword  [NUM_VOICES-1:0];
+    logic [15:0] width  [NUM_VOICES-1:0];
+    logic [20:0] holdoff_len [NUM_VOICES-1:0];
+
+    //===========================================
+    // LOADER: bytes into the shadow, commit on frame end
+    //===========================================
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            for (int v = 0; v < NUM_VOICES; v++) begin
+                shadow[v] <= 48'd0;
+            end
+        end else if (byte_valid && frame_type == TYPE_VOICES &&
+                     byte_index >= 6'd2 && byte_index < 6'(FRAME_LEN)) begin
+            for (int v = 0; v < NUM_VOICES; v++) begin
+                for (int b = 0; b < 6; b++) begin
+                    if (byte_index == 6'(2 + 6*v + b)) begin
+                        shadow[v][8*(5-b) +: 8] <= byte_data;
+                    end
+                end
+            end
+        end
+    end
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            for (int v = 0; v < NUM_VOICES; v++) begin
+                fword[v]       <= 32'd0;
+                width[v]       <= 16'd0;
+                holdoff_len[v] <= 21'd0;
+            end
+        end else if (frame_end && frame_type == TYPE_VOICES && frame_len == 6'(FRAME_LEN)) begin
+            for (int v = 0; v < NUM_VOICES; v++) begin
+                fword[v] <= shadow[v][47:16];
+                if (shadow[v][15:0] > 16'(MAX_ON_CYCLES)) begin
+                    width[v]       <= 16'(MAX_ON_CYCLES);
+                    holdoff_len[v] <= 21'(MAX_ON_CYCLES * HOLDOFF_RATIO);
+                end else begin
+                    width[v]       <= shadow[v][15:0];
+                    holdoff_len[v] <= 21'(shadow[v][15:0]) * 21'(HOLDOFF_RATIO);
+                end
+            end
+        end
+    end
+
+    //===========================================
+    // VOICES
+    //===========================================
+    genvar gv;
+    generate
+        for (gv = 0; gv < NUM_VOICES; gv++) begin : gen_voice
+            logic [31:0] phase;
+            logic [32:0] phase_sum;
+            logic [15:0] on_count;
+            logic [20:0] holdoff_count;
+
+            assign phase_sum     = {1'b0, phase} + {1'b0, fword[gv]};
+            assign voice_on[gv]  = (on_count != 16'd0);
+
+            always_ff @(posedge clk, posedge reset) begin
+                if (reset) begin
+                    phase         <= 32'd0;
+                    on_count      <= 16'd0;
+                    holdoff_count <= 21'd0;
+                end else begin
+                    // Note off resets the phase, the next note on starts clean
+                    phase <= (fword[gv] == 32'd0) ? 32'd0 : phase_sum[31:0];
+
+                    if (on_count != 16'd0) begin
+                        on_count <= on_count - 16'd1;
+                    end else if (holdoff_count != 21'd0) begin
+                        holdoff_count <= holdoff_count - 21'd1;
+                    end else if (phase_sum[32] && fword[gv] != 32'd0 && width[gv] != 16'd0) begin
+                        on_count      <= width[gv];
+                        holdoff_count <= holdoff_len[gv];
+                    end
+                end
+            end
+        end
+    endgenerate
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            coil_out <= 1'b0;
+        end else begin
+            coil_out <= |voice_on;
+        end
+    end
+
+endmodule
@@ -0,0 +1,22 @@
+// Gamma LUT - 10 bit perceptual brightness to 12 bit LED duty
+//
+// 1024 x 12 bit table, registered read (one cycle latency). The EBR is at
+// most 4 bits wide at 1024 deep, so this takes three of them.
+// gamma.mem holds round(4095 * (i/1023)^2.2), with every nonzero input
+// forced to at least 1 so the lowest levels still glow (inputs 1-28 all
+// land on duty 1, the 12 bit floor).
+module gamma_lut (
+    input  logic        clk,
+    input  logic [9:0]  addr,
+    output logic [11:0] data
+);
+    logic [11:0] table_mem [0:1023];
+
+    initial $readmemh("gamma.mem", table_mem);
+
+    // No reset on the read register, so it maps onto the EBR output latch
+    always_ff @(posedge clk) begin
+        data <= table_mem[addr];
+    end
+
+endmodule
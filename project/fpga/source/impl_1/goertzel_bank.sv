@@ -0,0 +1,347 @@
+// Goertzel bank - on-FPGA spectrum from raw samples sent by the MCU
+//
+// Sample frame (type 0x03): [0x03][seq][x0 hi][x0 lo]...[x255 hi][x255 lo],
+// signed 16 bit samples (ADC code - 2048) at 8 kHz. One frame is one block.
+// Every DFT bin 1..NUM_BINS runs the Goertzel recursion
+//
+//   s[n] = x[n] + 2cos(w) s[n-1] - s[n-2]
+//
+// and at the end of a complete frame |y[N]|^2 with y[N] = s1 - e^-jw s2 is
+// turned into a log level; each LED band takes the max of its bins.
+//
+// One multiplier (inferred on SB_MAC16s, 16 x 32 bit) is shared by all bins.
+// Per sample the bins are pipelined one per clock, so NUM_BINS (127) cycles
+// per sample: the SPI clock has to stay at or below 5 MHz (154 clocks per
+// sample). Bin state {s1, s2} and the coefficient ROM {2cos, cos, sin, band}
+// are in EBR with registered reads. Frames of the wrong length are thrown
+// away (state cleared, no output), same as the other frame types.
+//
+// sim/goertzel_ref.c is the bit-exact C model and generates goertzel_coef.mem.
+module goertzel_bank #(
+    parameter int N            = 256,
+    parameter int NUM_BINS     = 127,
+    parameter int NUM_BANDS    = 12,
+    parameter int SCALE_SHIFT  = 4,
+    parameter int LEVEL_FLOOR  = 165,
+    parameter int LEVEL_GAIN   = 5
+) (
+    input  logic       clk,
+    input  logic       reset,
+    // SPI byte stream (spi_frame_rx)
+    input  logic       byte_valid,
+    input  logic [7:0] byte_data,
+    input  logic [5:0] byte_index,
+    input  logic [7:0] frame_type,
+    input  logic       frame_end,
+    // Band levels, updated once per complete frame
+    output logic       levels_valid,
+    output logic [7:0] levels [NUM_BANDS-1:0],
+    // Every bin's level as it is finished (bin 1 first), levels_valid after
+    // the last one: for displays with more bands than LEDs (ws2812_bars.sv)
+    output logic       bin_valid,
+    output logic [$clog2(NUM_BINS + 1)-1:0] bin_index,   // 0 = bin 1
+    output logic [7:0] bin_level
+);
+    localparam [7:0] TYPE_SAMPLES = 8'h03;
+    localparam int   KW = $clog2(NUM_BINS + 1);
+
+    typedef enum logic [3:0] {
+        IDLE,
+        ITER,       // one bin per clock, recursion for the current sample
+        F_COS,      // finish: cos * s2
+        F_SIN,      // re = s1 - cos*s2, sin * s2
+        F_RE2,      // im = sin*s2, re^2
+        F_IM2,      // power = re^2, im^2
+        F_SUM,      // power += im^2
+        F_LEVEL,    // log level, band max, clear bin state
+        CLEAR,      // bad frame: clear bin state
+        DONE
+    } gz_state_t;
+
+    gz_state_t state;
+
+    //===========================================
+    // SAMPLE INTAKE
+    //===========================================
+    logic               sample_hi_next;
+    logic [7:0]         sample_hi;
+    logic signed [15:0] sample;
+    logic               sample_pending;
+    logic [9:0]         sample_count;
+    logic               block_error;
+    logic               finish_req;
+    logic               clear_req;
+    logic               take_sample;
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            sample_hi_next <= 1'b1;
+            sample_hi      <= 8'd0;
+            sample         <= 16'sd0;
+            sample_pending <= 1'b0;
+            sample_count   <= 10'd0;
+            block_error    <= 1'b0;
+            finish_req     <= 1'b0;
+            clear_req      <= 1'b0;
+        end else begin
+            if (take_sample) sample_pending <= 1'b0;
+            if (state == F_COS) finish_req <= 1'b0;
+            if (state == CLEAR) clear_req <= 1'b0;
+
+            if (byte_valid && frame_type == TYPE_SAMPLES && byte_index >= 6'd2) begin
+                // First payload byte starts a new block
+                if (byte_index == 6'd2) begin
+                    sample_count <= 10'd0;
+                    block_error  <= (state != IDLE);   // still finishing the last one
+                end
+                if (byte_index == 6'd2 || sample_hi_next) begin
+                    sample_hi      <= byte_data;
+                    sample_hi_next <= 1'b0;
+                end else begin
+                    sample         <= {sample_hi, byte_data};
+                    sample_hi_next <= 1'b1;
+                    sample_count   <= sample_count + 10'd1;
+                    // Too many samples, or the last one was not taken yet
+                    if (sample_count >= 10'(N) || (sample_pending && !take_sample))
+                        block_error <= 1'b1;
+                    else
+                        sample_pending <= 1'b1;
+                end
+            end
+
+            if (frame_end && frame_type == TYPE_SAMPLES) begin
+                sample_hi_next <= 1'b1;
+                sample_count   <= 10'd0;   // a bare CS blip must not finish again
+                if (sample_count == 10'(N) && !block_error) finish_req <= 1'b1;
+                else                                        clear_req  <= 1'b1;
+            end
+        end
+    end
+
+    //===========================================
+    // BIN STATE + COEFFICIENTS (EBR, registered read)
+    //===========================================
+    logic [63:0] state_mem [0:NUM_BINS-1];     // {s1, s2}
+    logic [51:0] coef_rom  [0:NUM_BINS-1];     // {2cos, cos, sin, band}
+    logic [63:0] state_q;
+    logic [51:0] coef_q;
+    logic [KW-1:0] rd_addr;
+    logic          we;
+    logic [KW-1:0] wr_addr;
+    logic [63:0]   wr_data;
+
+    initial $readmemh("goertzel_coef.mem", coef_rom);
+
+    always_ff @(posedge clk) begin
+        state_q <= state_mem[rd_addr];
+        coef_q  <= coef_rom[rd_addr];
+        if (we) state_mem[wr_addr] <= wr_data;
+    end
+
+    logic signed [31:0] s1_q, s2_q;
+    logic signed [15:0] c2_q, cos_q, sin_q;
+    logic [3:0]         band_q;
+
+    assign s1_q   = state_q[63:32];
+    assign s2_q   = state_q[31:0];
+    assign c2_q   = coef_q[51:36];
+    assign cos_q  = coef_q[35:20];
+    assign sin_q  = coef_q[19:4];
+    assign band_q = coef_q[3:0];
+
+    //===========================================
+    // SHARED MULTIPLIER (registered product)
+    //===========================================
+    logic signed [15:0] mul_a;
+    logic signed [31:0] mul_b;
+    logic signed [47:0] prod;
+    logic signed [15:0] re_sat, im_sat;
+
+    always_comb begin
+        case (state)
+            ITER:    begin mul_a = c2_q;   mul_b = s1_q; end
+            F_COS:   begin mul_a = cos_q;  mul_b = s2_q; end
+            F_SIN:   begin mul_a = sin_q;  mul_b = s2_q; end
+            F_RE2:   begin mul_a = re_sat; mul_b = 32'(re_sat); end
+            F_IM2:   begin mul_a = im_sat; mul_b = 32'(im_sat); end
+            default: begin mul_a = 16'sd0; mul_b = 32'sd0; end
+        endcase
+    end
+
+    always_ff @(posedge clk) begin
+        prod <= mul_a * mul_b;
+    end
+
+    function automatic logic signed [15:0] sat16(input logic signed [31:0] v);
+        if (v > 32'sd32767)       return 16'sd32767;
+        else if (v < -32'sd32768) return -16'sd32768;
+        else                      return v[15:0];
+    endfunction
+
+    //===========================================
+    // LEVEL: log2(power) in 1/8 steps, then floor / gain
+    //===========================================
+    logic [31:0] power;
+    logic [4:0]  msb;
+    logic [2:0]  frac;
+    logic [8:0]  log2q3;
+    logic [7:0]  level;
+
+    always_comb begin
+        msb = 5'd0;
+        for (int i = 0; i < 32; i++) begin
+            if (power[i]) msb = 5'(i);
+        end
+        frac   = (msb >= 5'd3) ? 3'(power >> (msb - 5'd3)) : 3'(power << (5'd3 - msb));
+        log2q3 = (power == 32'd0) ? 9'd0 : {msb, frac};
+        if (log2q3 <= 9'(LEVEL_FLOOR))
+            level = 8'd0;
+        else if ((log2q3 - 9'(LEVEL_FLOOR)) * LEVEL_GAIN > 255)
+            level = 8'd255;
+        else
+            level = 8'((log2q3 - 9'(LEVEL_FLOOR)) * LEVEL_GAIN);
+    end
+
+    //===========================================
+    // CONTROL
+    //===========================================
+    logic [KW-1:0]      k;
+    logic signed [15:0] x_cur;
+    logic               acc_en;         // ITER pipeline: write bin k_d next cycle
+    logic [KW-1:0]      k_d;
+    logic signed [31:0] s1_d, s2_d;
+    logic [7:0]         band_max [NUM_BANDS-1:0];
+
+    assign take_sample = (state == IDLE) && sample_pending;
+
+    // Read one bin ahead in the pipelined states, else hold bin k
+    always_comb begin
+        case (state)
+            IDLE:    rd_addr = '0;
+            ITER:    rd_addr = (k == KW'(NUM_BINS - 1)) ? '0 : k + 1'b1;
+            F_LEVEL: rd_addr = (k == KW'(NUM_BINS - 1)) ? '0 : k + 1'b1;
+            default: rd_addr = k;
+        endcase
+    end
+
+    // Bin state writes: recursion result one clock after ITER, zero after finish
+    always_comb begin
+        we      = 1'b0;
+        wr_addr = k_d;
+        wr_data = {32'(x_cur) + 32'(prod >>> 14) - s2_d, s1_d};   // {s_new, s1}
+        if (acc_en) begin
+            we = 1'b1;
+        end else if (state == F_LEVEL || state == CLEAR) begin
+            we      = 1'b1;
+            wr_addr = k;
+            wr_data = 64'd0;
+        end
+    end
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            state        <= IDLE;
+            k            <= '0;
+            x_cur        <= 16'sd0;
+            acc_en       <= 1'b0;
+            k_d          <= '0;
+            s1_d         <= 32'sd0;
+            s2_d         <= 32'sd0;
+            re_sat       <= 16'sd0;
+            im_sat       <= 16'sd0;
+            power        <= 32'd0;
+            levels_valid <= 1'b0;
+            bin_valid    <= 1'b0;
+            bin_index    <= '0;
+            bin_level    <= 8'd0;
+            for (int b = 0; b < NUM_BANDS; b++) begin
+                band_max[b] <= 8'd0;
+                levels[b]   <= 8'd0;
+            end
+        end else begin
+            levels_valid <= 1'b0;
+            bin_valid    <= (state == F_LEVEL);
+            bin_index    <= k;
+            bin_level    <= level;
+            acc_en       <= (state == ITER);
+            k_d          <= k;
+            s1_d         <= s1_q;
+            s2_d         <= s2_q;
+
+            case (state)
+                IDLE: begin
+                    k <= '0;
+                    if (sample_pending) begin
+                        x_cur <= sample;
+                        state <= ITER;
+                    end else if (finish_req && !acc_en) begin
+                        for (int b = 0; b < NUM_BANDS; b++) begin
+                            band_max[b] <= 8'd0;
+                        end
+                        state <= F_COS;
+                    end else if (clear_req) begin
+                        state <= CLEAR;
+                    end
+                end
+
+                ITER: begin
+                    if (k == KW'(NUM_BINS - 1)) state <= IDLE;
+                    else                        k <= k + 1'b1;
+                end
+
+                F_COS: state <= F_SIN;
+
+                F_SIN: begin
+                    re_sat <= sat16((s1_q - 32'(prod >>> 14)) >>> SCALE_SHIFT);
+                    state  <= F_RE2;
+                end
+
+                F_RE2: begin
+                    im_sat <= sat16(32'(prod >>> 14) >>> SCALE_SHIFT);
+                    state  <= F_IM2;
+                end
+
+                F_IM2: begin
+                    power <= 32'(prod);
+                    state <= F_SUM;
+                end
+
+                F_SUM: begin
+                    power <= power + 32'(prod);
+                    state <= F_LEVEL;
+                end
+
+                F_LEVEL: begin
+                    if (level > band_max[band_q]) band_max[band_q] <= level;
+                    if (k == KW'(NUM_BINS - 1)) begin
+                        k     <= '0;
+                        state <= DONE;
+                    end else begin
+                        k     <= k + 1'b1;
+                        state <= F_COS;
+                    end
+                end
+
+                CLEAR: begin
+                    if (k == KW'(NUM_BINS - 1)) begin
+                        k     <= '0;
+                        state <= IDLE;
+                    end else begin
+                        k <= k + 1'b1;
+                    end
+                end
+
+                DONE: begin
+                    for (int b = 0; b < NUM_BANDS; b++) begin
+                        levels[b] <= band_max[b];
+                    end
+                    levels_valid <= 1'b1;
+                    state        <= IDLE;
+                end
+
+                default: state <= IDLE;
+            endcase
+        end
+    end
+
+endmodule
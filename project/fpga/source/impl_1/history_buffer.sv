@@ -0,0 +1,300 @@
+// History buffer - spectrogram history in SPRAM, dumped over a UART
+//
+// Every band frame the display loads (capture pulse) is appended to a
+// circular buffer in one SPRAM block: 2048 records of 8 words, about 65 s of
+// 32 ms FFT frames. A record is
+//
+//   [frame 15:8][frame 7:0][ms 15:8][ms 7:0][level0]...[level11]
+//
+// frame counts every capture, so captures skipped while frozen or dumping
+// show up as gaps; ms is a free running millisecond counter (wraps at 65 s).
+//
+// Command frame (type 0x06): [0x06][seq][cmd][count 15:8][count 7:0]
+//   cmd 0: dump the newest count records (0 = everything recorded), oldest
+//          first. Recording pauses for the dump so it is one consistent
+//          snapshot (0.33 s for a full buffer at 1 Mbaud).
+//   cmd 1: freeze (post-mortem: keep what led up to a fault)
+//   cmd 2: resume recording
+// Commands that arrive during a dump are ignored.
+//
+// Dump on tx, 8N1 at 48 MHz / CLKS_PER_BIT:
+//   [0xA5][0x5A][count 15:8][count 7:0][12] records... [sum of record bytes]
+// sim/history_decode.c reads it back (CSV or a text waterfall).
+module history_buffer #(
+    parameter int CLKS_PER_BIT = 48,        // 1 Mbaud
+    parameter int MS_CYCLES    = 48000
+) (
+    input  logic       clk,
+    input  logic       reset,
+    // Band frames
+    input  logic       capture,
+    input  logic [7:0] levels [11:0],
+    // SPI byte stream (spi_frame_rx)
+    input  logic       byte_valid,
+    input  logic [7:0] byte_data,
+    input  logic [5:0] byte_index,
+    input  logic [7:0] frame_type,
+    input  logic       frame_end,
+    input  logic [5:0] frame_len,
+    // Readback
+    output logic       tx,
+    output logic       frozen
+);
+    localparam [7:0] TYPE_HISTORY = 8'h06;
+    localparam [5:0] CMD_LEN      = 6'd5;
+    localparam int   RECORDS      = 2048;
+    localparam int   RW           = $clog2(RECORDS);
+    localparam int   MW           = $clog2(MS_CYCLES);
+
+    typedef enum logic [2:0] {
+        D_IDLE,
+        D_HEADER,
+        D_FETCH,        // SPRAM read issued when the port is free
+        D_CATCH,        // read data out of the SPRAM
+        D_DATA,         // word high byte, then low byte
+        D_TRAILER
+    } dump_state_t;
+
+    dump_state_t dump_state;
+
+    //===========================================
+    // TIMESTAMP + FRAME COUNT
+    //===========================================
+    logic [MW-1:0] ms_timer;
+    logic [15:0]   ms_count;
+    logic [15:0]   frame_count;
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            ms_timer <= '0;
+            ms_count <= 16'd0;
+        end else if (ms_timer == MW'(MS_CYCLES - 1)) begin
+            ms_timer <= '0;
+            ms_count <= ms_count + 16'd1;
+        end else begin
+            ms_timer <= ms_timer + 1'b1;
+        end
+    end
+
+    //===========================================
+    // WRITER: record into 8 word registers, then 8 SPRAM writes
+    //===========================================
+    logic [15:0]   rec [7:0];
+    logic          wr_active;
+    logic [2:0]    wr_word;
+    logic [RW-1:0] wr_ptr;
+    logic [RW:0]   filled;
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            frame_count <= 16'd0;
+            wr_active   <= 1'b0;
+            wr_word     <= 3'd0;
+            wr_ptr      <= '0;
+            filled      <= '0;
+            for (int w = 0; w < 8; w++) begin
+                rec[w] <= 16'd0;
+            end
+        end else begin
+            if (capture) frame_count <= frame_count + 16'd1;
+
+            if (wr_active) begin
+                wr_word <= wr_word + 3'd1;
+                if (wr_word == 3'd7) begin
+                    wr_active <= 1'b0;
+                    wr_ptr    <= wr_ptr + 1'b1;
+                    if (filled != (RW+1)'(RECORDS)) filled <= filled + 1'b1;
+                end
+            end else if (capture && !frozen && dump_state == D_IDLE) begin
+                rec[0] <= frame_count;
+                rec[1] <= ms_count;
+                for (int w = 0; w < 6; w++) begin
+                    rec[2 + w] <= {levels[2*w], levels[2*w + 1]};
+                end
+                wr_word   <= 3'd0;
+                wr_active <= 1'b1;
+            end
+        end
+    end
+
+    //===========================================
+    // SPRAM: writer has the port, the dumper reads in between
+    //===========================================
+    logic [RW-1:0] rd_rec;
+    logic [2:0]    rd_word;
+    logic [13:0]   ram_addr;
+    logic [15:0]   ram_rdata;
+
+    assign ram_addr = wr_active ? {wr_ptr, wr_word} : {rd_rec, rd_word};
+
+    spram_16k history_ram (
+        .clk(clk),
+        .addr(ram_addr),
+        .wdata(rec[wr_word]),
+        .we(wr_active),
+        .rdata(ram_rdata)
+    );
+
+    //===========================================
+    // COMMAND FRAME
+    //===========================================
+    logic [7:0]  cmd_shadow;
+    logic [15:0] count_shadow;
+    logic        dump_req;
+    logic [15:0] dump_count;
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            cmd_shadow   <= 8'd0;
+            count_shadow <= 16'd0;
+            dump_req     <= 1'b0;
+            dump_count   <= 16'd0;
+            frozen       <= 1'b0;
+        end else begin
+            if (dump_state != D_IDLE) dump_req <= 1'b0;
+
+            if (byte_valid && frame_type == TYPE_HISTORY) begin
+                case (byte_index)
+                    6'd2:    cmd_shadow          <= byte_data;
+                    6'd3:    count_shadow[15:8]  <= byte_data;
+                    6'd4:    count_shadow[7:0]   <= byte_data;
+                    default: ;
+                endcase
+            end
+
+            if (frame_end && frame_type == TYPE_HISTORY && frame_len == CMD_LEN) begin
+                case (cmd_shadow)
+                    8'd0: begin
+                        dump_req   <= 1'b1;
+                        dump_count <= count_shadow;
+                    end
+                    8'd1:    frozen <= 1'b1;
+                    8'd2:    frozen <= 1'b0;
+                    default: ;
+                endcase
+            end
+        end
+    end
+
+    //===========================================
+    // DUMPER
+    //===========================================
+    logic          tx_start;
+    logic [7:0]    tx_data;
+    logic          tx_busy;
+    logic          tx_ready;
+    logic [2:0]    hdr_index;
+    logic [RW:0]   rec_left;
+    logic [RW:0]   dump_n;
+    logic [15:0]   word;
+    logic          low_byte;
+    logic [7:0]    sum;
+
+    // One byte at a time: the UART takes start only while idle, and busy
+    // only rises the clock after
+    assign tx_ready = !tx_busy && !tx_start;
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            dump_state <= D_IDLE;
+            tx_start   <= 1'b0;
+            tx_data    <= 8'd0;
+            hdr_index  <= 3'd0;
+            rec_left   <= '0;
+            dump_n     <= '0;
+            rd_rec     <= '0;
+            rd_word    <= 3'd0;
+            word       <= 16'd0;
+            low_byte   <= 1'b0;
+            sum        <= 8'd0;
+        end else begin
+            tx_start <= 1'b0;
+
+            case (dump_state)
+                D_IDLE: begin
+                    // Wait for a record in flight to land
+                    if (dump_req && !wr_active) begin
+                        if (dump_count == 16'd0 || 32'(dump_count) > 32'(filled))
+                            dump_n <= filled;
+                        else
+                            dump_n <= (RW+1)'(dump_count);
+                        hdr_index  <= 3'd0;
+                        sum        <= 8'd0;
+                        dump_state <= D_HEADER;
+                    end
+                end
+
+                D_HEADER: begin
+                    if (tx_ready) begin
+                        tx_start <= 1'b1;
+                        case (hdr_index)
+                            3'd0:    tx_data <= 8'hA5;
+                            3'd1:    tx_data <= 8'h5A;
+                            3'd2:    tx_data <= 8'(16'(dump_n) >> 8);
+                            3'd3:    tx_data <= 8'(dump_n);
+                            default: tx_data <= 8'd12;
+                        endcase
+                        hdr_index <= hdr_index + 3'd1;
+                        if (hdr_index == 3'd4) begin
+                            rec_left   <= dump_n;
+                            rd_rec     <= wr_ptr - RW'(dump_n);   // oldest wanted
+                            rd_word    <= 3'd0;
+                            dump_state <= (dump_n == '0) ? D_TRAILER : D_FETCH;
+                        end
+                    end
+                end
+
+                D_FETCH: begin
+                    if (!wr_active) dump_state <= D_CATCH;
+                end
+
+                D_CATCH: begin
+                    word       <= ram_rdata;
+                    low_byte   <= 1'b0;
+                    dump_state <= D_DATA;
+                end
+
+                D_DATA: begin
+                    if (tx_ready) begin
+                        tx_start <= 1'b1;
+                        tx_data  <= low_byte ? word[7:0] : word[15:8];
+                        sum      <= sum + (low_byte ? word[7:0] : word[15:8]);
+                        low_byte <= 1'b1;
+                        if (low_byte) begin
+                            rd_word <= rd_word + 3'd1;
+                            if (rd_word == 3'd7) begin
+                                rd_rec   <= rd_rec + 1'b1;
+                                rec_left <= rec_left - 1'b1;
+                                dump_state <= (rec_left == (RW+1)'(1)) ? D_TRAILER : D_FETCH;
+                            end else begin
+                                dump_state <= D_FETCH;
+                            end
+                        end
+                    end
+                end
+
+                D_TRAILER: begin
+                    if (tx_ready) begin
+                        tx_start   <= 1'b1;
+                        tx_data    <= sum;
+                        dump_state <= D_IDLE;
+                    end
+                end
+
+                default: dump_state <= D_IDLE;
+            endcase
+        end
+    end
+
+    uart_tx #(
+        .CLKS_PER_BIT(CLKS_PER_BIT)
+    ) dump_uart (
+        .clk(clk),
+        .reset(reset),
+        .start(tx_start),
+        .data(tx_data),
+        .busy(tx_busy),
+        .tx(tx)
+    );
+
+endmodule
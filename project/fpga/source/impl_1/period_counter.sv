@@ -0,0 +1,62 @@
+// Period counter - reciprocal frequency measurement
+//
+// Counts clock cycles across N_EDGES input edges. The edge that ends one
+// measurement starts the next, so a new period comes out every N_EDGES
+// input periods with +-1 cycle of error regardless of frequency (constant
+// relative precision, unlike gating edges in a fixed window).
+module period_counter #(
+    parameter int N_EDGES = 4,
+    parameter int WIDTH   = 23,
+    parameter logic [WIDTH-1:0] TIMEOUT = '1   // no edges for this long = no signal
+) (
+    input  logic             clk,
+    input  logic             reset,
+    input  logic             edge_in,     // 1 cycle pulse per input edge
+    output logic             valid,       // 1 cycle pulse, period updated
+    output logic [WIDTH-1:0] period,      // cycles across N_EDGES edges
+    output logic             timeout      // 1 cycle pulse, signal lost
+);
+    logic [WIDTH-1:0] cycles;
+    logic [$clog2(N_EDGES+1)-1:0] edges;
+    logic armed;
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            cycles  <= '0;
+            edges   <= '0;
+            armed   <= 1'b0;
+            valid   <= 1'b0;
+            timeout <= 1'b0;
+            period  <= '0;
+        end else begin
+            valid   <= 1'b0;
+            timeout <= 1'b0;
+
+            if (edge_in) begin
+                armed <= 1'b1;
+                if (!armed) begin
+                    // First edge only starts the count, no period before it
+                    cycles <= '0;
+                    edges  <= '0;
+                end else if (edges == N_EDGES - 1) begin
+                    // This edge ends one measurement and starts the next
+                    period <= cycles + 1'b1;
+                    valid  <= 1'b1;
+                    cycles <= '0;
+                    edges  <= '0;
+                end else begin
+                    cycles <= cycles + 1'b1;
+                    edges  <= edges + 1'b1;
+                end
+            end else if (armed) begin
+                if (cycles >= TIMEOUT) begin
+                    armed   <= 1'b0;
+                    timeout <= 1'b1;
+                end else begin
+                    cycles <= cycles + 1'b1;
+                end
+            end
+        end
+    end
+
+endmodule
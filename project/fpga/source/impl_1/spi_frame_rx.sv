@@ -0,0 +1,143 @@
+// SPI frame receiver - mode 0 slave, MSB first, oversampled by the system clock
+//
+// Frame = one cs_n low period: [type][seq][payload...]. LEVELS frames
+// (type 0x01, 12 payload bytes) are decoded here: the levels are shadowed
+// while the frame comes in and copied to the outputs in one clock when cs_n
+// goes high with the right byte count, so the display never sees half a
+// frame. Every other frame type is handled by its consumer from the byte
+// stream (byte_*) and frame_end, with the same commit-on-end rule.
+module spi_frame_rx (
+    input  logic       clk,
+    input  logic       reset,
+    input  logic       sck,
+    input  logic       sdi,
+    input  logic       cs_n,
+    output logic       frame_valid,        // 1 cycle pulse, levels/seq updated
+    output logic [7:0] seq,
+    output logic [7:0] levels [11:0],
+    // Raw byte stream for other frame types
+    output logic       byte_valid,         // 1 cycle pulse per received byte
+    output logic [7:0] byte_data,
+    output logic [5:0] byte_index,         // 0 = type, 1 = seq, 2.. = payload
+    output logic [7:0] frame_type,
+    output logic       frame_end,          // 1 cycle pulse, cs_n high on a byte boundary
+    output logic [5:0] frame_len           // bytes in the frame, saturates at 63
+);
+    localparam [7:0] TYPE_LEVELS = 8'h01;
+    localparam [5:0] LEVELS_LEN  = 6'd14;  // type + seq + 12 levels
+
+    logic sck_sync, sdi_sync, cs_n_sync;
+    logic sck_prev, cs_n_prev;
+    logic sck_rise, cs_rise, cs_fall;
+
+    logic [2:0] bit_count;
+    logic [5:0] byte_count;
+    logic [7:0] shift;
+    logic [7:0] byte_in;
+    logic       byte_done;
+
+    logic [7:0] seq_shadow;
+    logic [7:0] shadow [11:0];
+
+    synchronizer sck_synchronizer (
+        .clk(clk), .reset(reset), .async_in(sck), .sync_out(sck_sync)
+    );
+    synchronizer sdi_synchronizer (
+        .clk(clk), .reset(reset), .async_in(sdi), .sync_out(sdi_sync)
+    );
+    synchronizer cs_synchronizer (
+        .clk(clk), .reset(reset), .async_in(cs_n), .sync_out(cs_n_sync)
+    );
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            sck_prev  <= 1'b0;
+            cs_n_prev <= 1'b1;
+        end else begin
+            sck_prev  <= sck_sync;
+            cs_n_prev <= cs_n_sync;
+        end
+    end
+
+    assign sck_rise = sck_sync & ~sck_prev;
+    assign cs_fall  = ~cs_n_sync & cs_n_prev;
+    assign cs_rise  = cs_n_sync & ~cs_n_prev;
+
+    //===========================================
+    // BIT SHIFTER: sample SDI on SCK rising edge (mode 0)
+    // sdi and sck go through the same synchronizer depth, so the bit is
+    // still stable when the delayed edge shows up
+    //===========================================
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            bit_count <= 3'd0;
+            shift     <= 8'd0;
+            byte_in   <= 8'd0;
+            byte_done <= 1'b0;
+        end else begin
+            byte_done <= 1'b0;
+            if (cs_fall) begin
+                bit_count <= 3'd0;
+            end else if (sck_rise && !cs_n_sync) begin
+                shift     <= {shift[6:0], sdi_sync};
+                bit_count <= bit_count + 3'd1;
+                if (bit_count == 3'd7) begin
+                    byte_in   <= {shift[6:0], sdi_sync};
+                    byte_done <= 1'b1;
+                end
+            end
+        end
+    end
+
+    //===========================================
+    // BYTE SORTER: header, then levels into the shadow copy
+    //===========================================
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            byte_count <= 6'd0;
+            frame_type <= 8'd0;
+            seq_shadow <= 8'd0;
+            for (int i = 0; i < 12; i++) begin
+                shadow[i] <= 8'd0;
+            end
+        end else if (cs_fall) begin
+            byte_count <= 6'd0;
+        end else if (byte_done) begin
+            if (byte_count != 6'd63) byte_count <= byte_count + 6'd1;
+            case (byte_count)
+                6'd0:    frame_type <= byte_in;
+                6'd1:    seq_shadow <= byte_in;
+                default: if (byte_count < LEVELS_LEN) shadow[byte_count - 6'd2] <= byte_in;
+            endcase
+        end
+    end
+
+    assign byte_valid = byte_done;
+    assign byte_data  = byte_in;
+    assign byte_index = byte_count;
+    assign frame_end  = cs_rise && bit_count == 3'd0;
+    assign frame_len  = byte_count;
+
+    //===========================================
+    // COMMIT: whole frame or nothing
+    //===========================================
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            frame_valid <= 1'b0;
+            seq         <= 8'd0;
+            for (int i = 0; i < 12; i++) begin
+                levels[i] <= 8'd0;
+            end
+        end else begin
+            frame_valid <= 1'b0;
+            if (frame_end && frame_type == TYPE_LEVELS && frame_len == LEVELS_LEN) begin
+                frame_valid <= 1'b1;
+                seq         <= seq_shadow;
+                for (int i = 0; i < 12; i++) begin
+                    levels[i] <= shadow[i];
+                end
+            end
+        end
+    end
+
+endmodule
@@ -0,0 +1,26 @@
+// SPRAM 16K x 16 - one of the iCE40UP5K's four 256 kbit single port RAMs
+//
+// Thin wrapper around the SP256K hard block so the rest of the design (and
+// sim/SP256K.sv) only sees a plain synchronous RAM: address and write data
+// on one clock, read data registered out on the next. One port, so a write
+// and a read can not happen in the same clock.
+module spram_16k (
+    input  logic        clk,
+    input  logic [13:0] addr,
+    input  logic [15:0] wdata,
+    input  logic        we,
+    output logic [15:0] rdata
+);
+    SP256K ram (
+        .AD(addr),
+        .DI(wdata),
+        .MASKWE(4'b1111),
+        .WE(we),
+        .CS(1'b1),
+        .CK(clk),
+        .STDBY(1'b0),
+        .SLEEP(1'b0),
+        .PWROFF_N(1'b1),
+        .DO(rdata)
+    );
+endmodule
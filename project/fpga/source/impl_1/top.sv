@@ -1,21 +1,79 @@
 
 // Main module - Spectrum analyzer with smooth persistence/fading
-module top(
+//
+// Inputs from the MCU:
+//   - SPI band frames (sck/sdi/cs_n): all 12 levels per frame, loaded
+//     straight into the brightness array (<1 ms from frame to LEDs)
+//   - SPI sample frames: raw ADC samples, the Goertzel bank (SPECTRUM_ENGINE)
+//     makes the 12 levels on the FPGA so the MCU does no spectral work
+//   - SPI voice frames: note frequency words for the DDS interrupter, which
+//     drives coil_out (dds_voices.sv)
+//   - SPI bar frames / Goertzel bins: STRIP_BANDS band spectrum for a
+//     WS2812 chain on strip_out (ws2812_bars.sv, LED_STRIP)
+//   - SPI history commands: every band frame loaded from SPI or the
+//     Goertzel bank is kept in SPRAM and dumped on hist_tx on request
+//     (history_buffer.sv, HISTORY)
+//   - square wave: the old single-frequency encoding. Only used while no SPI
+//     frame has arrived for SPI_TIMEOUT_CYCLES, so older MCU firmware still
+//     drives the display. COUNTER_MODE picks how it is measured:
+//       COUNTER_GATED      edges counted over a 100 ms window
+//       COUNTER_RECIPROCAL 48 MHz cycles across N_EDGES edges, a new reading
+//                          every few input periods (4 ms at 1 kHz)
+module top #(
+    parameter int COUNTER_MODE = 1,   // 0 = gated, 1 = reciprocal
+    parameter int N_EDGES      = 4,
+    parameter bit SPECTRUM_ENGINE = 1'b1,
+    parameter bit LED_STRIP    = 1'b1,
+    parameter int STRIP_BANDS  = 64,  // 64 x 8 = 512 LEDs, 63.9 fps
+    parameter int STRIP_HEIGHT = 8,
+    parameter bit HISTORY      = 1'b1
+) (
     input  logic reset_in,    // Active LOW (pressed = 0)
     input  logic square,
-    output logic [11:0] led
+    input  logic sck,
+    input  logic sdi,
+    input  logic cs_n,
+    output logic [11:0] led,
+    output logic coil_out,
+    output logic strip_out,
+    output logic hist_tx
 );
     logic int_osc;
     logic reset;
     
     assign reset = ~reset_in;
     
+    localparam int COUNTER_GATED      = 0;
+    localparam int COUNTER_RECIPROCAL = 1;
+    
     // 100ms window at 48 MHz
     localparam [25:0] WINDOW_CYCLES = 26'd4_800_000;
     
-    // PWM and fade timing
-    localparam [11:0] PWM_PERIOD = 12'd2400;       // 20kHz PWM (48MHz / 2400)
-    localparam [22:0] FADE_PERIOD = 23'd375_000;   // ~7.8ms per fade step (2 seconds / 256 steps)
+    // Reset bucket edges in Hz (bucket k = input above BUCKET_HZ[k-1]). The
+    // MCU can replace the whole table at run time (SPI frame 0x02, see
+    // bucket_table.sv). Gated mode compares edge counts per 100 ms window
+    // (Hz / 10), reciprocal mode compares the period of N_EDGES edges, so its
+    // table is the reciprocal PERIOD_REF / Hz - no divider in the fabric.
+    localparam int NUM_BUCKETS = 12;
+    localparam int BUCKET_HZ [11] = '{170, 340, 510, 680, 840, 1010,
+                                       1180, 1350, 1510, 1680, 1850};
+    localparam longint PERIOD_REF = 48_000_000 * N_EDGES;
+    
+    function automatic logic [(NUM_BUCKETS-1)*23-1:0] default_thresholds();
+        logic [(NUM_BUCKETS-1)*23-1:0] t;
+        for (int k = 0; k < NUM_BUCKETS - 1; k++) begin
+            if (COUNTER_MODE == COUNTER_RECIPROCAL) t[k*23 +: 23] = 23'(PERIOD_REF / BUCKET_HZ[k]);
+            else                                    t[k*23 +: 23] = 23'(BUCKET_HZ[k] / 10);
+        end
+        return t;
+    endfunction
+    
+    // Fade timing: each step takes 1/16 of the level (+1), ~73 steps from
+    // full to off
+    localparam [22:0] FADE_PERIOD = 23'd1_315_000; // ~27ms per fade step (2 seconds / 73 steps)
+    
+    // Fall back to the square wave after 250ms without a good SPI frame
+    localparam [23:0] SPI_TIMEOUT_CYCLES = 24'd12_000_000;
     
     // State machine
     typedef enum logic [1:0] {
@@ -26,48 +84,234 @@ module top(
     state_t state;
     
     logic [25:0] timer;
-    logic [7:0] edge_count;
-    logic [7:0] edge_count_latched;
+    logic [11:0] edge_count;          // 12 bits: no wrap below 40 kHz
+    logic [11:0] edge_count_latched;
     logic [3:0] bucket;
-    logic [3:0] bucket_display;
     
-    logic square_sync, square_prev, square_edge;
+    // Reciprocal counter
+    logic        period_valid;
+    logic        period_timeout;
+    logic [22:0] period;
+    logic [22:0] period_latched;
     
-    // Brightness array - one 8-bit brightness value per bucket (0-255)
-    logic [7:0] brightness [11:0];
+    // sample_done: new measurement latching, measure_ready: latched value
+    // valid, display_strobe: bucket out of the table for that measurement
+    logic        sample_done;
+    logic        measure_ready;
+    logic        display_strobe;
+    logic [22:0] measurement;
     
-    // PWM counter for brightness control
-    logic [7:0] pwm_counter;
-    logic [11:0] pwm_timer;
+    // SPI byte stream for the bucket table
+    logic       rx_byte_valid;
+    logic [7:0] rx_byte_data;
+    logic [5:0] rx_byte_index;
+    logic [7:0] rx_frame_type;
+    logic       rx_frame_end;
+    logic [5:0] rx_frame_len;
+    
+    logic square_clean, square_edge;
+    
+    // Brightness array - one 10-bit perceptual level per bucket (0-1023).
+    // The 8 bit levels from SPI / Goertzel are widened on load; the extra
+    // bits let the fade pass through 4x finer steps near the dark end.
+    logic [9:0] brightness [11:0];
+    
+    // Gamma corrected 12 bit duty per LED, refreshed round robin from the
+    // LUT (one EBR read per cycle, each LED every 12 cycles)
+    logic [3:0]  gamma_index;
+    logic [3:0]  gamma_index_d;
+    logic [11:0] gamma_out;
+    logic [11:0] duty [11:0];
+    
+    // Sigma-delta accumulators
+    logic [11:0] sd_acc [11:0];
     
     // Fade timer
     logic [22:0] fade_timer;
     
+    // SPI band link
+    logic       frame_valid;
+    logic [7:0] frame_seq;
+    logic [7:0] spi_levels [11:0];
+    logic [23:0] spi_timer;
+    
+    // On-FPGA spectrum (Goertzel bank)
+    logic       gz_valid;
+    logic [7:0] gz_levels [11:0];
+    logic       gz_bin_valid;
+    logic [6:0] gz_bin_index;
+    logic [7:0] gz_bin_level;
+    logic       spi_active;
+    
     HSOSC #(.CLKHF_DIV("0b00")) hf_osc (
         .CLKHFPU(1'b1),
         .CLKHFEN(1'b1),
         .CLKHF(int_osc)
     );
     
-    // Synchronize square wave input
-    synchronizer square_synchronizer (
+    // Square wave input: synchronize, drop anything shorter than 0.5 us
+    // (ringing on the line), falling edge pulse. The front end takes more
+    // channels and can timestamp edges, the display only needs one.
+    capture_frontend #(
+        .N_CH(1),
+        .MIN_PULSE(24),
+        .FIFO_DEPTH(0)
+    ) square_capture (
         .clk(int_osc),
         .reset(reset),
         .async_in(square),
-        .sync_out(square_sync)
+        .level(square_clean),
+        .fall(square_edge),
+        .rd_en(1'b0),
+        .empty(),
+        .rd_channel(),
+        .rd_timestamp(),
+        .overflow()
+    );
+    
+    //===========================================
+    // SPI BAND LINK
+    //===========================================
+    spi_frame_rx band_rx (
+        .clk(int_osc),
+        .reset(reset),
+        .sck(sck),
+        .sdi(sdi),
+        .cs_n(cs_n),
+        .frame_valid(frame_valid),
+        .seq(frame_seq),
+        .levels(spi_levels),
+        .byte_valid(rx_byte_valid),
+        .byte_data(rx_byte_data),
+        .byte_index(rx_byte_index),
+        .frame_type(rx_frame_type),
+        .frame_end(rx_frame_end),
+        .frame_len(rx_frame_len)
     );
     
-    // Edge detection on square wave
+    //===========================================
+    // SPECTRUM ENGINE: sample frames -> band levels
+    //===========================================
+    generate
+        if (SPECTRUM_ENGINE) begin : gen_spectrum
+            goertzel_bank spectrum (
+                .clk(int_osc),
+                .reset(reset),
+                .byte_valid(rx_byte_valid),
+                .byte_data(rx_byte_data),
+                .byte_index(rx_byte_index),
+                .frame_type(rx_frame_type),
+                .frame_end(rx_frame_end),
+                .levels_valid(gz_valid),
+                .levels(gz_levels),
+                .bin_valid(gz_bin_valid),
+                .bin_index(gz_bin_index),
+                .bin_level(gz_bin_level)
+            );
+        end else begin : gen_no_spectrum
+            assign gz_valid = 1'b0;
+            assign gz_bin_valid = 1'b0;
+            assign gz_bin_index = 7'd0;
+            assign gz_bin_level = 8'd0;
+            always_comb begin
+                for (int i = 0; i < 12; i++) gz_levels[i] = 8'd0;
+            end
+        end
+    endgenerate
+    
+    //===========================================
+    // COIL INTERRUPTER: DDS voices
+    //===========================================
+    dds_voices #(
+        .NUM_VOICES(4)
+    ) interrupter (
+        .clk(int_osc),
+        .reset(reset),
+        .byte_valid(rx_byte_valid),
+        .byte_data(rx_byte_data),
+        .byte_index(rx_byte_index),
+        .frame_type(rx_frame_type),
+        .frame_end(rx_frame_end),
+        .frame_len(rx_frame_len),
+        .coil_out(coil_out),
+        .voice_on()
+    );
+    
+    //===========================================
+    // LED STRIP: WS2812 bar graph
+    //===========================================
+    generate
+        if (LED_STRIP) begin : gen_strip
+            ws2812_bars #(
+                .NUM_BANDS(STRIP_BANDS),
+                .BAR_HEIGHT(STRIP_HEIGHT)
+            ) strip (
+                .clk(int_osc),
+                .reset(reset),
+                .byte_valid(rx_byte_valid),
+                .byte_data(rx_byte_data),
+                .byte_index(rx_byte_index),
+                .frame_type(rx_frame_type),
+                .frame_end(rx_frame_end),
+                .bin_valid(gz_bin_valid),
+                .bin_index(gz_bin_index),
+                .bin_level(gz_bin_level),
+                .bins_done(gz_valid),
+                .dout(strip_out),
+                .frame_start()
+            );
+        end else begin : gen_no_strip
+            assign strip_out = 1'b0;
+        end
+    endgenerate
+    
+    //===========================================
+    // SPECTROGRAM HISTORY: band frames into SPRAM, UART readback
+    //===========================================
+    generate
+        if (HISTORY) begin : gen_history
+            logic [7:0] hist_levels [11:0];
+            
+            always_comb begin
+                for (int i = 0; i < 12; i++) begin
+                    hist_levels[i] = frame_valid ? spi_levels[i] : gz_levels[i];
+                end
+            end
+            
+            history_buffer history (
+                .clk(int_osc),
+                .reset(reset),
+                .capture(frame_valid || gz_valid),
+                .levels(hist_levels),
+                .byte_valid(rx_byte_valid),
+                .byte_data(rx_byte_data),
+                .byte_index(rx_byte_index),
+                .frame_type(rx_frame_type),
+                .frame_end(rx_frame_end),
+                .frame_len(rx_frame_len),
+                .tx(hist_tx),
+                .frozen()
+            );
+        end else begin : gen_no_history
+            assign hist_tx = 1'b1;
+        end
+    endgenerate
+    
+    // spi_active while frames keep coming
     always_ff @(posedge int_osc, posedge reset) begin
         if (reset) begin
-            square_prev <= 1'b0;
+            spi_timer <= 24'd0;
+            spi_active <= 1'b0;
+        end else if (frame_valid || gz_valid) begin
+            spi_timer <= 24'd0;
+            spi_active <= 1'b1;
+        end else if (spi_timer >= SPI_TIMEOUT_CYCLES - 1) begin
+            spi_active <= 1'b0;
         end else begin
-            square_prev <= square_sync;
+            spi_timer <= spi_timer + 24'd1;
         end
     end
     
-    assign square_edge = ~square_sync & square_prev;  // FALLING edge
-    
     //===========================================
     // STATE MACHINE
     //===========================================
@@ -115,17 +359,17 @@ module top(
     //===========================================
     always_ff @(posedge int_osc, posedge reset) begin
         if (reset) begin
-            edge_count <= 8'd0;
+            edge_count <= 12'd0;
         end else begin
             case (state)
                 COLLECTING: begin
-                    if (square_edge) begin
-                        edge_count <= edge_count + 8'd1;
+                    if (square_edge && edge_count != 12'hFFF) begin
+                        edge_count <= edge_count + 12'd1;
                     end
                 end
                 
                 LATCHING: begin
-                    edge_count <= 8'd0;  // Reset for next window
+                    edge_count <= 12'd0;  // Reset for next window
                 end
             endcase
         end
@@ -136,52 +380,88 @@ module top(
     //===========================================
     always_ff @(posedge int_osc, posedge reset) begin
         if (reset) begin
-            edge_count_latched <= 8'd0;
+            edge_count_latched <= 12'd0;
         end else if (state == LATCHING) begin
             edge_count_latched <= edge_count;
         end
     end
     
     //===========================================
-    // BUCKET DETERMINATION (Combinational)
-    //===========================================
-    always_comb begin
-        bucket = 4'd0;
-        
-        if (edge_count_latched > 8'd184)       bucket = 4'd11;
-        else if (edge_count_latched > 8'd167)  bucket = 4'd10;
-        else if (edge_count_latched > 8'd150)  bucket = 4'd9;
-        else if (edge_count_latched > 8'd134)  bucket = 4'd8;
-        else if (edge_count_latched > 8'd117)  bucket = 4'd7;
-        else if (edge_count_latched > 8'd100)  bucket = 4'd6;
-        else if (edge_count_latched > 8'd83)   bucket = 4'd5;
-        else if (edge_count_latched > 8'd67)   bucket = 4'd4;
-        else if (edge_count_latched > 8'd50)   bucket = 4'd3;
-        else if (edge_count_latched > 8'd33)   bucket = 4'd2;
-        else if (edge_count_latched > 8'd16)   bucket = 4'd1;
-        else                                   bucket = 4'd0;
+    // DATAPATH: Reciprocal Counter
+    //===========================================
+    period_counter #(
+        .N_EDGES(N_EDGES),
+        .WIDTH(23),
+        .TIMEOUT(23'(WINDOW_CYCLES))   // below ~40 Hz at N_EDGES = 4
+    ) reciprocal_counter (
+        .clk(int_osc),
+        .reset(reset),
+        .edge_in(square_edge),
+        .valid(period_valid),
+        .period(period),
+        .timeout(period_timeout)
+    );
+    
+    always_ff @(posedge int_osc, posedge reset) begin
+        if (reset) begin
+            period_latched <= '1;
+        end else if (period_valid) begin
+            period_latched <= period;
+        end else if (period_timeout) begin
+            period_latched <= '1;     // no signal = longest period = bucket 0
+        end
     end
     
-    //===========================================
-    // LATCH BUCKET FOR DISPLAY
-    //===========================================
+    assign sample_done = (COUNTER_MODE == COUNTER_RECIPROCAL) ? period_valid
+                                                              : (state == LATCHING);
+    
     always_ff @(posedge int_osc, posedge reset) begin
         if (reset) begin
-            bucket_display <= 4'd0;
-        end else if (state == LATCHING) begin
-            bucket_display <= bucket;
+            measure_ready <= 1'b0;
+        end else begin
+            measure_ready <= sample_done;
         end
     end
     
+    assign measurement = (COUNTER_MODE == COUNTER_RECIPROCAL) ? period_latched
+                                                              : 23'(edge_count_latched);
+    
+    //===========================================
+    // BUCKET DETERMINATION (programmable table)
+    // Parallel compare + popcount, bucket two cycles after measure_ready
+    //===========================================
+    bucket_table #(
+        .NUM_BUCKETS(NUM_BUCKETS),
+        .WIDTH(23),
+        .INVERT(COUNTER_MODE == COUNTER_RECIPROCAL),
+        .DEFAULTS(default_thresholds())
+    ) thresholds (
+        .clk(int_osc),
+        .reset(reset),
+        .in_valid(measure_ready),
+        .value(measurement),
+        .out_valid(display_strobe),
+        .bucket(bucket),
+        .byte_valid(rx_byte_valid),
+        .byte_data(rx_byte_data),
+        .byte_index(rx_byte_index),
+        .frame_type(rx_frame_type),
+        .frame_end(rx_frame_end),
+        .frame_len(rx_frame_len)
+    );
+    
     //===========================================
     // BRIGHTNESS MANAGEMENT + FADE TIMER (Combined)
-    // Fade over 2 seconds: 256 steps × 7.8ms = 2 seconds
+    // Exponential fade over ~2 seconds: 73 steps × 27ms (10 bit levels)
+    // An SPI frame replaces all 12 values in the same cycle and wins over
+    // both the square wave bucket and the fade. The fade keeps running so
+    // the display dies away if the MCU stops sending.
     //===========================================
     always_ff @(posedge int_osc, posedge reset) begin
         if (reset) begin
             fade_timer <= 23'd0;
             for (int i = 0; i < 12; i++) begin
-                brightness[i] <= 8'd0;
+                brightness[i] <= 10'd0;
             end
         end else begin
             // Update fade timer
@@ -191,18 +471,29 @@ module top(
                 fade_timer <= fade_timer + 23'd1;
             end
             
-            // Priority 1: Set active bucket to full brightness (happens in LATCHING state)
-            if (state == LATCHING) begin
-                brightness[bucket_display] <= 8'd255;
+            // Priority 1: SPI frame (or a finished Goertzel block) loads every bucket at once
+            if (frame_valid) begin
+                for (int i = 0; i < 12; i++) begin
+                    brightness[i] <= {spi_levels[i], spi_levels[i][7:6]};
+                end
+            end else if (gz_valid) begin
+                for (int i = 0; i < 12; i++) begin
+                    brightness[i] <= {gz_levels[i], gz_levels[i][7:6]};
+                end
+            end
+            
+            // Priority 2: Set active bucket to full brightness (new measurement)
+            else if (display_strobe && !spi_active) begin
+                brightness[bucket] <= 10'd1023;
             end
             
-            // Priority 2: Fade all buckets (happens every FADE_PERIOD)
-            if (fade_timer >= FADE_PERIOD - 1) begin
+            // Priority 3: Fade all buckets (happens every FADE_PERIOD)
+            if (!frame_valid && !gz_valid && fade_timer >= FADE_PERIOD - 1) begin
                 for (int i = 0; i < 12; i++) begin
                     // Don't fade the bucket we just set to full brightness
-                    if (!(state == LATCHING && i == bucket_display)) begin
-                        if (brightness[i] > 8'd0) begin
-                            brightness[i] <= brightness[i] - 8'd1;
+                    if (!(display_strobe && !spi_active && i == bucket)) begin
+                        if (brightness[i] > 10'd0) begin
+                            brightness[i] <= brightness[i] - ((brightness[i] >> 4) + 10'd1);
                         end
                     end
                 end
@@ -211,34 +502,45 @@ module top(
     end
     
     //===========================================
-    // PWM COUNTER - Runs at 20kHz (imperceptible flicker)
+    // GAMMA: brightness (perceptual, 10 bit) -> duty (linear, 12 bit)
     //===========================================
+    gamma_lut gamma (
+        .clk(int_osc),
+        .addr(brightness[gamma_index]),
+        .data(gamma_out)
+    );
+    
     always_ff @(posedge int_osc, posedge reset) begin
         if (reset) begin
-            pwm_timer <= 12'd0;
-            pwm_counter <= 8'd0;
-        end else begin
-            if (pwm_timer >= PWM_PERIOD - 1) begin
-                pwm_timer <= 12'd0;
-                pwm_counter <= pwm_counter + 8'd1;  // Wraps around at 256
-            end else begin
-                pwm_timer <= pwm_timer + 12'd1;
+            gamma_index <= 4'd0;
+            gamma_index_d <= 4'd0;
+            for (int i = 0; i < 12; i++) begin
+                duty[i] <= 12'd0;
             end
+        end else begin
+            gamma_index <= (gamma_index == 4'd11) ? 4'd0 : gamma_index + 4'd1;
+            gamma_index_d <= gamma_index;
+            duty[gamma_index_d] <= gamma_out;   // LUT read is one cycle behind
         end
     end
     
     //===========================================
-    // LED DISPLAY: PWM output based on brightness
+    // LED DISPLAY: first-order sigma-delta per LED at 48 MHz
     // LED[0] = bucket 11, LED[11] = bucket 0
-    // Registered output for cleaner PWM
+    // The accumulator carry is the LED. Average on-time = duty / 4096, and
+    // the longest off gap is 4096 cycles (11.7 kHz at duty 1), so even the
+    // dimmest level does not flicker. One 12 bit adder per LED on the carry
+    // chain, no shared PWM counters.
     //===========================================
     always_ff @(posedge int_osc, posedge reset) begin
         if (reset) begin
             led <= 12'b0;
+            for (int i = 0; i < 12; i++) begin
+                sd_acc[i] <= 12'd0;
+            end
         end else begin
             for (int i = 0; i < 12; i++) begin
-                // LED is on when brightness > pwm_counter
-                led[11-i] <= (brightness[i] > pwm_counter);
+                {led[11-i], sd_acc[i]} <= {1'b0, sd_acc[i]} + {1'b0, duty[i]};
             end
         end
     end
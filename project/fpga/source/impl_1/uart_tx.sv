@@ -0,0 +1,49 @@
+// UART transmitter - 8N1, LSB first
+//
+// start loads data when busy is low; busy stays high until the stop bit is
+// done. CLKS_PER_BIT = 48 is 1 Mbaud from the 48 MHz oscillator (exact, so
+// no baud error against a USB-serial adapter set to 1000000).
+module uart_tx #(
+    parameter int CLKS_PER_BIT = 48
+) (
+    input  logic       clk,
+    input  logic       reset,
+    input  logic       start,
+    input  logic [7:0] data,
+    output logic       busy,
+    output logic       tx
+);
+    localparam int CW = $clog2(CLKS_PER_BIT);
+
+    logic [9:0]    frame;       // {stop, data, start}, shifted out LSB first
+    logic [3:0]    bits_left;
+    logic [CW-1:0] timer;
+
+    assign busy = (bits_left != 4'd0);
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            frame     <= 10'h3FF;
+            bits_left <= 4'd0;
+            timer     <= '0;
+            tx        <= 1'b1;
+        end else if (!busy) begin
+            tx <= 1'b1;
+            if (start) begin
+                frame     <= {1'b1, data, 1'b0};
+                bits_left <= 4'd10;
+                timer     <= '0;
+            end
+        end else begin
+            tx <= frame[0];
+            if (timer == CW'(CLKS_PER_BIT - 1)) begin
+                timer     <= '0;
+                frame     <= {1'b1, frame[9:1]};
+                bits_left <= bits_left - 4'd1;
+            end else begin
+                timer <= timer + 1'b1;
+            end
+        end
+    end
+
+endmodule
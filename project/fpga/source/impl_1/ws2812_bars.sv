@@ -0,0 +1,259 @@
+// WS2812 bar graph - NUM_BANDS x BAR_HEIGHT spectrum on an addressable LED chain
+//
+// Band levels (0-255) come from either source, one at a time:
+//   - bar frame (type 0x05): [0x05][seq][level0]...[level NUM_BANDS-1],
+//     spectrum computed on the MCU
+//   - Goertzel bin stream (goertzel_bank.sv bin_*): bin k goes to band
+//     k >> BIN_SHIFT (NUM_BANDS = 64: 2 bins / 62.5 Hz per band), max per band
+// Levels are written into the back half of a double buffered level RAM and
+// the halves swap on a complete frame / Goertzel block, the same
+// commit-on-end rule as the other frame types (a bar frame of the wrong
+// length never swaps).
+//
+// In every reset gap of the chain the renderer turns the front half into
+// pixels, one per clock (NUM_LEDS + 2 clocks, well inside TRESET), and writes
+// them to the framebuffer EBR that ws2812_tx.sv streams out. Bars are green at
+// the bottom through yellow to red at the top, BRIGHTNESS is the brightest
+// channel value (512 LEDs, all bars full: ~3 A at 48, ~15 A at 255). The top
+// pixel of a bar is lit in quarter steps, so bars move smoothly.
+//
+// Chain layout: column per band, band 0 first, pixels from the bottom up;
+// SERPENTINE = 1 for the usual zigzag matrices (odd columns top down).
+module ws2812_bars #(
+    parameter int NUM_BANDS  = 64,      // power of two, <= 128
+    parameter int BAR_HEIGHT = 8,       // >= 2
+    parameter bit SERPENTINE = 1'b1,
+    parameter int BRIGHTNESS = 48
+) (
+    input  logic       clk,
+    input  logic       reset,
+    // SPI byte stream (spi_frame_rx)
+    input  logic       byte_valid,
+    input  logic [7:0] byte_data,
+    input  logic [5:0] byte_index,
+    input  logic [7:0] frame_type,
+    input  logic       frame_end,
+    // Goertzel bin stream, bins in ascending order, then bins_done
+    input  logic       bin_valid,
+    input  logic [6:0] bin_index,          // 0 = DFT bin 1
+    input  logic [7:0] bin_level,
+    input  logic       bins_done,
+    // LED chain
+    output logic       dout,
+    output logic       frame_start         // 1 cycle pulse per frame sent
+);
+    localparam [7:0] TYPE_BARS = 8'h05;
+    localparam int   NUM_LEDS  = NUM_BANDS * BAR_HEIGHT;
+    localparam int   AW        = $clog2(NUM_LEDS);
+    localparam int   BW        = $clog2(NUM_BANDS);
+    localparam int   RW        = $clog2(BAR_HEIGHT);
+    localparam int   BIN_SHIFT = $clog2(128 / NUM_BANDS);
+
+    // Bar colour per row {g, r, b}: green -> yellow -> red
+    function automatic logic [BAR_HEIGHT*24-1:0] row_colors();
+        logic [BAR_HEIGHT*24-1:0] c;
+        int t, r, g;
+        for (int row = 0; row < BAR_HEIGHT; row++) begin
+            t = row * 256 / (BAR_HEIGHT - 1);
+            r = BRIGHTNESS * 2 * t / 256;
+            g = BRIGHTNESS * 2 * (256 - t) / 256;
+            if (r > BRIGHTNESS) r = BRIGHTNESS;
+            if (g > BRIGHTNESS) g = BRIGHTNESS;
+            c[row*24 +: 24] = {8'(g), 8'(r), 8'd0};
+        end
+        return c;
+    endfunction
+
+    localparam logic [BAR_HEIGHT*24-1:0] ROW_COLORS = row_colors();
+
+    //===========================================
+    // LEVEL RAM (EBR): two banks of NUM_BANDS, renderer reads the front one
+    //===========================================
+    logic [7:0]    level_mem [0:2*NUM_BANDS-1];
+    logic          show_bank;
+    logic          lv_we;
+    logic [BW:0]   lv_waddr;
+    logic [7:0]    lv_wdata;
+    logic [BW:0]   lv_raddr;
+    logic [7:0]    lv_q;
+
+    always_ff @(posedge clk) begin
+        lv_q <= level_mem[lv_raddr];
+        if (lv_we) level_mem[lv_waddr] <= lv_wdata;
+    end
+
+    //===========================================
+    // BAR FRAME LOADER
+    // byte_index saturates at 63, so count the payload here
+    //===========================================
+    logic [7:0] spi_count;
+    logic [7:0] spi_band;
+    logic       spi_we;
+    logic       spi_swap;
+
+    assign spi_band = (byte_index == 6'd2) ? 8'd0 : spi_count;
+    assign spi_we   = byte_valid && frame_type == TYPE_BARS && byte_index >= 6'd2 &&
+                      spi_band < 8'(NUM_BANDS);
+    assign spi_swap = frame_end && frame_type == TYPE_BARS && spi_count == 8'(NUM_BANDS);
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            spi_count <= 8'd0;
+        end else if (frame_end) begin
+            spi_count <= 8'd0;
+        end else if (byte_valid && frame_type == TYPE_BARS && byte_index >= 6'd2 &&
+                     spi_band <= 8'(NUM_BANDS)) begin
+            spi_count <= spi_band + 8'd1;       // NUM_BANDS + 1 = too long
+        end
+    end
+
+    //===========================================
+    // GOERTZEL BIN LOADER: running max, written when the band changes
+    //===========================================
+    logic [BW-1:0] bin_band;
+    logic [BW-1:0] cur_band;
+    logic [7:0]    cur_max;
+    logic          cur_have;
+    logic          bin_we;
+
+    assign bin_band = BW'(bin_index >> BIN_SHIFT);
+    assign bin_we   = cur_have && (bins_done || (bin_valid && bin_band != cur_band));
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            cur_band <= '0;
+            cur_max  <= 8'd0;
+            cur_have <= 1'b0;
+        end else if (bin_valid) begin
+            if (!cur_have || bin_band != cur_band) begin
+                cur_band <= bin_band;
+                cur_max  <= bin_level;
+            end else if (bin_level > cur_max) begin
+                cur_max <= bin_level;
+            end
+            cur_have <= 1'b1;
+        end else if (bins_done) begin
+            cur_have <= 1'b0;
+        end
+    end
+
+    // One write port: a bar frame byte wins over a bin (one source at a time)
+    always_comb begin
+        lv_we    = spi_we || bin_we;
+        lv_waddr = spi_we ? {~show_bank, BW'(spi_band)} : {~show_bank, cur_band};
+        lv_wdata = spi_we ? byte_data : cur_max;
+    end
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            show_bank <= 1'b0;
+        end else if (spi_swap || bins_done) begin
+            show_bank <= ~show_bank;
+        end
+    end
+
+    //===========================================
+    // RENDERER: level RAM -> framebuffer, in the reset gap
+    //===========================================
+    logic          latch, latch_d;
+    logic          rendering;
+    logic          render_bank;
+    logic [AW-1:0] r_pixel;
+    logic [BW-1:0] r_band;
+    logic [RW-1:0] r_pos;
+    logic          s1_valid;
+    logic [AW-1:0] s1_pixel;
+    logic [RW-1:0] s1_row;
+
+    logic [23:0]   fb_mem [0:NUM_LEDS-1];
+    logic          fb_we;
+    logic [23:0]   fb_wdata;
+    logic [AW-1:0] tx_addr;
+    logic [23:0]   tx_data;
+
+    assign lv_raddr = {render_bank, r_band};
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            latch_d     <= 1'b0;
+            rendering   <= 1'b0;
+            render_bank <= 1'b0;
+            r_pixel     <= '0;
+            r_band      <= '0;
+            r_pos       <= '0;
+            s1_valid    <= 1'b0;
+            s1_pixel    <= '0;
+            s1_row      <= '0;
+        end else begin
+            latch_d <= latch;
+
+            // Stage 0: level read for r_band, row for r_pos
+            s1_valid <= rendering;
+            s1_pixel <= r_pixel;
+            s1_row   <= (SERPENTINE && r_band[0]) ? RW'(BAR_HEIGHT - 1) - r_pos : r_pos;
+
+            if (latch && !latch_d) begin
+                rendering   <= 1'b1;
+                render_bank <= show_bank;
+                r_pixel     <= '0;
+                r_band      <= '0;
+                r_pos       <= '0;
+            end else if (rendering) begin
+                if (r_pixel == AW'(NUM_LEDS - 1)) rendering <= 1'b0;
+                r_pixel <= r_pixel + 1'b1;
+                if (r_pos == RW'(BAR_HEIGHT - 1)) begin
+                    r_pos  <= '0;
+                    r_band <= r_band + 1'b1;
+                end else begin
+                    r_pos <= r_pos + 1'b1;
+                end
+            end
+        end
+    end
+
+    // Stage 1: bar height in 1/256 pixels, colour of s1_row
+    logic [15:0] height;
+    logic [15:0] full;
+    logic [1:0]  part;
+    logic [23:0] base;
+
+    always_comb begin
+        height = (lv_q == 8'd0) ? 16'd0 : (16'(lv_q) + 16'd1) * 16'(BAR_HEIGHT);
+        full   = height >> 8;
+        part   = height[7:6];
+        base   = ROW_COLORS[s1_row*24 +: 24];
+
+        if (16'(s1_row) < full) begin
+            fb_wdata = base;
+        end else if (16'(s1_row) == full) begin
+            for (int ch = 0; ch < 3; ch++) begin
+                fb_wdata[ch*8 +: 8] = (part[1] ? base[ch*8 +: 8] >> 1 : 8'd0) +
+                                      (part[0] ? base[ch*8 +: 8] >> 2 : 8'd0);
+            end
+        end else begin
+            fb_wdata = 24'd0;
+        end
+        fb_we = s1_valid;
+    end
+
+    always_ff @(posedge clk) begin
+        tx_data <= fb_mem[tx_addr];
+        if (fb_we) fb_mem[s1_pixel] <= fb_wdata;
+    end
+
+    //===========================================
+    // SERIALIZER
+    //===========================================
+    ws2812_tx #(
+        .NUM_LEDS(NUM_LEDS)
+    ) tx (
+        .clk(clk),
+        .reset(reset),
+        .rd_addr(tx_addr),
+        .rd_data(tx_data),
+        .latch(latch),
+        .frame_start(frame_start),
+        .dout(dout)
+    );
+
+endmodule
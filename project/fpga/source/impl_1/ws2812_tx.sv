@@ -0,0 +1,116 @@
+// WS2812 transmitter - cycle exact serializer for a WS2812B / SK6812 (RGB) chain
+//
+// Every bit is TBIT clocks: high for T1H (1) or T0H (0), then low. At 48 MHz
+// the defaults are 1.25 us bits with 0.354 / 0.708 us highs, inside both the
+// WS2812B (0.4 / 0.8 +-0.15 us) and SK6812 (0.3 / 0.6 +-0.15 us) windows.
+// Pixels go out GRB, MSB first, NUM_LEDS per frame, then dout stays low for
+// TRESET clocks (300 us, the newer WS2812B need > 280 us) to latch.
+//
+// The transmitter is free running. Pixel p is read from the caller's
+// framebuffer through rd_addr / rd_data (registered EBR read, data one clock
+// after the address) while pixel p-1 is on the wire. latch is high for the
+// whole reset gap and pixel 0 of the next frame is read on its last clock,
+// so the caller can rewrite the framebuffer in the gap without tearing.
+// Frame period, exactly:
+//
+//   FRAME_CYCLES = NUM_LEDS * 24 * TBIT + TRESET + 1
+//
+// 512 LEDs: 751681 clocks = 63.9 fps, 256 LEDs: 125.3 fps.
+module ws2812_tx #(
+    parameter int NUM_LEDS = 512,
+    parameter int TBIT     = 60,       // 1.25 us
+    parameter int T0H      = 17,       // 0.354 us
+    parameter int T1H      = 34,       // 0.708 us
+    parameter int TRESET   = 14400     // 300 us
+) (
+    input  logic                        clk,
+    input  logic                        reset,
+    output logic [$clog2(NUM_LEDS)-1:0] rd_addr,
+    input  logic [23:0]                 rd_data,
+    output logic                        latch,         // reset gap, framebuffer free
+    output logic                        frame_start,   // 1 cycle pulse, first bit goes out
+    output logic                        dout
+);
+    localparam int AW = $clog2(NUM_LEDS);
+    localparam int TW = $clog2(TRESET + 1);
+
+    typedef enum logic [1:0] {
+        LATCH,      // reset gap, dout low
+        FETCH,      // pixel 0 read in flight
+        SEND
+    } tx_state_t;
+
+    tx_state_t state;
+
+    logic [TW-1:0] timer;       // bit time in SEND, gap length in LATCH
+    logic [4:0]    bit_count;
+    logic [AW-1:0] pixel;
+    logic [23:0]   shift;
+
+    assign latch = (state == LATCH);
+
+    always_ff @(posedge clk, posedge reset) begin
+        if (reset) begin
+            state       <= LATCH;
+            timer       <= '0;
+            bit_count   <= 5'd0;
+            pixel       <= '0;
+            rd_addr     <= '0;
+            shift       <= 24'd0;
+            frame_start <= 1'b0;
+            dout        <= 1'b0;
+        end else begin
+            frame_start <= 1'b0;
+
+            case (state)
+                LATCH: begin
+                    dout <= 1'b0;
+                    if (timer == TW'(TRESET - 1)) begin
+                        timer <= '0;
+                        state <= FETCH;
+                    end else begin
+                        timer <= timer + 1'b1;
+                    end
+                end
+
+                // rd_addr has been 0 for the whole gap, rd_data is pixel 0
+                FETCH: begin
+                    shift       <= rd_data;
+                    pixel       <= '0;
+                    bit_count   <= 5'd0;
+                    rd_addr     <= (NUM_LEDS > 1) ? AW'(1) : '0;
+                    frame_start <= 1'b1;
+                    state       <= SEND;
+                end
+
+                SEND: begin
+                    dout <= (timer < TW'(shift[23] ? T1H : T0H));
+
+                    if (timer == TW'(TBIT - 1)) begin
+                        timer <= '0;
+                        if (bit_count == 5'd23) begin
+                            bit_count <= 5'd0;
+                            if (pixel == AW'(NUM_LEDS - 1)) begin
+                                rd_addr <= '0;
+                                state   <= LATCH;
+                            end else begin
+                                // Next pixel was read TBIT * 24 clocks ago
+                                pixel   <= pixel + 1'b1;
+                                shift   <= rd_data;
+                                rd_addr <= rd_addr + 1'b1;
+                            end
+                        end else begin
+                            bit_count <= bit_count + 5'd1;
+                            shift     <= {shift[22:0], 1'b0};
+                        end
+                    end else begin
+                        timer <= timer + 1'b1;
+                    end
+                end
+
+                default: state <= LATCH;
+            endcase
+        end
+    end
+
+endmodule
@@ -0,0 +1,459 @@
+// fft_bench.c
+// FFT kernel benchmark: run time, accuracy and RAM of every transform the
+// analyzer could use, over sizes 64 - 4096
+//
+//   fft_bench [-j] [-m min] [-M max] [-r runs]
+//
+//   -j   JSON instead of a table
+//   -m   smallest size (default 64)
+//   -M   largest size (default 4096, FFT_BENCH_MAX_N)
+//   -r   timed calls per backend and size (default 200)
+//
+// Backends:
+//   fft_compute        lib/fft_processing.c, the one the firmware uses
+//   arm_cfft_f32       CMSIS-DSP, complex input, imaginary part 0
+//   arm_rfft_fast_f32  CMSIS-DSP real FFT
+//   arm_rfft_q15/q31   CMSIS-DSP fixed point real FFT
+// The CMSIS ones need FFT_BENCH_CMSIS=1 and a full CMSIS-DSP (Makefile
+// CMSIS_DSP=path, or libarm_cortexM4lf_math.a on the target): the copy in
+// this repo has no tables and no fixed point transforms.
+//
+// Every backend transforms the same block (three off-bin tones plus a
+// little noise, peak 0.9) and bins 0..n/2 are compared with a double
+// precision DFT of it. SNR is reference power over error power after a least
+// squares gain, so the 1/n output scaling of the fixed point FFTs is not
+// counted as error. RAM is the working buffers plus the instance struct.
+// Twiddle and bit reversal tables are const (flash) and fft_compute has
+// none, so they are not counted.
+//
+// Timing: each call is timed on its own with the input copied in untimed
+// before it, and the minimum and average are reported. On the host that is
+// CLOCK_MONOTONIC ns plus the TSC on x86. On the STM32 it is DWT->CYCCNT:
+// build this file instead of src/main.c (with lib/STM32L432KC_DWT.c and
+// lib/fft_processing.c); output goes to printf. FFT_BENCH_MAX_N defaults to
+// 1024 there to fit in SRAM.
+
+#include "../lib/fft_processing.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __arm__
+#include "../lib/STM32L432KC_DWT.h"
+#else
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+#endif
+
+#ifndef FFT_BENCH_CMSIS
+#define FFT_BENCH_CMSIS 0
+#endif
+
+#if FFT_BENCH_CMSIS
+#include "arm_math.h"
+#include "arm_const_structs.h"
+#endif
+
+#ifndef FFT_BENCH_MAX_N
+#ifdef __arm__
+#define FFT_BENCH_MAX_N 1024
+#else
+#define FFT_BENCH_MAX_N 4096
+#endif
+#endif
+
+#define FFT_BENCH_MIN_N 64
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Buffers, sized for FFT_BENCH_MAX_N and shared by the backends
+///////////////////////////////////////////////////////////////////////////////
+
+static float input[FFT_BENCH_MAX_N];
+static double refRe[FFT_BENCH_MAX_N / 2 + 1];
+static double refIm[FFT_BENCH_MAX_N / 2 + 1];
+
+// Largest user is q31: n inputs + 2n outputs
+static union {
+    float f32[3 * FFT_BENCH_MAX_N];
+    Complex cplx[FFT_BENCH_MAX_N];
+#if FFT_BENCH_CMSIS
+    q31_t q31[3 * FFT_BENCH_MAX_N];
+    q15_t q15[3 * FFT_BENCH_MAX_N];
+#endif
+} work;
+
+///////////////////////////////////////////////////////////////////////////////
+// Clock
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef __arm__
+#define TIME_UNIT "cycles"
+static uint32_t timeNow(void) {
+    return DWT_CYCLES();
+}
+#else
+#define TIME_UNIT "ns"
+static uint64_t timeNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Backends
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    const char* name;
+    int (*setup)(int n);            // 0 if n is supported
+    void (*load)(int n);            // input -> working buffer, not timed
+    void (*run)(int n);             // the transform, timed
+    void (*bin)(int n, int k, double* re, double* im);
+    size_t (*ramBytes)(int n);
+} Backend;
+
+// fft_compute: in place on n Complex
+static int naiveSetup(int n) {
+    (void)n;
+    return 0;
+}
+
+static void naiveLoad(int n) {
+    for (int i = 0; i < n; i++) {
+        work.cplx[i].real = input[i];
+        work.cplx[i].imag = 0.0f;
+    }
+}
+
+static void naiveRun(int n) {
+    fft_compute(work.cplx, n);
+}
+
+static void naiveBin(int n, int k, double* re, double* im) {
+    (void)n;
+    *re = work.cplx[k].real;
+    *im = work.cplx[k].imag;
+}
+
+static size_t naiveRam(int n) {
+    return n * sizeof(Complex);
+}
+
+#if FFT_BENCH_CMSIS
+// arm_cfft_f32: in place on n interleaved complex
+static const arm_cfft_instance_f32* cfftInst;
+
+static int cfftSetup(int n) {
+    switch (n) {
+    case 64:   cfftInst = &arm_cfft_sR_f32_len64;   break;
+    case 128:  cfftInst = &arm_cfft_sR_f32_len128;  break;
+    case 256:  cfftInst = &arm_cfft_sR_f32_len256;  break;
+    case 512:  cfftInst = &arm_cfft_sR_f32_len512;  break;
+    case 1024: cfftInst = &arm_cfft_sR_f32_len1024; break;
+    case 2048: cfftInst = &arm_cfft_sR_f32_len2048; break;
+    case 4096: cfftInst = &arm_cfft_sR_f32_len4096; break;
+    default:   return -1;
+    }
+    return 0;
+}
+
+static void cfftLoad(int n) {
+    for (int i = 0; i < n; i++) {
+        work.f32[2 * i] = input[i];
+        work.f32[2 * i + 1] = 0.0f;
+    }
+}
+
+static void cfftRun(int n) {
+    (void)n;
+    arm_cfft_f32(cfftInst, work.f32, 0, 1);
+}
+
+static void cfftBin(int n, int k, double* re, double* im) {
+    (void)n;
+    *re = work.f32[2 * k];
+    *im = work.f32[2 * k + 1];
+}
+
+static size_t cfftRam(int n) {
+    return 2 * n * sizeof(float32_t);
+}
+
+// arm_rfft_fast_f32: n real in, n packed out ([0] = DC, [1] = Nyquist)
+static arm_rfft_fast_instance_f32 rfftInst;
+
+static int rfftSetup(int n) {
+    return arm_rfft_fast_init_f32(&rfftInst, n) == ARM_MATH_SUCCESS ? 0 : -1;
+}
+
+static void rfftLoad(int n) {
+    memcpy(work.f32, input, n * sizeof(float32_t));
+}
+
+static void rfftRun(int n) {
+    arm_rfft_fast_f32(&rfftInst, work.f32, work.f32 + n, 0);
+}
+
+static void rfftBin(int n, int k, double* re, double* im) {
+    const float32_t* out = work.f32 + n;
+    if (k == 0 || k == n / 2) {
+        *re = out[k == 0 ? 0 : 1];
+        *im = 0.0;
+    } else {
+        *re = out[2 * k];
+        *im = out[2 * k + 1];
+    }
+}
+
+static size_t rfftRam(int n) {
+    return 2 * n * sizeof(float32_t) + sizeof(arm_rfft_fast_instance_f32);
+}
+
+// arm_rfft_q15 / q31: n real in, 2n out (n complex bins), scaled by 1/n
+static arm_rfft_instance_q15 q15Inst;
+static arm_rfft_instance_q31 q31Inst;
+
+static int q15Setup(int n) {
+    return arm_rfft_init_q15(&q15Inst, n, 0, 1) == ARM_MATH_SUCCESS ? 0 : -1;
+}
+
+static void q15Load(int n) {
+    arm_float_to_q15(input, work.q15, n);
+}
+
+static void q15Run(int n) {
+    arm_rfft_q15(&q15Inst, work.q15, work.q15 + n);
+}
+
+static void q15Bin(int n, int k, double* re, double* im) {
+    *re = work.q15[n + 2 * k] / 32768.0;
+    *im = work.q15[n + 2 * k + 1] / 32768.0;
+}
+
+static size_t q15Ram(int n) {
+    return 3 * n * sizeof(q15_t) + sizeof(arm_rfft_instance_q15);
+}
+
+static int q31Setup(int n) {
+    return arm_rfft_init_q31(&q31Inst, n, 0, 1) == ARM_MATH_SUCCESS ? 0 : -1;
+}
+
+static void q31Load(int n) {
+    arm_float_to_q31(input, work.q31, n);
+}
+
+static void q31Run(int n) {
+    arm_rfft_q31(&q31Inst, work.q31, work.q31 + n);
+}
+
+static void q31Bin(int n, int k, double* re, double* im) {
+    *re = work.q31[n + 2 * k] / 2147483648.0;
+    *im = work.q31[n + 2 * k + 1] / 2147483648.0;
+}
+
+static size_t q31Ram(int n) {
+    return 3 * n * sizeof(q31_t) + sizeof(arm_rfft_instance_q31);
+}
+#endif
+
+static const Backend backends[] = {
+    {"fft_compute", naiveSetup, naiveLoad, naiveRun, naiveBin, naiveRam},
+#if FFT_BENCH_CMSIS
+    {"arm_cfft_f32", cfftSetup, cfftLoad, cfftRun, cfftBin, cfftRam},
+    {"arm_rfft_fast_f32", rfftSetup, rfftLoad, rfftRun, rfftBin, rfftRam},
+    {"arm_rfft_q15", q15Setup, q15Load, q15Run, q15Bin, q15Ram},
+    {"arm_rfft_q31", q31Setup, q31Load, q31Run, q31Bin, q31Ram},
+#endif
+};
+
+#define NUM_BACKENDS ((int)(sizeof(backends) / sizeof(backends[0])))
+
+///////////////////////////////////////////////////////////////////////////////
+// Test block and reference
+///////////////////////////////////////////////////////////////////////////////
+
+// Three tones between bins (leakage into every bin) plus noise at -60 dB
+static void makeInput(int n) {
+    uint32_t seed = 12345;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        double noise = ((seed >> 8) / 16777216.0 - 0.5) * 0.002;
+        double x = 0.5 * sin(2 * M_PI * 0.0573 * i)
+                 + 0.25 * sin(2 * M_PI * 0.1371 * i + 1.0)
+                 + 0.1 * sin(2 * M_PI * 0.3089 * i + 2.0)
+                 + noise;
+        input[i] = (float)(x * 0.9 / 0.852);
+    }
+}
+
+// Double precision DFT of bins 0..n/2, twiddle by rotation (no table, so
+// it also fits on the MCU)
+static void makeReference(int n) {
+    for (int k = 0; k <= n / 2; k++) {
+        double c = cos(-2 * M_PI * k / n), s = sin(-2 * M_PI * k / n);
+        double wr = 1.0, wi = 0.0, re = 0.0, im = 0.0;
+        for (int i = 0; i < n; i++) {
+            re += input[i] * wr;
+            im += input[i] * wi;
+            double t = wr * c - wi * s;
+            wi = wr * s + wi * c;
+            wr = t;
+        }
+        refRe[k] = re;
+        refIm[k] = im;
+    }
+}
+
+static double snrDb(const Backend* b, int n) {
+    // Least squares gain g minimising |g * out - ref|^2
+    double dot = 0.0, outPow = 0.0, refPow = 0.0;
+    for (int k = 0; k <= n / 2; k++) {
+        double re, im;
+        b->bin(n, k, &re, &im);
+        dot += re * refRe[k] + im * refIm[k];
+        outPow += re * re + im * im;
+        refPow += refRe[k] * refRe[k] + refIm[k] * refIm[k];
+    }
+    if (outPow == 0.0) return -INFINITY;
+    double g = dot / outPow;
+
+    double errPow = 0.0;
+    for (int k = 0; k <= n / 2; k++) {
+        double re, im;
+        b->bin(n, k, &re, &im);
+        double er = g * re - refRe[k], ei = g * im - refIm[k];
+        errPow += er * er + ei * ei;
+    }
+    return errPow > 0.0 ? 10.0 * log10(refPow / errPow) : INFINITY;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Runner
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    double minTime;     // ns on the host, cycles on the MCU
+    double avgTime;
+    double minTsc;      // x86 only, else 0
+    double snr;
+    size_t ram;
+} Result;
+
+static Result measure(const Backend* b, int n, int runs) {
+    Result r = {0};
+
+    b->load(n);
+    b->run(n);
+    r.snr = snrDb(b, n);
+    r.ram = b->ramBytes(n);
+
+    double sum = 0.0;
+    for (int i = 0; i < runs; i++) {
+        b->load(n);
+#ifdef HAVE_TSC
+        uint64_t c0 = __rdtsc();
+#endif
+        uint64_t t0 = timeNow();
+        b->run(n);
+        uint64_t t1 = timeNow();
+#ifdef HAVE_TSC
+        uint64_t c1 = __rdtsc();
+        if (i == 0 || c1 - c0 < r.minTsc) r.minTsc = (double)(c1 - c0);
+#endif
+#ifdef __arm__
+        double dt = (uint32_t)(t1 - t0);
+#else
+        double dt = (double)(t1 - t0);
+#endif
+        if (i == 0 || dt < r.minTime) r.minTime = dt;
+        sum += dt;
+    }
+    r.avgTime = sum / runs;
+    return r;
+}
+
+static void printRow(int json, int first, const char* name, int n, const Result* r) {
+    if (json) {
+        printf("%s\n  {\"backend\": \"%s\", \"n\": %d, \"min_" TIME_UNIT "\": %.0f, "
+               "\"avg_" TIME_UNIT "\": %.1f, ", first ? "" : ",", name, n, r->minTime, r->avgTime);
+#ifdef HAVE_TSC
+        printf("\"min_tsc\": %.0f, ", r->minTsc);
+#endif
+        printf("\"snr_db\": %.1f, \"ram_bytes\": %zu}", r->snr, r->ram);
+    } else {
+        printf("%-18s %5d %12.0f %12.1f", name, n, r->minTime, r->avgTime);
+#ifdef HAVE_TSC
+        printf(" %10.0f", r->minTsc);
+#endif
+        printf(" %8.1f %9zu\n", r->snr, r->ram);
+    }
+}
+
+static void runAll(int json, int minN, int maxN, int runs) {
+    if (json) {
+        printf("[");
+    } else {
+        printf("%-18s %5s %12s %12s", "backend", "n", "min " TIME_UNIT, "avg " TIME_UNIT);
+#ifdef HAVE_TSC
+        printf(" %10s", "min tsc");
+#endif
+        printf(" %8s %9s\n", "SNR dB", "RAM bytes");
+    }
+
+    int first = 1;
+    for (int n = minN; n <= maxN; n <<= 1) {
+        makeInput(n);
+        makeReference(n);
+        for (int b = 0; b < NUM_BACKENDS; b++) {
+            if (backends[b].setup(n) != 0) continue;
+            Result r = measure(&backends[b], n, runs);
+            printRow(json, first, backends[b].name, n, &r);
+            first = 0;
+        }
+    }
+    if (json) printf("\n]\n");
+}
+
+#ifdef __arm__
+int main(void) {
+    initDWT();
+    runAll(0, FFT_BENCH_MIN_N, FFT_BENCH_MAX_N, 20);
+    while (1);
+}
+#else
+int main(int argc, char** argv) {
+    int json = 0, minN = FFT_BENCH_MIN_N, maxN = FFT_BENCH_MAX_N, runs = 200;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "jm:M:r:")) != -1) {
+        switch (opt) {
+        case 'j': json = 1; break;
+        case 'm': minN = atoi(optarg); break;
+        case 'M': maxN = atoi(optarg); break;
+        case 'r': runs = atoi(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-j] [-m min] [-M max] [-r runs]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (minN < 2 || (minN & (minN - 1)) || maxN > FFT_BENCH_MAX_N || runs < 1) {
+        fprintf(stderr, "%s: sizes are powers of 2 up to %d, runs >= 1\n", argv[0], FFT_BENCH_MAX_N);
+        return 2;
+    }
+
+    runAll(json, minN, maxN, runs);
+    return 0;
+}
+#endif
@@ -0,0 +1,669 @@
+// golden.c
+// Golden vector regression harness for the DSP chain: fixed ADC blocks with
+// the spectrum, notes and detection they must give, checked and timed in
+// one run
+//
+//   golden [-r runs] [-v] <vectors.gv>             host build of the chain
+//   golden -t <tty> [-b baud] [-v] <vectors.gv>    the firmware, over USART2
+//   golden -g <vectors.gv>                         write the standard set
+//
+//   -r   timed passes per vector on the host (default 1000)
+//   -t   run on the target instead: firmware built with GOLDEN_TARGET 1
+//   -b   baud rate for -t (default 2000000, TELEMETRY_BAUD)
+//   -v   print expected and actual notes for every vector, not only failures
+//   -g   generate: build the vectors below and their expected results
+//
+// A vector is FFT_SIZE ADC codes. What it must give comes from a double
+// precision DFT of the same codes with the same note rules as
+// lib/fft_processing.c (local maximum above MAG_THRESHOLD and above
+// FREQ_THRESHOLD, the loudest `notes` of those) and the LED
+// rule (the dominant bin above FREQ_THRESHOLD and MAG_THRESHOLD). The chain
+// passes a vector when:
+//   - every bin is within bin_tol of the reference magnitude
+//   - it finds the same notes, each within its Hz / relative magnitude
+//     tolerance (in any order, equal notes may swap)
+//   - the detection decision is the same
+// The generator refuses a signal where float rounding could change the note
+// list or the LED (a maximum within 1% of the threshold or of a neighbour,
+// the last kept note within 1% of the next, a runner-up within 1% of the
+// dominant bin), so a failure is a real change.
+//
+// Times are the whole chain, fftNormalize to fftDetect: the fastest of the
+// host passes, or the DWT cycles the target reports for that vector.
+//
+// File format, text, `//` comments:
+//   size <FFT_SIZE> rate <SAMPLE_RATE> notes <max notes> bin_tol <mag>
+//   vector <name> <description...>
+//   adc <16 codes, 3 hex digits>       FFT_SIZE / 16 lines
+//   mag <8 magnitudes>                 FFT_SIZE / 16 lines, bins 0..n/2-1
+//   note <Hz> <mag> <Hz tol> <mag tol %>
+//   detect <0|1>
+//   end
+
+#define _DEFAULT_SOURCE
+#include "../lib/fft_processing.h"
+#include "../lib/telemetry.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// The firmware's MAX_NOTES with the timer voices
+#define GOLDEN_NOTES        3
+#define GOLDEN_MAX_VECTORS  64
+#define GOLDEN_BINS         (FFT_SIZE / 2)
+
+// Defaults written by -g
+#define BIN_TOL             0.02
+#define NOTE_HZ_TOL         1.0
+#define NOTE_MAG_TOL        1.0     // percent
+
+// Generator: how close to a decision a reference value may be
+#define MARGIN              0.01
+
+// DWT_CPU_HZ, what the target cycle counts are in
+#define CPU_HZ              80000000.0
+
+#define REPLY_TIMEOUT_MS    2000
+
+typedef struct {
+    double freq;
+    double mag;
+    double freqTol;
+    double magTol;                  // percent
+} GoldenNote;
+
+typedef struct {
+    char name[32];
+    char desc[96];
+    uint16_t adc[FFT_SIZE];
+    double mags[GOLDEN_BINS];
+    GoldenNote notes[GOLDEN_NOTES];
+    int noteCount;
+    int detect;
+} GoldenVector;
+
+// What the chain gave for one vector
+typedef struct {
+    float mags[GOLDEN_BINS];
+    float noteFreqs[GOLDEN_NOTES];
+    float noteMags[GOLDEN_NOTES];
+    int noteCount;
+    int detect;
+    double seconds;
+} ChainResult;
+
+static GoldenVector vectors[GOLDEN_MAX_VECTORS];
+static int vectorCount;
+static int maxNotes = GOLDEN_NOTES;
+static double binTol = BIN_TOL;
+
+///////////////////////////////////////////////////////////////////////////////
+// Reference: double precision DFT and the fft_processing.c note rules
+///////////////////////////////////////////////////////////////////////////////
+
+static void referenceMags(const uint16_t* adc, double* mags) {
+    static double x[FFT_SIZE];
+    for (int i = 0; i < FFT_SIZE; i++) x[i] = ((double)adc[i] - 2048.0) / 2048.0;
+
+    for (int k = 0; k < GOLDEN_BINS; k++) {
+        double re = 0.0, im = 0.0;
+        for (int i = 0; i < FFT_SIZE; i++) {
+            double a = -2.0 * M_PI * (double)((long)k * i % FFT_SIZE) / FFT_SIZE;
+            re += x[i] * cos(a);
+            im += x[i] * sin(a);
+        }
+        mags[k] = (k == 0) ? fabs(re) : sqrt(re * re + im * im);
+    }
+}
+
+// Left neighbour as fftFindNotes sees it: bin 1 is compared with 0, not DC
+static double leftOf(const double* mags, int k) {
+    return (k == 1) ? 0.0 : mags[k - 1];
+}
+
+static double rightOf(const double* mags, int k) {
+    return (k + 1 < GOLDEN_BINS) ? mags[k + 1] : 0.0;
+}
+
+// Local maxima above MAG_THRESHOLD and FREQ_THRESHOLD, loudest first. Lower
+// maxima never compete for a slot. Returns how many (all of them, not only
+// the first maxNotes).
+static int referencePeaks(const double* mags, int* bins) {
+    int count = 0;
+    for (int k = 1; k < GOLDEN_BINS; k++) {
+        if ((double)k * SAMPLE_RATE / FFT_SIZE <= FREQ_THRESHOLD) continue;
+        if (mags[k] > leftOf(mags, k) && mags[k] >= rightOf(mags, k) && mags[k] > MAG_THRESHOLD) {
+            int pos = count++;
+            while (pos > 0 && mags[bins[pos - 1]] < mags[k]) {
+                bins[pos] = bins[pos - 1];
+                pos--;
+            }
+            bins[pos] = k;
+        }
+    }
+    return count;
+}
+
+// Fills in mags, notes and detect from adc. Returns 0, or -1 with why in
+// *reason if float rounding could decide the note list.
+static int referenceVector(GoldenVector* v, const char** reason) {
+    int bins[GOLDEN_BINS];
+    referenceMags(v->adc, v->mags);
+
+    const double* m = v->mags;
+    for (int k = 1; k < GOLDEN_BINS; k++) {
+        double left = leftOf(m, k), right = rightOf(m, k);
+        int nearMax = m[k] >= left * (1.0 - MARGIN) && m[k] >= right * (1.0 - MARGIN);
+        if (nearMax && fabs(m[k] - MAG_THRESHOLD) < MAG_THRESHOLD * MARGIN) {
+            *reason = "a maximum is within 1% of MAG_THRESHOLD";
+            return -1;
+        }
+        if (m[k] > MAG_THRESHOLD &&
+            (fabs(m[k] - left) < m[k] * MARGIN || fabs(m[k] - right) < m[k] * MARGIN)) {
+            *reason = "a bin above MAG_THRESHOLD is within 1% of a neighbour";
+            return -1;
+        }
+    }
+
+    int peaks = referencePeaks(m, bins);
+    if (peaks > maxNotes && m[bins[maxNotes - 1]] - m[bins[maxNotes]] < m[bins[maxNotes - 1]] * MARGIN) {
+        *reason = "the last note kept is within 1% of the next one";
+        return -1;
+    }
+    if (peaks > maxNotes) peaks = maxNotes;
+
+    v->noteCount = 0;
+    for (int i = 0; i < peaks; i++) {
+        GoldenNote* n = &v->notes[v->noteCount++];
+        n->freq = (double)bins[i] * SAMPLE_RATE / FFT_SIZE;
+        n->mag = m[bins[i]];
+        n->freqTol = NOTE_HZ_TOL;
+        n->magTol = NOTE_MAG_TOL;
+    }
+    // The LED follows the single dominant bin, DC skipped
+    int top = 1, second = 2;
+    for (int k = 2; k < GOLDEN_BINS; k++) {
+        if (m[k] > m[top]) {
+            second = top;
+            top = k;
+        } else if (k != top && m[k] > m[second]) {
+            second = k;
+        }
+    }
+    if (m[top] - m[second] < m[top] * MARGIN && m[top] > MAG_THRESHOLD) {
+        *reason = "the two loudest bins are within 1%";
+        return -1;
+    }
+    v->detect = (double)top * SAMPLE_RATE / FFT_SIZE > FREQ_THRESHOLD && m[top] > MAG_THRESHOLD;
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// The standard set (-g)
+///////////////////////////////////////////////////////////////////////////////
+
+// Deterministic noise, -1..1, same on every host
+static uint32_t noiseState;
+
+static double noise(void) {
+    noiseState = noiseState * 1664525u + 1013904223u;
+    return (double)(noiseState >> 8) / (double)(1u << 23) - 1.0;
+}
+
+typedef struct {
+    const char* name;
+    const char* desc;
+    double tones[4][2];             // Hz, amplitude (1.0 = full scale)
+    double dc;
+    double noise;                   // peak amplitude of uniform noise
+    double gain;                    // before the ADC clips, 0 = 1
+} Recipe;
+
+static const Recipe recipes[] = {
+    { "silence", "mid scale, no signal", { { 0 } }, 0, 0, 0 },
+    { "tone_bin14", "437.5 Hz on bin 14, half scale", { { 437.5, 0.5 } }, 0, 0, 0 },
+    { "tone_440", "440 Hz between bins, half scale (leakage)", { { 440.0, 0.5 } }, 0, 0, 0 },
+    { "tone_full", "1 kHz full scale", { { 1000.0, 1.0 } }, 0, 0, 0 },
+    { "tone_quiet", "1 kHz at 0.1, just above MAG_THRESHOLD", { { 1000.0, 0.1 } }, 0, 0, 0 },
+    { "tone_too_quiet", "1 kHz at 0.06, below MAG_THRESHOLD", { { 1000.0, 0.06 } }, 0, 0, 0 },
+    { "tone_low", "62.5 Hz, found but below FREQ_THRESHOLD", { { 62.5, 0.5 } }, 0, 0, 0 },
+    { "tone_nyquist", "3937.5 Hz, bin 126", { { 3937.5, 0.5 } }, 0, 0, 0 },
+    { "dc_and_tone", "DC offset 0.3 plus 625 Hz at 0.3", { { 625.0, 0.3 } }, 0.3, 0, 0 },
+    { "chord_c_major", "C4 E4 G4 at 0.25 each, between bins",
+      { { 261.63, 0.25 }, { 329.63, 0.25 }, { 392.0, 0.25 } }, 0, 0, 0 },
+    { "close_tones", "1000 and 1062.5 Hz, two bins apart",
+      { { 1000.0, 0.3 }, { 1062.5, 0.2 } }, 0, 0, 0 },
+    { "four_tones", "four tones, the quietest is not kept",
+      { { 500.0, 0.4 }, { 1500.0, 0.3 }, { 2500.0, 0.2 }, { 3500.0, 0.1 } }, 0, 0, 0 },
+    { "rumble_and_chord", "62.5 Hz rumble at 0.5 under three tones, all three kept",
+      { { 62.5, 0.5 }, { 500.0, 0.3 }, { 1500.0, 0.2 }, { 2500.0, 0.1 } }, 0, 0, 0 },
+    { "noise", "uniform noise, peak 0.1, no notes", { { 0 } }, 0, 0.1, 0 },
+    { "noisy_tone", "750 Hz at 0.3 in noise, peak 0.2", { { 750.0, 0.3 } }, 0, 0.2, 0 },
+    { "clipped_440", "440 Hz driven to twice full scale, ADC clips",
+      { { 440.0, 1.0 } }, 0, 0, 2.0 },
+};
+
+#define NUM_RECIPES (int)(sizeof(recipes) / sizeof(recipes[0]))
+
+static void recipeAdc(const Recipe* r, uint16_t* adc) {
+    noiseState = 12345;
+    for (int i = 0; i < FFT_SIZE; i++) {
+        double t = (double)i / SAMPLE_RATE;
+        double x = r->dc;
+        for (int j = 0; j < 4; j++) x += r->tones[j][1] * sin(2.0 * M_PI * r->tones[j][0] * t);
+        if (r->noise > 0) x += r->noise * noise();
+        if (r->gain > 0) x *= r->gain;
+
+        long code = lround(2048.0 + x * 2047.0);
+        if (code < 0) code = 0;
+        if (code > 4095) code = 4095;
+        adc[i] = (uint16_t)code;
+    }
+}
+
+static int writeVectors(const char* path) {
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    fprintf(f, "// DSP chain golden vectors, written by host/golden -g. Expected results\n");
+    fprintf(f, "// are a double precision DFT of the codes with the fft_processing.c note\n");
+    fprintf(f, "// rules. Regenerate instead of editing the numbers; tolerances may be\n");
+    fprintf(f, "// edited by hand.\n\n");
+    fprintf(f, "size %d rate %d notes %d bin_tol %g\n", FFT_SIZE, SAMPLE_RATE, maxNotes, binTol);
+
+    int bad = 0;
+    for (int r = 0; r < NUM_RECIPES; r++) {
+        GoldenVector v;
+        const char* reason = NULL;
+        recipeAdc(&recipes[r], v.adc);
+        if (referenceVector(&v, &reason) != 0) {
+            fprintf(stderr, "golden: %s: %s, change the signal\n", recipes[r].name, reason);
+            bad = 1;
+            continue;
+        }
+
+        fprintf(f, "\nvector %s %s\n", recipes[r].name, recipes[r].desc);
+        for (int i = 0; i < FFT_SIZE; i++) {
+            fprintf(f, "%s%03X", (i % 16 == 0) ? "adc " : " ", v.adc[i]);
+            if (i % 16 == 15) fprintf(f, "\n");
+        }
+        for (int k = 0; k < GOLDEN_BINS; k++) {
+            fprintf(f, "%s%.4f", (k % 8 == 0) ? "mag " : " ", v.mags[k]);
+            if (k % 8 == 7) fprintf(f, "\n");
+        }
+        for (int i = 0; i < v.noteCount; i++) {
+            fprintf(f, "note %.2f %.4f %g %g\n", v.notes[i].freq, v.notes[i].mag,
+                    v.notes[i].freqTol, v.notes[i].magTol);
+        }
+        fprintf(f, "detect %d\nend\n", v.detect);
+    }
+
+    fclose(f);
+    if (bad) remove(path);
+    return bad;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Vector file
+///////////////////////////////////////////////////////////////////////////////
+
+static int parseError(const char* path, int line, const char* what) {
+    fprintf(stderr, "%s:%d: %s\n", path, line, what);
+    return -1;
+}
+
+static int readVectors(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    char buf[512];
+    int line = 0, haveHeader = 0, adcCount = 0, magCount = 0;
+    GoldenVector* v = NULL;
+
+    while (fgets(buf, sizeof(buf), f) != NULL) {
+        line++;
+        char* comment = strstr(buf, "//");
+        if (comment != NULL) *comment = '\0';
+
+        char word[16];
+        int used;
+        if (sscanf(buf, "%15s%n", word, &used) != 1) continue;
+        char* rest = buf + used;
+
+        if (strcmp(word, "size") == 0) {
+            int size, rate;
+            if (sscanf(rest, " %d rate %d notes %d bin_tol %lf", &size, &rate, &maxNotes, &binTol) != 4) {
+                return parseError(path, line, "expected size / rate / notes / bin_tol");
+            }
+            if (size != FFT_SIZE || rate != SAMPLE_RATE || maxNotes < 1 || maxNotes > GOLDEN_NOTES) {
+                return parseError(path, line, "vectors are for another FFT_SIZE / SAMPLE_RATE");
+            }
+            haveHeader = 1;
+        } else if (!haveHeader) {
+            return parseError(path, line, "size line missing");
+        } else if (strcmp(word, "vector") == 0) {
+            if (v != NULL) return parseError(path, line, "vector inside a vector");
+            if (vectorCount == GOLDEN_MAX_VECTORS) return parseError(path, line, "too many vectors");
+            v = &vectors[vectorCount];
+            memset(v, 0, sizeof(*v));
+            v->detect = -1;
+            adcCount = magCount = 0;
+            if (sscanf(rest, " %31s %n", v->name, &used) != 1) return parseError(path, line, "vector name");
+            snprintf(v->desc, sizeof(v->desc), "%s", rest + used);
+            v->desc[strcspn(v->desc, "\r\n")] = '\0';
+        } else if (v == NULL) {
+            return parseError(path, line, "outside a vector");
+        } else if (strcmp(word, "adc") == 0) {
+            unsigned code;
+            while (sscanf(rest, " %x%n", &code, &used) == 1) {
+                if (adcCount == FFT_SIZE || code > 4095) return parseError(path, line, "bad adc codes");
+                v->adc[adcCount++] = (uint16_t)code;
+                rest += used;
+            }
+        } else if (strcmp(word, "mag") == 0) {
+            double mag;
+            while (sscanf(rest, " %lf%n", &mag, &used) == 1) {
+                if (magCount == GOLDEN_BINS) return parseError(path, line, "too many magnitudes");
+                v->mags[magCount++] = mag;
+                rest += used;
+            }
+        } else if (strcmp(word, "note") == 0) {
+            GoldenNote* n = &v->notes[v->noteCount];
+            if (v->noteCount == maxNotes ||
+                sscanf(rest, " %lf %lf %lf %lf", &n->freq, &n->mag, &n->freqTol, &n->magTol) != 4) {
+                return parseError(path, line, "bad note");
+            }
+            v->noteCount++;
+        } else if (strcmp(word, "detect") == 0) {
+            if (sscanf(rest, " %d", &v->detect) != 1) return parseError(path, line, "bad detect");
+        } else if (strcmp(word, "end") == 0) {
+            if (adcCount != FFT_SIZE || magCount != GOLDEN_BINS || v->detect < 0) {
+                return parseError(path, line, "vector incomplete");
+            }
+            vectorCount++;
+            v = NULL;
+        } else {
+            return parseError(path, line, "unknown keyword");
+        }
+    }
+
+    fclose(f);
+    if (v != NULL) return parseError(path, line, "missing end");
+    return vectorCount;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Running the chain
+///////////////////////////////////////////////////////////////////////////////
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Same calls as the main loop in src/main.c
+static void chain(const uint16_t* adc, ChainResult* r) {
+    static Complex buf[FFT_SIZE];
+    fftNormalize(adc, buf, FFT_SIZE);
+    fft_compute(buf, FFT_SIZE);
+    r->noteCount = fftFindNotes(buf, FFT_SIZE, SAMPLE_RATE, MAG_THRESHOLD, FREQ_THRESHOLD,
+                                r->mags, r->noteFreqs, r->noteMags, maxNotes);
+    float mag;
+    float freq = fftDominant(r->mags, GOLDEN_BINS, (float)SAMPLE_RATE / FFT_SIZE, &mag);
+    r->detect = fftDetect(freq, mag, FREQ_THRESHOLD, MAG_THRESHOLD);
+}
+
+static void runHost(const GoldenVector* v, ChainResult* r, int runs) {
+    double best = 1e9;
+    for (int i = 0; i < runs; i++) {
+        double start = now();
+        chain(v->adc, r);
+        double t = now() - start;
+        if (t < best) best = t;
+    }
+    r->seconds = best;
+}
+
+static speed_t baudConstant(long baud) {
+    switch (baud) {
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    case 1000000: return B1000000;
+    case 1500000: return B1500000;
+    case 2000000: return B2000000;
+    default: return 0;
+    }
+}
+
+// Raw 8N1 at baud, reads return what is there
+static int openTarget(const char* path, long baud) {
+    speed_t speed = baudConstant(baud);
+    if (speed == 0) {
+        fprintf(stderr, "unsupported baud rate %ld\n", baud);
+        return -1;
+    }
+
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        perror("tcgetattr");
+        close(fd);
+        return -1;
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+        perror("tcsetattr");
+        close(fd);
+        return -1;
+    }
+    tcflush(fd, TCIOFLUSH);
+    return fd;
+}
+
+// Sends the vector as a TELEMETRY_VECTOR frame and waits for the
+// TELEMETRY_RESULT with the same sequence number
+static int runTarget(int fd, const GoldenVector* v, uint16_t seq, ChainResult* r) {
+    static uint8_t out[TELEMETRY_VECTOR_BYTES(FFT_SIZE)];
+    static uint8_t in[2 * (TELEMETRY_HEADER_BYTES + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_BYTES)];
+    static TelemetrySpectrum spec;
+    size_t len = 0;
+
+    int n = telemetryPackVector(out, seq, v->adc, FFT_SIZE);
+    if (write(fd, out, (size_t)n) != n) {
+        perror("write");
+        return -1;
+    }
+
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    for (;;) {
+        int ready = poll(&pfd, 1, REPLY_TIMEOUT_MS);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) {
+            fprintf(stderr, "golden: %s: no reply from the target\n", v->name);
+            return -1;
+        }
+        ssize_t got = read(fd, &in[len], sizeof(in) - len);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return -1;
+        len += (size_t)got;
+
+        TelemetryFrame f;
+        size_t used;
+        int found;
+        while ((found = telemetryFind(in, len, &f, &used)) != 0 || used > 0) {
+            memmove(in, &in[used], len - used);
+            len -= used;
+            if (found != 1 || f.type != TELEMETRY_RESULT || f.seq != seq) continue;
+            if (telemetrySpectrum(&f, &spec) != 0 || spec.binCount != GOLDEN_BINS ||
+                spec.peakCount > GOLDEN_NOTES) {
+                fprintf(stderr, "golden: %s: bad result frame\n", v->name);
+                return -1;
+            }
+
+            memcpy(r->mags, spec.mags, sizeof(r->mags));
+            memcpy(r->noteFreqs, spec.peakFreqs, spec.peakCount * sizeof(float));
+            memcpy(r->noteMags, spec.peakMags, spec.peakCount * sizeof(float));
+            r->noteCount = spec.peakCount;
+            r->detect = (spec.flags & TELEMETRY_FLAG_DETECTED) != 0;
+            r->seconds = f.timestamp / CPU_HZ;
+            return 0;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Checking
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    double binErr;                  // largest absolute bin error
+    double noteErr;                 // largest note magnitude error, percent
+    int notesMatched;
+    int pass;
+} Verdict;
+
+static Verdict judge(const GoldenVector* v, const ChainResult* r) {
+    Verdict d = { 0.0, 0.0, 0, 1 };
+
+    for (int k = 0; k < GOLDEN_BINS; k++) {
+        double e = fabs(r->mags[k] - v->mags[k]);
+        if (e > d.binErr) d.binErr = e;
+    }
+    if (d.binErr > binTol) d.pass = 0;
+
+    // Each expected note takes the closest unused note within tolerance
+    int taken[GOLDEN_NOTES] = { 0 };
+    for (int i = 0; i < v->noteCount; i++) {
+        const GoldenNote* n = &v->notes[i];
+        int best = -1;
+        for (int j = 0; j < r->noteCount; j++) {
+            if (taken[j] || fabs(r->noteFreqs[j] - n->freq) > n->freqTol) continue;
+            if (best < 0 || fabs(r->noteFreqs[j] - n->freq) < fabs(r->noteFreqs[best] - n->freq)) {
+                best = j;
+            }
+        }
+        if (best < 0) continue;
+
+        double e = 100.0 * fabs(r->noteMags[best] - n->mag) / n->mag;
+        if (e > d.noteErr) d.noteErr = e;
+        if (e <= n->magTol) {
+            taken[best] = 1;
+            d.notesMatched++;
+        }
+    }
+    if (d.notesMatched != v->noteCount || r->noteCount != v->noteCount) d.pass = 0;
+    if (r->detect != v->detect) d.pass = 0;
+    return d;
+}
+
+static void printNotes(const GoldenVector* v, const ChainResult* r) {
+    printf("    expected:");
+    for (int i = 0; i < v->noteCount; i++) printf("  %.2f Hz (%.3f)", v->notes[i].freq, v->notes[i].mag);
+    printf("%s  detect %d\n", v->noteCount ? "" : "  none", v->detect);
+    printf("    got:     ");
+    for (int i = 0; i < r->noteCount; i++) printf("  %.2f Hz (%.3f)", r->noteFreqs[i], r->noteMags[i]);
+    printf("%s  detect %d\n", r->noteCount ? "" : "  none", r->detect);
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "usage: %s [-r runs] [-t tty [-b baud]] [-v] <vectors.gv>\n"
+                    "       %s -g <vectors.gv>\n", prog, prog);
+}
+
+int main(int argc, char** argv) {
+    const char* tty = NULL;
+    long baud = 2000000;
+    int runs = 1000, verbose = 0, generate = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:t:b:vg")) != -1) {
+        switch (opt) {
+        case 'r': runs = atoi(optarg); break;
+        case 't': tty = optarg; break;
+        case 'b': baud = atol(optarg); break;
+        case 'v': verbose = 1; break;
+        case 'g': generate = 1; break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind != argc - 1 || runs < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char* path = argv[optind];
+
+    if (generate) return writeVectors(path);
+    if (readVectors(path) < 0) return 2;
+
+    int fd = -1;
+    if (tty != NULL && (fd = openTarget(tty, baud)) < 0) return 2;
+
+    printf("golden: %s, %d vectors, FFT %d at %d Hz, %s on the %s\n", path, vectorCount,
+           FFT_SIZE, SAMPLE_RATE, FFT_BACKEND, tty ? "target" : "host");
+    printf("%-16s %5s %6s %9s %9s %9s  %s\n", "vector", "notes", "detect", "bin err", "note err",
+           "time us", "result");
+
+    int failed = 0;
+    double total = 0.0;
+    for (int i = 0; i < vectorCount; i++) {
+        const GoldenVector* v = &vectors[i];
+        ChainResult r;
+        memset(&r, 0, sizeof(r));
+
+        if (fd >= 0) {
+            if (runTarget(fd, v, (uint16_t)i, &r) != 0) {
+                printf("%-16s %5s %6s %9s %9s %9s  FAIL (no result)\n", v->name, "-", "-", "-", "-", "-");
+                failed++;
+                continue;
+            }
+        } else {
+            runHost(v, &r, runs);
+        }
+
+        Verdict d = judge(v, &r);
+        total += r.seconds;
+        printf("%-16s %2d/%-2d %3d/%-2d %9.5f %8.3f%% %9.2f  %s\n", v->name, d.notesMatched,
+               v->noteCount, r.detect, v->detect, d.binErr, d.noteErr, r.seconds * 1e6,
+               d.pass ? "PASS" : "FAIL");
+        if (!d.pass || verbose) printNotes(v, &r);
+        if (!d.pass) failed++;
+    }
+
+    if (fd >= 0) close(fd);
+    printf("%d passed, %d failed, chain %.2f us per vector on average\n", vectorCount - failed,
+           failed, vectorCount ? total * 1e6 / vectorCount : 0.0);
+    return failed ? 1 : 0;
+}
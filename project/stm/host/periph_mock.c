@@ -0,0 +1,1334 @@
+// periph_mock.c
+// Register level model of the STM32L432KC peripherals for host driver tests
+//
+// Every peripheral page is mapped at its real address with no access rights
+// and a second, always writable view of the same memory is kept for the
+// models. A driver access faults: the SIGSEGV handler counts it, lets the
+// model refresh status bits (reads), opens the page and sets the trap flag.
+// The instruction runs, the SIGTRAP after it closes the page again and hands
+// the old and new value to the model (writes). The page fault error code
+// tells reads from writes, so this is x86-64 Linux only.
+
+#define _GNU_SOURCE
+#include "periph_mock.h"
+
+#include "../lib/STM32L432KC_ADC.h"
+#include "../lib/STM32L432KC_DMA.h"
+#include "../lib/STM32L432KC_DWT.h"
+#include "../lib/STM32L432KC_FLASH.h"
+#include "../lib/STM32L432KC_GPIO.h"
+#include "../lib/STM32L432KC_PWR.h"
+#include "../lib/STM32L432KC_RCC.h"
+#include "../lib/STM32L432KC_SPI.h"
+#include "../lib/STM32L432KC_TIM.h"
+#include "../lib/STM32L432KC_USART.h"
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "periph_mock needs x86-64 Linux (page fault error code, trap flag)"
+#endif
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+#define PAGE            4096UL
+#define TRAP_FLAG       0x100UL     // EFLAGS.TF
+#define PF_WRITE        0x2UL       // page fault error code, write access
+#define POLL_LIMIT      100000UL    // reads of one register in a row = stuck
+#define MAX_VIOLATIONS  32
+
+#define NVIC_BASE       0xE000E100UL
+#define SCB_BASE        0xE000ED00UL
+#define SPI_CS_BIT      (1UL << SPI_CE)
+
+///////////////////////////////////////////////////////////////////////////////
+// Memory map
+///////////////////////////////////////////////////////////////////////////////
+
+static const uintptr_t pageBase[] = {
+    0x40000000UL,   // TIM2
+    0x40004000UL,   // USART2 (0x40004400)
+    0x40007000UL,   // PWR
+    0x40012000UL,   // TIM1 (0x40012C00)
+    0x40013000UL,   // SPI1
+    0x40014000UL,   // TIM15, TIM16
+    0x40020000UL,   // DMA1
+    0x40021000UL,   // RCC
+    0x40022000UL,   // FLASH
+    0x48000000UL,   // GPIOA, GPIOB
+    0x50040000UL,   // ADC1, ADC common
+    0xE0001000UL,   // DWT
+    0xE000E000UL,   // NVIC, SCB, CoreDebug
+};
+
+#define NUM_PAGES       (sizeof(pageBase) / sizeof(pageBase[0]))
+#define WORDS_PER_PAGE  (PAGE / 4)
+
+static uint8_t* shadow;
+static int mapped = 0;
+
+static int pageOf(uintptr_t addr) {
+    for (size_t i = 0; i < NUM_PAGES; i++) {
+        if (addr - pageBase[i] < PAGE) return (int)i;
+    }
+    return -1;
+}
+
+static void* sptr(uintptr_t addr) {
+    return shadow + pageOf(addr) * PAGE + (addr & (PAGE - 4));
+}
+
+#define SREG(addr)  (*(volatile uint32_t*)sptr(addr))
+#define S_RCC       ((RCC_TypeDef*)sptr(RCC_BASE))
+#define S_FLASH     ((FLASH_TypeDef*)sptr(FLASH_BASE))
+#define S_PWR       ((PWR_TypeDef*)sptr(PWR_BASE))
+#define S_ADC       ((ADC_TypeDef*)sptr(ADC1_BASE))
+#define S_DMA       ((DMA_TypeDef*)sptr(DMA1_BASE))
+#define S_CSELR     ((DMA_Request_TypeDef*)sptr(DMA1_BASE + 0xA8))
+#define S_SPI       ((SPI_TypeDef*)sptr(SPI1_BASE))
+#define S_USART     ((USART_TypeDef*)sptr(USART2_BASE))
+#define S_GPIOA     ((GPIO_TypeDef*)sptr(GPIOA_BASE))
+#define S_DWT       ((DWT_TypeDef*)sptr(DWT_BASE))
+#define S_COREDEBUG ((CoreDebug_TypeDef*)sptr(COREDEBUG_BASE))
+#define S_NVIC_ISER (&SREG(NVIC_BASE))
+
+static DMA_Channel_TypeDef* schan(int ch) {
+    return (DMA_Channel_TypeDef*)sptr(DMA1_Channel1_BASE + (ch - 1) * 0x14);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Clock gates: writes only stick with the RCC enable bit set
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    uintptr_t base;
+    size_t enr;         // offset of the enable register in RCC
+    int bit;
+} ClockGate;
+
+static const ClockGate gates[] = {
+    { TIM2_BASE,  offsetof(RCC_TypeDef, APB1ENR1), 0 },
+    { USART2_BASE, offsetof(RCC_TypeDef, APB1ENR1), 17 },
+    { PWR_BASE,   offsetof(RCC_TypeDef, APB1ENR1), 28 },
+    { TIM1_BASE,  offsetof(RCC_TypeDef, APB2ENR), 11 },
+    { SPI1_BASE,  offsetof(RCC_TypeDef, APB2ENR), 12 },
+    { TIM15_BASE, offsetof(RCC_TypeDef, APB2ENR), 16 },
+    { TIM16_BASE, offsetof(RCC_TypeDef, APB2ENR), 17 },
+    { DMA1_BASE,  offsetof(RCC_TypeDef, AHB1ENR), 0 },
+    { GPIOA_BASE, offsetof(RCC_TypeDef, AHB2ENR), 0 },
+    { GPIOB_BASE, offsetof(RCC_TypeDef, AHB2ENR), 1 },
+    { ADC1_BASE,  offsetof(RCC_TypeDef, AHB2ENR), 13 },
+};
+
+static int clockOn(uintptr_t addr) {
+    for (size_t i = 0; i < sizeof(gates) / sizeof(gates[0]); i++) {
+        if (addr - gates[i].base < 0x400) {
+            return (SREG(RCC_BASE + gates[i].enr) >> gates[i].bit) & 1;
+        }
+    }
+    return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Register names for the reports
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    size_t offset;
+    const char* name;
+} Field;
+
+#define F(type, reg) { offsetof(type, reg), #reg }
+#define END          { 0, NULL }
+
+static const Field timFields[] = {
+    F(TIM_TypeDef, CR1), F(TIM_TypeDef, CR2), F(TIM_TypeDef, SMCR), F(TIM_TypeDef, DIER),
+    F(TIM_TypeDef, SR), F(TIM_TypeDef, EGR), F(TIM_TypeDef, CCMR1), F(TIM_TypeDef, CCMR2),
+    F(TIM_TypeDef, CCER), F(TIM_TypeDef, CNT), F(TIM_TypeDef, PSC), F(TIM_TypeDef, ARR),
+    F(TIM_TypeDef, RCR), F(TIM_TypeDef, CCR1), F(TIM_TypeDef, CCR2), F(TIM_TypeDef, BDTR),
+    F(TIM_TypeDef, DCR), F(TIM_TypeDef, DMAR), END
+};
+static const Field adcFields[] = {
+    F(ADC_TypeDef, ISR), F(ADC_TypeDef, IER), F(ADC_TypeDef, CR), F(ADC_TypeDef, CFGR),
+    F(ADC_TypeDef, SMPR1), F(ADC_TypeDef, SMPR2), F(ADC_TypeDef, SQR1), F(ADC_TypeDef, DR),
+    F(ADC_TypeDef, CALFACT), END
+};
+static const Field adcCommonFields[] = {
+    F(ADC_Common_TypeDef, CSR), F(ADC_Common_TypeDef, CCR), END
+};
+static const Field dmaFields[] = {
+    F(DMA_TypeDef, ISR), F(DMA_TypeDef, IFCR), { 0xA8, "CSELR" }, END
+};
+static const Field chanFields[] = {
+    F(DMA_Channel_TypeDef, CCR), F(DMA_Channel_TypeDef, CNDTR),
+    F(DMA_Channel_TypeDef, CPAR), F(DMA_Channel_TypeDef, CMAR), END
+};
+static const Field rccFields[] = {
+    F(RCC_TypeDef, CR), F(RCC_TypeDef, CFGR), F(RCC_TypeDef, PLLCFGR), F(RCC_TypeDef, AHB1ENR),
+    F(RCC_TypeDef, AHB2ENR), F(RCC_TypeDef, APB1ENR1), F(RCC_TypeDef, APB2ENR),
+    F(RCC_TypeDef, CCIPR), END
+};
+static const Field flashFields[] = { F(FLASH_TypeDef, ACR), F(FLASH_TypeDef, SR), END };
+static const Field pwrFields[] = { F(PWR_TypeDef, CR1), F(PWR_TypeDef, SR2), END };
+static const Field gpioFields[] = {
+    F(GPIO_TypeDef, MODER), F(GPIO_TypeDef, OTYPER), F(GPIO_TypeDef, OSPEEDR),
+    F(GPIO_TypeDef, PURPDR), F(GPIO_TypeDef, IDR), F(GPIO_TypeDef, ODR), F(GPIO_TypeDef, BSRR),
+    F(GPIO_TypeDef, AFRL), F(GPIO_TypeDef, AFRH), END
+};
+static const Field spiFields[] = {
+    F(SPI_TypeDef, CR1), F(SPI_TypeDef, CR2), F(SPI_TypeDef, SR), F(SPI_TypeDef, DR), END
+};
+static const Field usartFields[] = {
+    F(USART_TypeDef, CR1), F(USART_TypeDef, CR2), F(USART_TypeDef, CR3), F(USART_TypeDef, BRR),
+    F(USART_TypeDef, ISR), F(USART_TypeDef, ICR), F(USART_TypeDef, RDR),
+    F(USART_TypeDef, TDR), END
+};
+static const Field dwtFields[] = { F(DWT_TypeDef, CTRL), F(DWT_TypeDef, CYCCNT), END };
+static const Field debugFields[] = { F(CoreDebug_TypeDef, DEMCR), END };
+static const Field nvicFields[] = { { 0x00, "ISER0" }, { 0x80, "ICER0" }, END };
+static const Field scbFields[] = { { 0x88, "CPACR" }, END };
+
+static const struct {
+    uintptr_t base;
+    const char* name;
+    const Field* fields;
+} periphs[] = {
+    { TIM1_BASE, "TIM1", timFields },   { TIM2_BASE, "TIM2", timFields },
+    { TIM15_BASE, "TIM15", timFields }, { TIM16_BASE, "TIM16", timFields },
+    { ADC1_BASE, "ADC1", adcFields },   { ADC_COMMON_BASE, "ADC_COMMON", adcCommonFields },
+    { DMA1_BASE, "DMA1", dmaFields },
+    { DMA1_Channel1_BASE, "DMA1_Channel1", chanFields },
+    { DMA1_Channel3_BASE, "DMA1_Channel3", chanFields },
+    { DMA1_Channel6_BASE, "DMA1_Channel6", chanFields },
+    { DMA1_Channel7_BASE, "DMA1_Channel7", chanFields },
+    { RCC_BASE, "RCC", rccFields },     { FLASH_BASE, "FLASH", flashFields },
+    { PWR_BASE, "PWR", pwrFields },
+    { GPIOA_BASE, "GPIOA", gpioFields }, { GPIOB_BASE, "GPIOB", gpioFields },
+    { SPI1_BASE, "SPI1", spiFields },   { DWT_BASE, "DWT", dwtFields },
+    { USART2_BASE, "USART2", usartFields },
+    { COREDEBUG_BASE, "COREDEBUG", debugFields },
+    { NVIC_BASE, "NVIC", nvicFields },  { SCB_BASE, "SCB", scbFields },
+};
+
+static const char* regName(uintptr_t addr) {
+    static char name[40];
+    for (size_t p = 0; p < sizeof(periphs) / sizeof(periphs[0]); p++) {
+        for (const Field* f = periphs[p].fields; f->name; f++) {
+            if (periphs[p].base + f->offset == addr) {
+                snprintf(name, sizeof(name), "%s->%s", periphs[p].name, f->name);
+                return name;
+            }
+        }
+    }
+    snprintf(name, sizeof(name), "0x%08lX", (unsigned long)addr);
+    return name;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Counters and violations
+///////////////////////////////////////////////////////////////////////////////
+
+static uint32_t readCount[NUM_PAGES][WORDS_PER_PAGE];
+static uint32_t writeCount[NUM_PAGES][WORDS_PER_PAGE];
+static uint32_t ignoredCount[NUM_PAGES][WORDS_PER_PAGE];
+static MockCounts totals;
+
+static struct {
+    uintptr_t addr;
+    const char* what;
+} violation[MAX_VIOLATIONS];
+static int numViolations = 0;
+static int numStored = 0;
+
+static void violate(uintptr_t addr, const char* what) {
+    for (int i = 0; i < numStored; i++) {
+        if (violation[i].addr == addr && violation[i].what == what) return;
+    }
+    numViolations++;
+    if (numStored < MAX_VIOLATIONS) {
+        violation[numStored].addr = addr;
+        violation[numStored].what = what;
+        numStored++;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Model state
+///////////////////////////////////////////////////////////////////////////////
+
+static uint64_t now;                    // mock CPU cycles
+
+static MockAdcSource adcSource;
+static void* adcCtx;
+static uint32_t adcRate;
+static uint32_t adcIndex;
+static uint64_t adcNext;
+
+typedef struct {
+    uint32_t reload;
+    uint32_t pos;
+} DmaChannel;
+
+static DmaChannel dma[8];               // 1-7
+
+typedef struct {
+    uintptr_t base;
+    int irq;            // update interrupt line
+    int hasRep;         // repetition counter (TIM1/15/16)
+    uint32_t mask;      // counter width
+    int dmaChannel;     // TIMx_UP request, 0 = not modelled
+    int dmaRequest;
+    uint32_t psc, arr, ccr1, ccr2, rcr;
+    uint32_t rep;
+    uint64_t start;     // mock cycle of CNT = 0, running
+    uint32_t cnt;       // CNT, stopped
+    uint32_t updates;
+} Timer;
+
+static Timer timers[] = {
+    { .base = TIM2_BASE,  .irq = 28, .hasRep = 0, .mask = 0xFFFFFFFFUL },
+    { .base = TIM1_BASE,  .irq = 25, .hasRep = 1, .mask = 0xFFFF },
+    { .base = TIM15_BASE, .irq = 24, .hasRep = 1, .mask = 0xFFFF },
+    { .base = TIM16_BASE, .irq = 25, .hasRep = 1, .mask = 0xFFFF,
+      .dmaChannel = 6, .dmaRequest = DMA_REQUEST_TIM16_UP },
+};
+
+#define NUM_TIMERS  (sizeof(timers) / sizeof(timers[0]))
+
+static uint8_t spiLog[8192];
+static size_t spiLen;
+static uint32_t spiFrames;
+static size_t spiLenAtSelect;
+static uint64_t spiNext;
+static int spiDmaOn;
+
+static uint8_t usartLog[8192];
+static size_t usartLen;
+static uint64_t usartNext;
+static int usartDmaOn;
+static uint8_t usartRx[8192];
+static size_t usartRxLen;
+static size_t usartRxPos;
+
+static uint32_t cycOffset;
+
+static void (*irqHandler[64])(void);
+
+///////////////////////////////////////////////////////////////////////////////
+// DMA
+///////////////////////////////////////////////////////////////////////////////
+
+// One request from a peripheral. Moves *data to (periph -> mem) or from
+// (mem -> periph) memory and runs the counters. Returns 0 if the channel
+// does not take the request.
+static int dmaTransfer(int ch, int request, uint32_t* data) {
+    DMA_Channel_TypeDef* c = schan(ch);
+    if (!clockOn(DMA1_BASE) || !(c->CCR & 1) || c->CNDTR == 0) return 0;
+    if (((S_CSELR->CSELR >> (4 * (ch - 1))) & 0xF) != (uint32_t)request) return 0;
+
+    uint32_t size = 1u << ((c->CCR >> 10) & 3);
+    uint32_t step = (c->CCR & (1 << 7)) ? dma[ch].pos * size : 0;
+    uint8_t* mem = (uint8_t*)(uintptr_t)(c->CMAR + step);
+
+    if (c->CCR & (1 << 4)) {
+        *data = 0;
+        memcpy(data, mem, size);
+    } else {
+        memcpy(mem, data, size);
+    }
+
+    dma[ch].pos++;
+    c->CNDTR = c->CNDTR - 1;
+
+    uint32_t shift = 4 * (ch - 1);
+    if (c->CNDTR == dma[ch].reload / 2) S_DMA->ISR |= (0x5u << shift);     // HTIF + GIF
+    if (c->CNDTR == 0) {
+        S_DMA->ISR |= (0x3u << shift);                                      // TCIF + GIF
+        if (c->CCR & (1 << 5)) {
+            c->CNDTR = dma[ch].reload;
+            dma[ch].pos = 0;
+        }
+    }
+    return 1;
+}
+
+static void dmaWrite(uintptr_t reg, uint32_t old, uint32_t val) {
+    uint32_t off = reg - DMA1_BASE;
+
+    if (off == offsetof(DMA_TypeDef, ISR)) {
+        S_DMA->ISR = old;                       // read only
+        return;
+    }
+    if (off == offsetof(DMA_TypeDef, IFCR)) {
+        for (int ch = 1; ch <= 7; ch++) {
+            uint32_t shift = 4 * (ch - 1);
+            // CGIF clears the whole channel
+            uint32_t clear = (val >> shift) & 1 ? 0xF : (val >> shift) & 0xF;
+            S_DMA->ISR &= ~(clear << shift);
+        }
+        S_DMA->IFCR = 0;
+        return;
+    }
+    if (off < 8 || off >= 8 + 7 * 0x14) return; // CSELR
+
+    int ch = (off - 8) / 0x14 + 1;
+    uint32_t field = (off - 8) % 0x14;
+    DMA_Channel_TypeDef* c = schan(ch);
+    int enabled = old & 1;
+
+    if (field == offsetof(DMA_Channel_TypeDef, CCR)) {
+        c->CCR &= 0x7FFF;
+        if (enabled && (val & 1) && ((old ^ val) & 0x7FFE)) {
+            violate(reg, "reconfigured while the channel is enabled");
+            c->CCR = old;
+        } else if (!enabled && (val & 1)) {
+            dma[ch].reload = c->CNDTR;
+            dma[ch].pos = 0;
+        }
+        return;
+    }
+
+    // CNDTR, CPAR, CMAR only take writes while the channel is off
+    if (schan(ch)->CCR & 1) {
+        violate(reg, "written while the channel is enabled");
+        SREG(reg) = old;
+        return;
+    }
+    if (field == offsetof(DMA_Channel_TypeDef, CNDTR)) c->CNDTR &= 0xFFFF;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ADC
+///////////////////////////////////////////////////////////////////////////////
+
+#define ADC_ADRDY   (1u << 0)
+#define ADC_EOC     (1u << 2)
+#define ADC_EOS     (1u << 3)
+#define ADC_OVR     (1u << 4)
+#define ADC_ADEN    (1u << 0)
+#define ADC_ADDIS   (1u << 1)
+#define ADC_ADSTART (1u << 2)
+#define ADC_ADSTP   (1u << 4)
+#define ADC_ADVREGEN (1u << 28)
+#define ADC_DEEPPWD (1u << 29)
+#define ADC_ADCAL   (1u << 31)
+#define ADC_DMAEN   (1u << 0)
+#define ADC_OVRMOD  (1u << 12)
+#define ADC_CONT    (1u << 13)
+
+static uint64_t adcPeriod(void) {
+    return adcRate ? MOCK_CPU_HZ / adcRate : MOCK_CPU_HZ;
+}
+
+static int adcRunning(void) {
+    uint32_t cr = S_ADC->CR;
+    return clockOn(ADC1_BASE) && (cr & ADC_ADEN) && (cr & ADC_ADSTART);
+}
+
+static void adcConvert(void) {
+    uint16_t v = adcSource ? adcSource(adcIndex, adcCtx) : 2048;
+    adcIndex++;
+
+    if (S_ADC->ISR & ADC_EOC) {
+        S_ADC->ISR |= ADC_OVR;
+        if (S_ADC->CFGR & ADC_OVRMOD) S_ADC->DR = v & 0xFFF;
+    } else {
+        S_ADC->DR = v & 0xFFF;
+    }
+    S_ADC->ISR |= ADC_EOC | ADC_EOS;
+
+    if (S_ADC->CFGR & ADC_DMAEN) {
+        uint32_t data = S_ADC->DR;
+        if (schan(1)->CPAR != ADC1_BASE + offsetof(ADC_TypeDef, DR) && (schan(1)->CCR & 1)) {
+            violate(DMA1_Channel1_BASE + 8, "CPAR is not ADC1->DR");
+        }
+        if (dmaTransfer(1, DMA_REQUEST_ADC1, &data)) S_ADC->ISR &= ~ADC_EOC;
+    }
+
+    if (!(S_ADC->CFGR & ADC_CONT)) S_ADC->CR &= ~ADC_ADSTART;
+}
+
+static void adcRead(uintptr_t reg) {
+    uint32_t off = reg - ADC1_BASE;
+
+    // Polled conversions (no DMA) complete when someone looks for them
+    if (off == offsetof(ADC_TypeDef, ISR) && adcRunning() &&
+        !(S_ADC->CFGR & ADC_DMAEN) && !(S_ADC->ISR & ADC_EOC)) {
+        if (now < adcNext) now = adcNext;
+        adcNext = now + adcPeriod();
+        adcConvert();
+    }
+    if (off == offsetof(ADC_TypeDef, DR)) S_ADC->ISR &= ~ADC_EOC;
+}
+
+static void adcWrite(uintptr_t reg, uint32_t old, uint32_t val) {
+    uint32_t off = reg - ADC1_BASE;
+
+    if (off == offsetof(ADC_TypeDef, ISR)) {
+        S_ADC->ISR = old & ~val;                // write 1 to clear
+        return;
+    }
+    if (off == offsetof(ADC_TypeDef, CFGR) && (old != val) && (S_ADC->CR & ADC_ADSTART)) {
+        violate(reg, "written while conversions run");
+        return;
+    }
+    if (off != offsetof(ADC_TypeDef, CR)) return;
+
+    uint32_t cr = val;
+    int regulatorOn = (cr & ADC_ADVREGEN) && !(cr & ADC_DEEPPWD);
+
+    if ((cr & ADC_ADCAL) && !(old & ADC_ADCAL)) {
+        if (old & ADC_ADEN) violate(reg, "ADCAL with ADEN set");
+        if (!regulatorOn) violate(reg, "ADCAL with the regulator off");
+        S_ADC->CALFACT = 0x40;
+        cr &= ~ADC_ADCAL;                       // calibration done
+    }
+    if (cr & ADC_ADDIS) {
+        cr &= ~(ADC_ADEN | ADC_ADDIS | ADC_ADSTART);
+    }
+    if ((cr & ADC_ADEN) && !(old & ADC_ADEN)) {
+        if (!regulatorOn) violate(reg, "ADEN with the regulator off");
+        S_ADC->ISR |= ADC_ADRDY;
+    }
+    if ((cr & ADC_ADSTART) && !(old & ADC_ADSTART)) {
+        if (!(cr & ADC_ADEN)) {
+            violate(reg, "ADSTART with the ADC disabled");
+            cr &= ~ADC_ADSTART;
+        } else {
+            adcNext = now + adcPeriod();
+        }
+    }
+    if (cr & ADC_ADSTP) {
+        cr &= ~(ADC_ADSTP | ADC_ADSTART);
+    }
+    S_ADC->CR = cr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Timers
+///////////////////////////////////////////////////////////////////////////////
+
+#define TIM_CEN     (1u << 0)
+#define TIM_UDIS    (1u << 1)
+#define TIM_URS     (1u << 2)
+#define TIM_ARPE    (1u << 7)
+#define TIM_UDE     (1u << 8)
+
+static Timer* timerAt(uintptr_t addr) {
+    for (size_t i = 0; i < NUM_TIMERS; i++) {
+        if (addr - timers[i].base < 0x400) return &timers[i];
+    }
+    return NULL;
+}
+
+static TIM_TypeDef* stim(const Timer* t) {
+    return (TIM_TypeDef*)sptr(t->base);
+}
+
+static uint64_t timerTick(const Timer* t) {
+    return (uint64_t)t->psc + 1;
+}
+
+static uint64_t timerPeriod(const Timer* t) {
+    return timerTick(t) * ((uint64_t)t->arr + 1);
+}
+
+static int timerRunning(const Timer* t) {
+    return (stim(t)->CR1 & TIM_CEN) && clockOn(t->base);
+}
+
+static uint32_t timerCount(const Timer* t) {
+    if (!timerRunning(t)) return t->cnt;
+    return (uint32_t)((now - t->start) / timerTick(t));
+}
+
+static void timerWrite(Timer* t, uintptr_t reg, uint32_t old, uint32_t val);
+
+// TIMx_UP DMA burst: DBL + 1 words into the registers from DBA on
+static void timerBurst(Timer* t) {
+    TIM_TypeDef* s = stim(t);
+    DMA_Channel_TypeDef* c = schan(t->dmaChannel);
+    uint32_t dba = s->DCR & 0x1F;
+    uint32_t dbl = (s->DCR >> 8) & 0x1F;
+
+    if ((c->CCR & 1) && c->CPAR != t->base + offsetof(TIM_TypeDef, DMAR)) {
+        violate(DMA1_Channel1_BASE + (t->dmaChannel - 1) * 0x14 + 8, "CPAR is not the timer DMAR");
+    }
+    for (uint32_t i = 0; i <= dbl; i++) {
+        uint32_t word;
+        if (!dmaTransfer(t->dmaChannel, t->dmaRequest, &word)) break;
+        uintptr_t reg = t->base + (dba + i) * 4;
+        uint32_t old = SREG(reg);
+        SREG(reg) = word;
+        timerWrite(t, reg, old, word);
+    }
+}
+
+static void timerUpdate(Timer* t, int forced) {
+    TIM_TypeDef* s = stim(t);
+    if (!forced && (s->CR1 & TIM_UDIS)) return;
+
+    t->psc = s->PSC & 0xFFFF;
+    t->arr = s->ARR & t->mask;
+    t->ccr1 = s->CCR1 & t->mask;
+    t->ccr2 = s->CCR2 & t->mask;
+    t->rcr = s->RCR & 0xFF;
+    t->rep = t->rcr;
+    t->updates++;
+
+    if (!(forced && (s->CR1 & TIM_URS))) s->SR |= 1;   // UIF
+    if (t->dmaChannel && (s->DIER & TIM_UDE)) timerBurst(t);
+}
+
+static void timerOverflow(Timer* t) {
+    t->start += timerPeriod(t);
+    if (t->hasRep && t->rep > 0) {
+        t->rep--;
+    } else {
+        timerUpdate(t, 0);
+    }
+}
+
+static void timerRead(Timer* t, uintptr_t reg) {
+    if (reg - t->base == offsetof(TIM_TypeDef, CNT)) stim(t)->CNT = timerCount(t);
+}
+
+static void timerWrite(Timer* t, uintptr_t reg, uint32_t old, uint32_t val) {
+    TIM_TypeDef* s = stim(t);
+
+    switch (reg - t->base) {
+    case offsetof(TIM_TypeDef, CR1):
+        if ((val & TIM_CEN) && !(old & TIM_CEN)) {
+            t->start = now - (uint64_t)t->cnt * timerTick(t);
+        } else if (!(val & TIM_CEN) && (old & TIM_CEN)) {
+            s->CR1 = old;
+            t->cnt = timerCount(t);
+            s->CR1 = val;
+        }
+        break;
+    case offsetof(TIM_TypeDef, SR):
+        s->SR = old & val;                      // write 0 to clear
+        break;
+    case offsetof(TIM_TypeDef, EGR):
+        if (val & 1) {
+            t->cnt = 0;
+            t->start = now;
+            timerUpdate(t, 1);
+        }
+        s->EGR = 0;
+        break;
+    case offsetof(TIM_TypeDef, CNT):
+        t->cnt = val & t->mask;
+        t->start = now - (uint64_t)t->cnt * timerTick(t);
+        break;
+    case offsetof(TIM_TypeDef, ARR):
+        if (!(s->CR1 & TIM_ARPE)) t->arr = val & t->mask;
+        break;
+    case offsetof(TIM_TypeDef, CCR1):
+        if (!(s->CCMR1 & (1 << 3))) t->ccr1 = val & t->mask;
+        break;
+    case offsetof(TIM_TypeDef, CCR2):
+        if (!(s->CCMR1 & (1 << 11))) t->ccr2 = val & t->mask;
+        break;
+    default:
+        break;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SPI1, GPIO, RCC, core
+///////////////////////////////////////////////////////////////////////////////
+
+static void spiPush(uint8_t byte) {
+    if (spiLen < sizeof(spiLog)) spiLog[spiLen++] = byte;
+}
+
+static uint64_t spiByteCycles(void) {
+    // f = fPCLK / 2^(BR + 1), 8 bits
+    return 8ULL << (((S_SPI->CR1 >> 3) & 7) + 1);
+}
+
+static void spiWrite(uintptr_t reg, uint32_t old, uint32_t val) {
+    switch (reg - SPI1_BASE) {
+    case offsetof(SPI_TypeDef, DR):
+        if (!(S_SPI->CR1 & (1 << 6))) violate(reg, "written with SPE off");
+        spiPush((uint8_t)val);
+        S_SPI->SR |= 1;                         // RXNE, loopback
+        break;
+    case offsetof(SPI_TypeDef, SR):
+        S_SPI->SR = old;
+        break;
+    case offsetof(SPI_TypeDef, CR2):
+        if ((val & 2) && !(old & 2)) {
+            spiDmaOn = 1;
+            spiNext = now + spiByteCycles();
+        } else if (!(val & 2)) {
+            spiDmaOn = 0;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void spiRead(uintptr_t reg) {
+    if (reg - SPI1_BASE == offsetof(SPI_TypeDef, DR)) S_SPI->SR &= ~1u;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// USART2
+///////////////////////////////////////////////////////////////////////////////
+
+#define USART_UE    (1u << 0)
+#define USART_RE    (1u << 2)
+#define USART_TE    (1u << 3)
+#define USART_OVER8 (1u << 15)
+#define USART_DMAT  (1u << 7)
+#define USART_TC    (1u << 6)
+#define USART_TXE   (1u << 7)
+#define USART_TEACK (1u << 21)
+#define USART_RXNE  (1u << 5)
+
+static void usartPush(uint8_t byte) {
+    if (usartLen < sizeof(usartLog)) usartLog[usartLen++] = byte;
+}
+
+static uint64_t usartByteCycles(void) {
+    // 16x oversampling: one bit = BRR kernel clocks, start + 8 + stop
+    return 10ULL * (S_USART->BRR ? S_USART->BRR : 1);
+}
+
+static void usartWrite(uintptr_t reg, uint32_t old, uint32_t val) {
+    switch (reg - USART2_BASE) {
+    case offsetof(USART_TypeDef, CR1):
+        if ((old & USART_UE) && (val & USART_UE) && ((old ^ val) & USART_OVER8)) {
+            violate(reg, "OVER8 changed with UE set");
+        }
+        S_USART->ISR = (S_USART->ISR & ~USART_TEACK) | ((val & USART_TE) ? USART_TEACK : 0);
+        break;
+    case offsetof(USART_TypeDef, BRR):
+        if (old != val && (S_USART->CR1 & USART_UE)) violate(reg, "written with UE set");
+        if ((val & 0xFFFF) < 16) violate(reg, "below 16 with 16x oversampling");
+        break;
+    case offsetof(USART_TypeDef, CR3):
+        if ((val & USART_DMAT) && !(old & USART_DMAT)) {
+            usartDmaOn = 1;
+            usartNext = now + usartByteCycles();
+        } else if (!(val & USART_DMAT)) {
+            usartDmaOn = 0;
+        }
+        break;
+    case offsetof(USART_TypeDef, TDR):
+        if ((S_USART->CR1 & (USART_UE | USART_TE)) != (USART_UE | USART_TE)) {
+            violate(reg, "written with UE or TE off");
+        }
+        usartPush((uint8_t)val);
+        break;
+    case offsetof(USART_TypeDef, ISR):
+        S_USART->ISR = old;                     // read only
+        break;
+    case offsetof(USART_TypeDef, ICR):
+        S_USART->ISR &= ~(val & 0x00121B5F);
+        S_USART->ISR |= USART_TXE;              // the line is always idle again
+        S_USART->ICR = 0;
+        break;
+    default:
+        break;
+    }
+}
+
+static void usartRead(uintptr_t reg) {
+    int ready = (S_USART->CR1 & (USART_UE | USART_RE)) == (USART_UE | USART_RE) &&
+                usartRxPos < usartRxLen;
+
+    if (reg == USART2_BASE + offsetof(USART_TypeDef, RDR) && ready) {
+        S_USART->RDR = usartRx[usartRxPos++];
+        ready = usartRxPos < usartRxLen;
+    }
+    S_USART->ISR = (S_USART->ISR & ~USART_RXNE) | (ready ? USART_RXNE : 0);
+}
+
+static void gpioWrite(uintptr_t reg, uint32_t old, uint32_t val) {
+    uint32_t off = reg - GPIOA_BASE;
+    uint32_t odrBefore = S_GPIOA->ODR;
+
+    if (off == offsetof(GPIO_TypeDef, BSRR)) {
+        S_GPIOA->ODR = (S_GPIOA->ODR | (val & 0xFFFF)) & ~(val >> 16);
+        S_GPIOA->BSRR = 0;
+    } else if (off == offsetof(GPIO_TypeDef, ODR)) {
+        odrBefore = old;
+    } else {
+        return;
+    }
+    // A frame is CS low, at least one byte, CS high
+    uint32_t odr = S_GPIOA->ODR;
+    if ((odrBefore & SPI_CS_BIT) && !(odr & SPI_CS_BIT)) spiLenAtSelect = spiLen;
+    if (!(odrBefore & SPI_CS_BIT) && (odr & SPI_CS_BIT) && spiLen > spiLenAtSelect) spiFrames++;
+}
+
+// HCLK from the switch status: MSI (4 MHz reset range), HSI16, or the PLL
+// from either. AHB prescaler 1, HSE not modelled.
+static uint32_t hclkHz(void) {
+    uint32_t pll = S_RCC->PLLCFGR;
+    uint64_t in = (pll & 3) == 2 ? 16000000UL : 4000000UL;
+
+    switch ((S_RCC->CFGR >> 2) & 3) {
+    case 1: return 16000000UL;
+    case 3: return (uint32_t)(in * ((pll >> 8) & 0x7F) / (((pll >> 4) & 7) + 1) /
+                              ((((pll >> 25) & 3) + 1) * 2));
+    default: return 4000000UL;
+    }
+}
+
+// Fewest flash wait states for hz (RM0394 table 9), 8 if the range can't run it
+static int waitStatesFor(uint32_t hz, int range2) {
+    static const uint32_t range1Mhz[] = { 16, 32, 48, 64, 80 };
+    static const uint32_t range2Mhz[] = { 6, 12, 18, 26 };
+    const uint32_t* limit = range2 ? range2Mhz : range1Mhz;
+    int n = range2 ? 4 : 5;
+
+    for (int ws = 0; ws < n; ws++) {
+        if (hz <= limit[ws] * 1000000UL) return ws;
+    }
+    return 8;
+}
+
+// After every write to RCC->CFGR, FLASH->ACR and PWR->CR1: the flash must
+// keep up with HCLK in the current voltage range
+static void checkFlashTiming(uintptr_t reg) {
+    int range2 = ((S_PWR->CR1 >> 9) & 3) == 2;
+    uint32_t hz = hclkHz();
+
+    if (range2 && hz > 26000000UL) violate(reg, "HCLK above 26 MHz in voltage range 2");
+    else if ((int)(S_FLASH->ACR & 7) < waitStatesFor(hz, range2)) {
+        violate(reg, "too few flash wait states for HCLK");
+    }
+}
+
+static void flashWrite(uintptr_t reg, uint32_t old, uint32_t val) {
+    (void)old;
+    if (reg != FLASH_BASE + offsetof(FLASH_TypeDef, ACR)) return;
+    if (((val >> 11) & 1) && ((val >> 9) & 1)) violate(reg, "ICRST with the I-cache on");
+    if (((val >> 12) & 1) && ((val >> 10) & 1)) violate(reg, "DCRST with the D-cache on");
+    checkFlashTiming(reg);
+}
+
+static void pwrWrite(uintptr_t reg, uint32_t old, uint32_t val) {
+    (void)old;
+    (void)val;
+    if (reg == PWR_BASE + offsetof(PWR_TypeDef, CR1)) checkFlashTiming(reg);
+}
+
+static void rccWrite(uintptr_t reg, uint32_t old, uint32_t val) {
+    RCC_TypeDef* r = S_RCC;
+
+    switch (reg - RCC_BASE) {
+    case offsetof(RCC_TypeDef, CR): {
+        uint32_t cr = val & ~((1u << 1) | (1u << 10) | (1u << 25));
+        if (cr & (1u << 0)) cr |= (1u << 1);    // MSIRDY
+        if (cr & (1u << 8)) cr |= (1u << 10);   // HSIRDY
+        if (cr & (1u << 24)) cr |= (1u << 25);  // PLLRDY
+        r->CR = cr;
+        break;
+    }
+    case offsetof(RCC_TypeDef, CFGR):
+        r->CFGR = (val & ~(3u << 2)) | ((val & 3u) << 2);   // SWS = SW
+        checkFlashTiming(reg);
+        break;
+    case offsetof(RCC_TypeDef, PLLCFGR):
+        if ((r->CR & (1u << 24)) && old != val) violate(reg, "written while the PLL runs");
+        break;
+    default:
+        break;
+    }
+}
+
+static void coreWrite(uintptr_t reg, uint32_t old, uint32_t val) {
+    if (reg - NVIC_BASE < 0x20) {
+        SREG(reg) = old | val;                  // ISER: 1 enables
+    } else if (reg - (NVIC_BASE + 0x80) < 0x20) {
+        SREG(reg - 0x80) &= ~val;               // ICER: 1 disables
+        SREG(reg) = SREG(reg - 0x80);
+    } else if (reg - DWT_BASE < 0x20 && !(S_COREDEBUG->DEMCR & (1u << 24))) {
+        SREG(reg) = old;                        // DWT ignores writes without TRCENA
+        violate(reg, "written with TRCENA off");
+    } else if (reg == DWT_BASE + offsetof(DWT_TypeDef, CYCCNT)) {
+        cycOffset = val - (uint32_t)now;
+    } else if (reg == DWT_BASE && (val & 1) && !(old & 1)) {
+        cycOffset = S_DWT->CYCCNT - (uint32_t)now;  // CYCCNTENA, count on from here
+    }
+}
+
+static void coreRead(uintptr_t reg) {
+    if (reg == DWT_BASE + offsetof(DWT_TypeDef, CYCCNT) &&
+        (S_COREDEBUG->DEMCR & (1u << 24)) && (S_DWT->CTRL & 1)) {
+        S_DWT->CYCCNT = (uint32_t)now + cycOffset;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Access dispatch
+///////////////////////////////////////////////////////////////////////////////
+
+static void modelRead(uintptr_t reg) {
+    Timer* t = timerAt(reg);
+    if (t) timerRead(t, reg);
+    else if (reg - ADC1_BASE < 0x100) adcRead(reg);
+    else if (reg - SPI1_BASE < 0x400) spiRead(reg);
+    else if (reg - USART2_BASE < 0x400) usartRead(reg);
+    else if (reg >= 0xE0000000UL) coreRead(reg);
+}
+
+static void modelWrite(int page, uintptr_t reg, uint32_t old, uint32_t val) {
+    if (!clockOn(reg)) {
+        SREG(reg) = old;
+        ignoredCount[page][(reg & (PAGE - 1)) / 4]++;
+        totals.ignored++;
+        if (old != val) violate(reg, "written with its clock off");
+        return;
+    }
+
+    Timer* t = timerAt(reg);
+    if (t) timerWrite(t, reg, old, val);
+    else if (reg - ADC1_BASE < 0x100) adcWrite(reg, old, val);
+    else if (reg - DMA1_BASE < 0x400) dmaWrite(reg, old, val);
+    else if (reg - SPI1_BASE < 0x400) spiWrite(reg, old, val);
+    else if (reg - USART2_BASE < 0x400) usartWrite(reg, old, val);
+    else if (reg - GPIOA_BASE < 0x400) gpioWrite(reg, old, val);
+    else if (reg - RCC_BASE < 0x400) rccWrite(reg, old, val);
+    else if (reg - FLASH_BASE < 0x400) flashWrite(reg, old, val);
+    else if (reg - PWR_BASE < 0x400) pwrWrite(reg, old, val);
+    else if (reg >= 0xE0000000UL) coreWrite(reg, old, val);
+}
+
+static struct {
+    int active;
+    int page;
+    uintptr_t reg;
+    int write;
+    uint32_t old;
+} step;
+
+static uintptr_t pollReg;
+static unsigned long pollCount;
+
+static void stuck(uintptr_t reg) {
+    char msg[96];
+    int n = snprintf(msg, sizeof(msg), "periph_mock: stuck polling %s\n", regName(reg));
+    if (write(STDERR_FILENO, msg, n) < 0) {}
+    _exit(3);
+}
+
+static void onFault(int sig, siginfo_t* si, void* context) {
+    ucontext_t* uc = context;
+    uintptr_t addr = (uintptr_t)si->si_addr;
+    int page = pageOf(addr);
+    (void)sig;
+
+    if (page < 0 || step.active) {
+        // A real crash, let it happen
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+
+    uintptr_t reg = addr & ~(uintptr_t)3;
+    int word = (reg & (PAGE - 1)) / 4;
+    int isWrite = (uc->uc_mcontext.gregs[REG_ERR] & PF_WRITE) != 0;
+
+    if (isWrite) {
+        writeCount[page][word]++;
+        totals.writes++;
+        step.old = SREG(reg);
+        pollCount = 0;
+    } else {
+        readCount[page][word]++;
+        totals.reads++;
+        if (reg == pollReg) {
+            if (++pollCount > POLL_LIMIT) stuck(reg);
+        } else {
+            pollReg = reg;
+            pollCount = 1;
+        }
+        modelRead(reg);
+    }
+
+    step.active = 1;
+    step.page = page;
+    step.reg = reg;
+    step.write = isWrite;
+    mprotect((void*)pageBase[page], PAGE, PROT_READ | PROT_WRITE);
+    uc->uc_mcontext.gregs[REG_EFL] |= TRAP_FLAG;
+}
+
+static void onStep(int sig, siginfo_t* si, void* context) {
+    ucontext_t* uc = context;
+    (void)si;
+
+    if (!step.active) {
+        signal(sig, SIG_DFL);
+        raise(sig);
+        return;
+    }
+
+    uc->uc_mcontext.gregs[REG_EFL] &= ~TRAP_FLAG;
+    mprotect((void*)pageBase[step.page], PAGE, PROT_NONE);
+    step.active = 0;
+    if (step.write) modelWrite(step.page, step.reg, step.old, SREG(step.reg));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Interrupts and time
+///////////////////////////////////////////////////////////////////////////////
+
+static int irqPending(int irq) {
+    if (irq >= 11 && irq <= 17) {
+        int ch = irq - 10;
+        uint32_t flags = (S_DMA->ISR >> (4 * (ch - 1))) & 0xE;
+        return (flags & schan(ch)->CCR) != 0;
+    }
+    if (irq == 18) return (S_ADC->ISR & S_ADC->IER & 0x7FF) != 0;
+
+    for (size_t i = 0; i < NUM_TIMERS; i++) {
+        TIM_TypeDef* s = stim(&timers[i]);
+        if (timers[i].irq == irq && (s->SR & s->DIER & 0x7F)) return 1;
+    }
+    return 0;
+}
+
+static void serviceIrqs(void) {
+    static const int lines[] = { 11, 12, 13, 14, 15, 16, 17, 18, 24, 25, 28 };
+
+    for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+        int irq = lines[i];
+        if (!((S_NVIC_ISER[irq / 32] >> (irq % 32)) & 1)) continue;
+
+        // Level triggered: the handler runs until it clears its flag
+        for (int round = 0; irqPending(irq); round++) {
+            if (!irqHandler[irq]) {
+                violate(NVIC_BASE, "enabled interrupt without a handler");
+                break;
+            }
+            if (round == 16) {
+                violate(NVIC_BASE, "interrupt flag never cleared by its handler");
+                break;
+            }
+            irqHandler[irq]();
+        }
+    }
+}
+
+void mockAdvanceCycles(uint64_t cycles) {
+    uint64_t end = now + cycles;
+
+    for (;;) {
+        uint64_t next = end + 1;
+        int what = -1;
+
+        if (adcRunning() && adcNext < next) {
+            next = adcNext;
+            what = 0;
+        }
+        if (spiDmaOn && spiNext < next) {
+            next = spiNext;
+            what = 1;
+        }
+        if (usartDmaOn && usartNext < next) {
+            next = usartNext;
+            what = 2;
+        }
+        for (size_t i = 0; i < NUM_TIMERS; i++) {
+            if (!timerRunning(&timers[i])) continue;
+            uint64_t t = timers[i].start + timerPeriod(&timers[i]);
+            if (t < next) {
+                next = t;
+                what = 3 + (int)i;
+            }
+        }
+        if (what < 0) break;
+
+        now = next;
+        if (what == 0) {
+            adcNext = now + adcPeriod();
+            adcConvert();
+        } else if (what == 1) {
+            uint32_t data;
+            if (schan(3)->CCR & 1 && schan(3)->CPAR != SPI1_BASE + offsetof(SPI_TypeDef, DR)) {
+                violate(DMA1_Channel3_BASE + 8, "CPAR is not SPI1->DR");
+            }
+            if (clockOn(SPI1_BASE) && dmaTransfer(3, DMA_REQUEST_SPI1_TX, &data)) {
+                spiPush((uint8_t)data);
+                spiNext = now + spiByteCycles();
+            } else {
+                spiNext = end + 1;              // nothing queued, wait for the next call
+                spiDmaOn = (S_SPI->CR2 & 2) != 0 && (schan(3)->CCR & 1) && schan(3)->CNDTR;
+            }
+        } else if (what == 2) {
+            uint32_t data;
+            if (schan(7)->CCR & 1 && schan(7)->CPAR != USART2_BASE + offsetof(USART_TypeDef, TDR)) {
+                violate(DMA1_Channel7_BASE + 8, "CPAR is not USART2->TDR");
+            }
+            if (clockOn(USART2_BASE) && (S_USART->CR1 & USART_UE) &&
+                dmaTransfer(7, DMA_REQUEST_USART2_TX, &data)) {
+                usartPush((uint8_t)data);
+                usartNext = now + usartByteCycles();
+            } else {
+                usartNext = end + 1;
+                usartDmaOn = (S_USART->CR3 & USART_DMAT) && (schan(7)->CCR & 1) && schan(7)->CNDTR;
+            }
+        } else {
+            timerOverflow(&timers[what - 3]);
+        }
+        serviceIrqs();
+    }
+    now = end;
+    serviceIrqs();
+}
+
+void mockAdvanceUs(uint32_t us) {
+    mockAdvanceCycles((uint64_t)us * (MOCK_CPU_HZ / 1000000UL));
+}
+
+uint64_t mockCycles(void) {
+    return now;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Setup
+///////////////////////////////////////////////////////////////////////////////
+
+static uint8_t probe;
+
+int mockInit(void) {
+    if (mapped) return 0;
+
+    // DMA address registers are 32 bit, buffers have to live below 4 GB
+    if ((uintptr_t)&probe > 0xFFFFFFFFUL) {
+        fprintf(stderr, "periph_mock: build with -no-pie, statics are above 4 GB\n");
+        return -1;
+    }
+
+    int fd = memfd_create("stm32_periph", 0);
+    if (fd < 0 || ftruncate(fd, NUM_PAGES * PAGE) != 0) {
+        perror("periph_mock: memfd");
+        return -1;
+    }
+
+    shadow = mmap(NULL, NUM_PAGES * PAGE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (shadow == MAP_FAILED) {
+        perror("periph_mock: mmap");
+        return -1;
+    }
+    for (size_t i = 0; i < NUM_PAGES; i++) {
+        void* p = mmap((void*)pageBase[i], PAGE, PROT_NONE, MAP_SHARED | MAP_FIXED_NOREPLACE,
+                       fd, i * PAGE);
+        if (p != (void*)pageBase[i]) {
+            fprintf(stderr, "periph_mock: 0x%08lX is taken\n", (unsigned long)pageBase[i]);
+            return -1;
+        }
+    }
+    close(fd);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_flags = SA_SIGINFO;
+    sa.sa_sigaction = onFault;
+    sigaction(SIGSEGV, &sa, NULL);
+    sa.sa_sigaction = onStep;
+    sigaction(SIGTRAP, &sa, NULL);
+
+    mapped = 1;
+    mockReset();
+    return 0;
+}
+
+void mockReset(void) {
+    memset(shadow, 0, NUM_PAGES * PAGE);
+
+    // Reset values (RM0394) the drivers can see
+    S_RCC->CR = 0x00000063;                     // MSI on and ready, 4 MHz
+    S_RCC->PLLCFGR = 0x00001000;
+    S_RCC->AHB1ENR = 0x00000100;                // FLASHEN
+    S_FLASH->ACR = 0x00000600;                  // I-cache, D-cache, 0 wait states
+    S_PWR->CR1 = 0x00000200;                    // voltage range 1
+    S_GPIOA->MODER = 0xABFFFFFF;
+    ((GPIO_TypeDef*)sptr(GPIOB_BASE))->MODER = 0xFFFFFEBF;
+    S_ADC->CR = ADC_DEEPPWD;
+    S_SPI->CR2 = 0x0700;
+    S_SPI->SR = 0x0002;                         // TXE
+    S_USART->ISR = USART_TXE | USART_TC;
+
+    for (size_t i = 0; i < NUM_TIMERS; i++) {
+        Timer* t = &timers[i];
+        stim(t)->ARR = t->mask == 0xFFFF ? 0xFFFF : 0xFFFFFFFFUL;
+        t->psc = 0;
+        t->arr = stim(t)->ARR;
+        t->ccr1 = t->ccr2 = t->rcr = t->rep = 0;
+        t->start = 0;
+        t->cnt = 0;
+        t->updates = 0;
+    }
+
+    memset(dma, 0, sizeof(dma));
+    memset(irqHandler, 0, sizeof(irqHandler));
+    now = 0;
+    adcSource = NULL;
+    adcCtx = NULL;
+    adcRate = 8000;
+    adcIndex = 0;
+    adcNext = 0;
+    spiLen = 0;
+    spiFrames = 0;
+    spiLenAtSelect = 0;
+    spiDmaOn = 0;
+    usartLen = 0;
+    usartDmaOn = 0;
+    usartRxLen = 0;
+    usartRxPos = 0;
+    cycOffset = 0;
+    numViolations = 0;
+    numStored = 0;
+    pollReg = 0;
+    pollCount = 0;
+    mockClearCounts();
+}
+
+void mockSetAdcSource(MockAdcSource source, void* ctx) {
+    adcSource = source;
+    adcCtx = ctx;
+    adcIndex = 0;
+}
+
+void mockSetAdcRate(uint32_t hz) {
+    adcRate = hz;
+}
+
+void mockSetIrqHandler(int irq, void (*handler)(void)) {
+    if (irq >= 0 && irq < 64) irqHandler[irq] = handler;
+}
+
+uint32_t mockPeek(uintptr_t addr) {
+    return SREG(addr);
+}
+
+void mockPoke(uintptr_t addr, uint32_t value) {
+    SREG(addr) = value;
+}
+
+MockTimer mockTimer(uintptr_t base) {
+    MockTimer m = {0};
+    Timer* t = timerAt(base);
+    if (t) {
+        m.psc = t->psc;
+        m.arr = t->arr;
+        m.ccr1 = t->ccr1;
+        m.ccr2 = t->ccr2;
+        m.rcr = t->rcr;
+        m.cnt = timerCount(t);
+        m.updates = t->updates;
+        m.running = timerRunning(t);
+    }
+    return m;
+}
+
+size_t mockSpiOutput(const uint8_t** bytes) {
+    *bytes = spiLog;
+    return spiLen;
+}
+
+uint32_t mockSpiFrames(void) {
+    return spiFrames;
+}
+
+void mockSpiClear(void) {
+    spiLen = 0;
+    spiFrames = 0;
+    spiLenAtSelect = 0;
+}
+
+size_t mockUsartOutput(const uint8_t** bytes) {
+    *bytes = usartLog;
+    return usartLen;
+}
+
+void mockUsartClear(void) {
+    usartLen = 0;
+}
+
+void mockUsartInput(const uint8_t* bytes, size_t len) {
+    // Drop what has been read, keep what is still queued
+    memmove(usartRx, &usartRx[usartRxPos], usartRxLen - usartRxPos);
+    usartRxLen -= usartRxPos;
+    usartRxPos = 0;
+
+    if (len > sizeof(usartRx) - usartRxLen) len = sizeof(usartRx) - usartRxLen;
+    memcpy(&usartRx[usartRxLen], bytes, len);
+    usartRxLen += len;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Reports
+///////////////////////////////////////////////////////////////////////////////
+
+MockCounts mockCounts(void) {
+    return totals;
+}
+
+void mockClearCounts(void) {
+    memset(readCount, 0, sizeof(readCount));
+    memset(writeCount, 0, sizeof(writeCount));
+    memset(ignoredCount, 0, sizeof(ignoredCount));
+    memset(&totals, 0, sizeof(totals));
+}
+
+void mockPrintAccesses(FILE* out) {
+    static uint32_t reads[NUM_PAGES][WORDS_PER_PAGE];
+    static uint32_t writes[NUM_PAGES][WORDS_PER_PAGE];
+    memcpy(reads, readCount, sizeof(reads));
+    memcpy(writes, writeCount, sizeof(writes));
+
+    // Busiest register first
+    for (;;) {
+        uint32_t best = 0;
+        size_t bp = 0, bw = 0;
+        for (size_t p = 0; p < NUM_PAGES; p++) {
+            for (size_t w = 0; w < WORDS_PER_PAGE; w++) {
+                uint32_t n = reads[p][w] + writes[p][w];
+                if (n > best) {
+                    best = n;
+                    bp = p;
+                    bw = w;
+                }
+            }
+        }
+        if (best == 0) break;
+
+        fprintf(out, "    %-24s %7u reads %7u writes", regName(pageBase[bp] + bw * 4),
+                reads[bp][bw], writes[bp][bw]);
+        if (ignoredCount[bp][bw]) fprintf(out, " (%u ignored)", ignoredCount[bp][bw]);
+        fprintf(out, "\n");
+
+        reads[bp][bw] = 0;
+        writes[bp][bw] = 0;
+    }
+}
+
+int mockViolations(void) {
+    return numViolations;
+}
+
+void mockPrintViolations(FILE* out) {
+    for (int i = 0; i < numStored; i++) {
+        fprintf(out, "    %s: %s\n", regName(violation[i].addr), violation[i].what);
+    }
+    if (numViolations > numStored) {
+        fprintf(out, "    ... %d more\n", numViolations - numStored);
+    }
+}
@@ -0,0 +1,98 @@
+// periph_mock.h
+// Register level model of the STM32L432KC peripherals for host driver tests
+//
+// mockInit() maps RCC, FLASH, PWR, GPIOA/B, DMA1, ADC1, SPI1, USART2,
+// TIM1/2/15/16, DWT and the NVIC/SCB page at their real addresses, so the
+// lib/ drivers run unchanged on an x86-64 Linux host (built -no-pie, the DMA
+// address registers are 32 bit). Every access the drivers make is trapped,
+// counted and passed through a behavioural model:
+//
+//   RCC     PLLRDY/MSIRDY/HSIRDY follow the enables, SWS follows SW
+//   FLASH   the wait states must cover HCLK (from SWS and the PLL) in the
+//   PWR     voltage range after every switch, latency or range change.
+//           VOSF reads 0. ICRST / DCRST only with that cache off.
+//   ADC1    ADCAL completes, ADEN sets ADRDY, conversions at the mock sample
+//           rate (EOC/EOS, OVR when nobody read DR), W1C status flags
+//   DMA1    CNDTR countdown, HT/TC flags, circular reload, CSELR routing,
+//           ADC1 -> channel 1, SPI1_TX <- channel 3, TIM16_UP burst on 6,
+//           USART2_TX <- channel 7
+//   TIMx    PSC/ARR/CCR preloads latch on the update event (UDIS, UG, ARPE,
+//           OCxPE), repetition counter, UIF, CNT from the mock clock
+//   SPI1    bytes logged at the SPI1 baud rate, a frame is CS (PA11) low,
+//           bytes, CS high
+//   USART2  bytes logged at BRR x 10 cycles each (16x oversampling), TXE and
+//           TC always set, TEACK follows TE. Bytes queued with
+//           mockUsartInput() are there at once: RXNE while any are left
+//           (RE set), each RDR read takes the next one.
+//   DWT     CYCCNT runs off the mock clock
+//
+// Writes to a peripheral whose RCC clock is off are dropped, like on the
+// chip. Dropped writes that would have changed a register and other rule
+// breaks (reconfiguring an enabled DMA channel, ADCAL with ADEN set, an
+// interrupt flag nobody clears...) are collected as violations. Time only moves inside mockAdvance*(), which also runs the
+// handlers registered with mockSetIrqHandler() when flag, peripheral
+// interrupt enable and NVIC enable are all set.
+
+#ifndef PERIPH_MOCK_H
+#define PERIPH_MOCK_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Mock CPU clock, same as the firmware (configureClock)
+#define MOCK_CPU_HZ 80000000UL
+
+// Sample n of the ADC input, 12 bit
+typedef uint16_t (*MockAdcSource)(uint32_t n, void* ctx);
+
+typedef struct {
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t ignored;   // writes dropped, peripheral clock off
+} MockCounts;
+
+// Active (shadow) timer registers, what the counter is really using
+typedef struct {
+    uint32_t psc;
+    uint32_t arr;
+    uint32_t ccr1;
+    uint32_t ccr2;
+    uint32_t rcr;
+    uint32_t cnt;       // counter now, CH1 output (PWM mode 1) is cnt < ccr1
+    uint32_t updates;   // update events since reset
+    int running;
+} MockTimer;
+
+int mockInit(void);
+void mockReset(void);
+
+void mockSetAdcSource(MockAdcSource source, void* ctx);
+void mockSetAdcRate(uint32_t hz);
+void mockSetIrqHandler(int irq, void (*handler)(void));
+
+void mockAdvanceCycles(uint64_t cycles);
+void mockAdvanceUs(uint32_t us);
+uint64_t mockCycles(void);
+
+// Register value without going through the trap (not counted)
+uint32_t mockPeek(uintptr_t addr);
+void mockPoke(uintptr_t addr, uint32_t value);
+
+MockTimer mockTimer(uintptr_t base);
+
+size_t mockSpiOutput(const uint8_t** bytes);
+uint32_t mockSpiFrames(void);
+void mockSpiClear(void);
+
+size_t mockUsartOutput(const uint8_t** bytes);
+void mockUsartClear(void);
+void mockUsartInput(const uint8_t* bytes, size_t len);
+
+MockCounts mockCounts(void);
+void mockClearCounts(void);
+void mockPrintAccesses(FILE* out);
+
+int mockViolations(void);
+void mockPrintViolations(FILE* out);
+
+#endif
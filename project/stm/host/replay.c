@@ -0,0 +1,209 @@
+// replay.c
+// Runs WAV files through the analyzer DSP chain (lib/fft_processing.c)
+// frame by frame, exactly as the STM32 main loop does, and prints the
+// detections and how long every stage took on this machine.
+//
+//   fft_replay [-a] [-q] [-n notes] [-g gain] [-r repeat] file.wav ...
+//
+//   -a   print every frame, not only the ones that turn the LED on
+//   -q   summary only
+//   -n   notes kept per frame (default 3, INTERRUPTER_MAX_VOICES)
+//   -g   gain in front of the 12 bit ADC model (default 1.0 = full scale)
+//   -r   run every frame this many times, for steadier timings
+//
+// The file is mixed to mono, resampled to SAMPLE_RATE (linear interpolation)
+// and quantized to 12 bit ADC codes around mid-scale, so the chain sees the
+// same uint16_t blocks the DMA hands the main loop.
+
+#include "../lib/fft_processing.h"
+#include "wav.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_NOTES_LIMIT 16
+
+typedef enum {
+    STAGE_NORMALIZE,
+    STAGE_FFT,
+    STAGE_NOTES,
+    STAGE_DETECT,
+    STAGE_TOTAL,
+    NUM_STAGES
+} Stage;
+
+static const char* stageNames[NUM_STAGES] = {
+    "normalize", "fft_compute", "peak search", "detection", "total"
+};
+
+typedef struct {
+    double minNs;
+    double maxNs;
+    double sumNs;
+    long count;
+} StageStats;
+
+static StageStats stats[NUM_STAGES];
+
+static double nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void addTime(Stage s, double ns) {
+    StageStats* st = &stats[s];
+    if (st->count == 0 || ns < st->minNs) st->minNs = ns;
+    if (ns > st->maxNs) st->maxNs = ns;
+    st->sumNs += ns;
+    st->count++;
+}
+
+// Mono float samples at any rate -> 12 bit ADC codes at SAMPLE_RATE
+static uint16_t* toAdc(const WavFile* wav, float gain, size_t* outLen) {
+    double step = (double)wav->sampleRate / SAMPLE_RATE;
+    size_t n = wav->frames > 0 ? (size_t)((wav->frames - 1) / step) + 1 : 0;
+    uint16_t* adc = malloc((n ? n : 1) * sizeof(uint16_t));
+
+    for (size_t i = 0; i < n; i++) {
+        double t = i * step;
+        size_t k = (size_t)t;
+        double frac = t - k;
+        double x = wav->samples[k];
+        if (k + 1 < wav->frames) x += frac * (wav->samples[k + 1] - x);
+
+        long code = lround(2048.0 + x * gain * 2048.0);
+        if (code < 0) code = 0;
+        if (code > 4095) code = 4095;
+        adc[i] = (uint16_t)code;
+    }
+    *outLen = n;
+    return adc;
+}
+
+static int replayFile(const char* path, int maxNotes, float gain, int repeat,
+                      int printAll, int quiet, long* framesOut, long* detectionsOut) {
+    WavFile wav;
+    if (wavRead(path, &wav) != 0) return -1;
+
+    size_t len;
+    uint16_t* adc = toAdc(&wav, gain, &len);
+    if (!quiet) {
+        printf("%s: %d Hz, %d ch, %.2f s -> %zu frames of %d samples\n", path,
+               wav.sampleRate, wav.channels, (double)wav.frames / wav.sampleRate,
+               len / FFT_SIZE, FFT_SIZE);
+    }
+
+    static Complex fft_buffer[FFT_SIZE];
+    static float mag_buffer[FFT_SIZE / 2];
+    float note_freqs[MAX_NOTES_LIMIT];
+    float note_mags[MAX_NOTES_LIMIT];
+
+    long frames = 0, detections = 0;
+    for (size_t start = 0; start + FFT_SIZE <= len; start += FFT_SIZE) {
+        const uint16_t* block = &adc[start];
+        int play_count = 0;
+        int on = 0;
+
+        for (int r = 0; r < repeat; r++) {
+            double t0 = nowNs();
+            fftNormalize(block, fft_buffer, FFT_SIZE);
+            double t1 = nowNs();
+            fft_compute(fft_buffer, FFT_SIZE);
+            double t2 = nowNs();
+            play_count = fftFindNotes(fft_buffer, FFT_SIZE, SAMPLE_RATE, MAG_THRESHOLD,
+                                      FREQ_THRESHOLD, mag_buffer, note_freqs, note_mags,
+                                      maxNotes);
+            double t3 = nowNs();
+            float dominantMag;
+            float dominant = fftDominant(mag_buffer, FFT_SIZE / 2, (float)SAMPLE_RATE / FFT_SIZE,
+                                         &dominantMag);
+            on = fftDetect(dominant, dominantMag, FREQ_THRESHOLD, MAG_THRESHOLD);
+            double t4 = nowNs();
+
+            addTime(STAGE_NORMALIZE, t1 - t0);
+            addTime(STAGE_FFT, t2 - t1);
+            addTime(STAGE_NOTES, t3 - t2);
+            addTime(STAGE_DETECT, t4 - t3);
+            addTime(STAGE_TOTAL, t4 - t0);
+        }
+
+        frames++;
+        detections += on;
+        if (!quiet && (on || printAll)) {
+            printf("%8.3f s  frame %5ld  LED %-3s", (double)start / SAMPLE_RATE, frames - 1,
+                   on ? "ON" : "off");
+            for (int i = 0; i < play_count; i++) {
+                printf("  %7.2f Hz (%.1f)", note_freqs[i], note_mags[i]);
+            }
+            printf("\n");
+        }
+    }
+
+    if (!quiet) {
+        printf("%s: %ld frames, LED on in %ld\n\n", path, frames, detections);
+    }
+    *framesOut += frames;
+    *detectionsOut += detections;
+
+    free(adc);
+    wavFree(&wav);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int maxNotes = 3;
+    float gain = 1.0f;
+    int repeat = 1;
+    int printAll = 0;
+    int quiet = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "aqn:g:r:")) != -1) {
+        switch (opt) {
+        case 'a': printAll = 1; break;
+        case 'q': quiet = 1; break;
+        case 'n': maxNotes = atoi(optarg); break;
+        case 'g': gain = (float)atof(optarg); break;
+        case 'r': repeat = atoi(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-a] [-q] [-n notes] [-g gain] [-r repeat] file.wav ...\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-a] [-q] [-n notes] [-g gain] [-r repeat] file.wav ...\n",
+                argv[0]);
+        return 1;
+    }
+    if (maxNotes < 1) maxNotes = 1;
+    if (maxNotes > MAX_NOTES_LIMIT) maxNotes = MAX_NOTES_LIMIT;
+    if (repeat < 1) repeat = 1;
+
+    long frames = 0, detections = 0;
+    int failed = 0;
+    for (int i = optind; i < argc; i++) {
+        if (replayFile(argv[i], maxNotes, gain, repeat, printAll, quiet, &frames, &detections) != 0) {
+            failed = 1;
+        }
+    }
+
+    // Per stage timing, against the time one frame takes to arrive
+    double framePeriodUs = 1e6 * FFT_SIZE / SAMPLE_RATE;
+    printf("%ld frames, LED on in %ld (%.1f%%)\n", frames, detections,
+           frames ? 100.0 * detections / frames : 0.0);
+    printf("%-12s %10s %10s %10s %9s\n", "stage", "min us", "avg us", "max us", "of frame");
+    for (int s = 0; s < NUM_STAGES; s++) {
+        const StageStats* st = &stats[s];
+        double avg = st->count ? st->sumNs / st->count : 0.0;
+        printf("%-12s %10.3f %10.3f %10.3f %8.3f%%\n", stageNames[s], st->minNs / 1e3,
+               avg / 1e3, st->maxNs / 1e3, 100.0 * avg / 1e3 / framePeriodUs);
+    }
+
+    return failed;
+}
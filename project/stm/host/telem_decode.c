@@ -0,0 +1,226 @@
+// telem_decode.c
+// Reads the binary spectrum stream the firmware sends on USART2
+// (lib/telemetry.h), live from the ST-Link virtual COM port or from a
+// recording.
+//
+//   telem_decode [-b baud] [-o raw.bin] [-c | -w | -q] <tty | capture file | ->
+//
+//   -b   baud rate when reading a tty (default 2000000, TELEMETRY_BAUD)
+//   -o   also write every byte received to this file, for replay later
+//   -c   CSV, one line per frame: seq, time s, flags, then every bin
+//   -w   waterfall, one text line per frame with the bins as shades
+//   -q   statistics only
+//
+// By default every frame prints as time, sequence number, LED state and the
+// notes. Time is the DWT timestamp unwrapped frame to frame, from the first
+// frame. At the end (EOF or Ctrl-C) the frame, CRC error and gap counts go
+// to stderr.
+
+#define _DEFAULT_SOURCE
+#include "../lib/telemetry.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+// DWT_CPU_HZ, what the timestamps count
+#define CPU_HZ 80000000.0
+
+typedef enum { OUT_NOTES, OUT_CSV, OUT_WATERFALL, OUT_QUIET } OutputMode;
+
+static volatile sig_atomic_t stop = 0;
+
+static void onSignal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static speed_t baudConstant(long baud) {
+    switch (baud) {
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    case 1000000: return B1000000;
+    case 1500000: return B1500000;
+    case 2000000: return B2000000;
+    default: return 0;
+    }
+}
+
+// Raw 8N1 at baud, blocking reads
+static int setupTty(int fd, long baud) {
+    speed_t speed = baudConstant(baud);
+    if (speed == 0) {
+        fprintf(stderr, "unsupported baud rate %ld\n", baud);
+        return -1;
+    }
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        perror("tcgetattr");
+        return -1;
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+        perror("tcsetattr");
+        return -1;
+    }
+    tcflush(fd, TCIFLUSH);
+    return 0;
+}
+
+static void printFrame(OutputMode mode, const TelemetryFrame* f, const TelemetrySpectrum* s,
+                       double t) {
+    static const char shades[] = " .:-=+*#%@";
+
+    switch (mode) {
+    case OUT_NOTES:
+        printf("%9.3f s  seq %5u  LED %-3s", t, f->seq,
+               (s->flags & TELEMETRY_FLAG_DETECTED) ? "ON" : "off");
+        for (int i = 0; i < s->peakCount; i++) {
+            printf("  %7.2f Hz (%.1f)", s->peakFreqs[i], s->peakMags[i]);
+        }
+        printf("\n");
+        break;
+    case OUT_CSV:
+        printf("%u,%.6f,%u", f->seq, t, s->flags);
+        for (int i = 0; i < s->binCount; i++) printf(",%.3f", s->mags[i]);
+        printf("\n");
+        break;
+    case OUT_WATERFALL:
+        // 60 dB over the shades, magnitude 1.0 (the floor of the FPGA
+        // levels is MAG_THRESHOLD = 10) at the bottom
+        printf("%5u |", f->seq);
+        for (int i = 0; i < s->binCount; i++) {
+            double db = s->mags[i] > 0 ? 20.0 * log10(s->mags[i]) : 0.0;
+            int shade = (int)(db * 10.0 / 60.0);
+            if (shade < 0) shade = 0;
+            if (shade > 9) shade = 9;
+            putchar(shades[shade]);
+        }
+        printf("| %c\n", (s->flags & TELEMETRY_FLAG_DETECTED) ? '*' : ' ');
+        break;
+    case OUT_QUIET:
+        break;
+    }
+}
+
+int main(int argc, char** argv) {
+    long baud = 2000000;
+    const char* rawPath = NULL;
+    OutputMode mode = OUT_NOTES;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:o:cwq")) != -1) {
+        switch (opt) {
+        case 'b': baud = atol(optarg); break;
+        case 'o': rawPath = optarg; break;
+        case 'c': mode = OUT_CSV; break;
+        case 'w': mode = OUT_WATERFALL; break;
+        case 'q': mode = OUT_QUIET; break;
+        default:
+            fprintf(stderr, "usage: %s [-b baud] [-o raw.bin] [-c | -w | -q] <tty | capture file | ->\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-b baud] [-o raw.bin] [-c | -w | -q] <tty | capture file | ->\n",
+                argv[0]);
+        return 1;
+    }
+
+    const char* path = argv[optind];
+    int fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        perror(path);
+        return 1;
+    }
+    if (isatty(fd) && setupTty(fd, baud) != 0) return 1;
+
+    FILE* raw = NULL;
+    if (rawPath != NULL && (raw = fopen(rawPath, "wb")) == NULL) {
+        perror(rawPath);
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    // Room for two of the largest frames, so one always fits after a shift
+    static uint8_t buf[2 * (TELEMETRY_HEADER_BYTES + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_BYTES)];
+    static TelemetrySpectrum spec;
+    size_t len = 0;
+
+    long frames = 0, crcErrors = 0, badPayloads = 0, gaps = 0, lost = 0;
+    unsigned long long skipped = 0;
+    uint16_t lastSeq = 0;
+    uint32_t lastStamp = 0;
+    double t = 0.0;
+
+    while (!stop) {
+        ssize_t got = read(fd, &buf[len], sizeof(buf) - len);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        if (raw != NULL) fwrite(&buf[len], 1, (size_t)got, raw);
+        len += (size_t)got;
+
+        for (;;) {
+            TelemetryFrame f;
+            size_t used;
+            int found = telemetryFind(buf, len, &f, &used);
+
+            if (found == 1) {
+                skipped += used - (TELEMETRY_HEADER_BYTES + f.length + TELEMETRY_CRC_BYTES);
+                if (telemetrySpectrum(&f, &spec) != 0) {
+                    badPayloads++;
+                } else {
+                    if (frames > 0) {
+                        uint16_t step = (uint16_t)(f.seq - lastSeq);
+                        if (step != 1) {
+                            gaps++;
+                            lost += step - 1;
+                        }
+                        t += (uint32_t)(f.timestamp - lastStamp) / CPU_HZ;
+                    }
+                    lastSeq = f.seq;
+                    lastStamp = f.timestamp;
+                    frames++;
+                    printFrame(mode, &f, &spec, t);
+                    if (mode != OUT_QUIET) fflush(stdout);
+                }
+            } else if (found < 0) {
+                crcErrors++;
+                skipped += used;
+            }
+            if (found == 0 && used > 0) skipped += used;
+
+            memmove(buf, &buf[used], len - used);
+            len -= used;
+            if (found == 0) break;
+        }
+    }
+
+    if (raw != NULL) fclose(raw);
+    if (fd != STDIN_FILENO) close(fd);
+
+    fprintf(stderr, "%ld frames over %.2f s, %ld CRC errors, %ld bad payloads, "
+            "%ld gaps (%ld frames not sent), %llu bytes skipped\n",
+            frames, t, crcErrors, badPayloads, gaps, lost, skipped);
+    return 0;
+}
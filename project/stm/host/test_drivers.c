@@ -0,0 +1,704 @@
+// test_drivers.c
+// Runs the lib/ drivers against the register model in periph_mock.c
+//
+//   test_drivers [-v]
+//
+// Every test starts from reset values, calls the drivers the way main.c
+// does, moves the mock clock and checks the registers, the DMA'd data and
+// the interrupts that fired. Per driver call it prints the register reads /
+// writes and the host time; -v adds the per register breakdown. Host time is
+// mostly the two traps per access (a few us each), the access counts are the
+// number to compare between driver versions.
+
+#include "periph_mock.h"
+
+#include "../lib/STM32L432KC_ADC.h"
+#include "../lib/STM32L432KC_DMA.h"
+#include "../lib/STM32L432KC_FLASH.h"
+#include "../lib/STM32L432KC_PWR.h"
+#include "../lib/STM32L432KC_RCC.h"
+#include "../lib/STM32L432KC_SPI.h"
+#include "../lib/STM32L432KC_TIM.h"
+#include "../lib/STM32L432KC_USART.h"
+#include "../lib/fpga_link.h"
+#include "../lib/interrupter.h"
+#include "../lib/profile.h"
+#include "../lib/latency.h"
+#include "../lib/telemetry.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define NVIC_ISER0 (*(volatile uint32_t *) 0xE000E100UL)
+#define ADC_BUFFER 256
+
+// STM32L432KC_SPI.c / _USART.c, not in the headers (vector table only)
+void DMA1_Channel3_IRQHandler(void);
+void DMA1_Channel7_IRQHandler(void);
+
+static int verbose = 0;
+static int fails = 0;
+
+static void check(int ok, const char* what) {
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok) fails++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Per call access counts and host time
+///////////////////////////////////////////////////////////////////////////////
+
+static struct timespec callStart;
+
+static void begin(void) {
+    mockClearCounts();
+    clock_gettime(CLOCK_MONOTONIC, &callStart);
+}
+
+static void end(const char* call) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    double us = (t.tv_sec - callStart.tv_sec) * 1e6 + (t.tv_nsec - callStart.tv_nsec) / 1e3;
+
+    MockCounts c = mockCounts();
+    printf("     %-30s %5u reads %5u writes", call, c.reads, c.writes);
+    if (c.ignored) printf(" %u ignored", c.ignored);
+    printf("  %8.1f us host\n", us);
+    if (verbose) mockPrintAccesses(stdout);
+}
+
+static void noViolations(const char* test) {
+    char what[80];
+    snprintf(what, sizeof(what), "%s: no register rule violations", test);
+    check(mockViolations() == 0, what);
+    if (mockViolations()) mockPrintViolations(stdout);
+}
+
+static double timerHz(MockTimer t) {
+    return (double)MOCK_CPU_HZ / ((t.psc + 1.0) * (t.arr + 1.0));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Clocks
+///////////////////////////////////////////////////////////////////////////////
+
+static void testClock(void) {
+    mockReset();
+
+    // initSystem(): wait states first, then the PLL
+    begin();
+    int ws = configureFlash(80000000UL, 0);
+    end("configureFlash(80 MHz)");
+    uint32_t acr = mockPeek(FLASH_BASE);
+    check(ws == 4 && (acr & FLASH_ACR_LATENCY) == 4, "clock: 4 flash wait states at 80 MHz");
+    check((acr & (FLASH_ACR_PRFTEN | FLASH_ACR_ICEN | FLASH_ACR_DCEN)) ==
+              (FLASH_ACR_PRFTEN | FLASH_ACR_ICEN | FLASH_ACR_DCEN),
+          "clock: prefetch, I-cache and D-cache on");
+    check(((mockPeek(PWR_BASE) >> 9) & 3) == 1, "clock: voltage range 1");
+
+    begin();
+    configureClock();
+    end("configureClock");
+
+    uint32_t cr = mockPeek(RCC_BASE + offsetof(RCC_TypeDef, CR));
+    uint32_t cfgr = mockPeek(RCC_BASE + offsetof(RCC_TypeDef, CFGR));
+    uint32_t pll = mockPeek(RCC_BASE + offsetof(RCC_TypeDef, PLLCFGR));
+    check((cr >> 25) & 1, "clock: PLL locked");
+    check(((cfgr >> 2) & 3) == 3, "clock: system clock switched to the PLL");
+    check(((pll >> 8) & 0x7F) == 80 && ((pll >> 4) & 7) == 0 && ((pll >> 25) & 3) == 1,
+          "clock: PLL N = 80, M = 1, R = 4 (80 MHz from 4 MHz MSI)");
+
+    noViolations("clock");
+}
+
+static void testFlash(void) {
+    check(flashLatency(16000000UL, PWR_RANGE1) == 0 && flashLatency(16000001UL, PWR_RANGE1) == 1 &&
+          flashLatency(48000000UL, PWR_RANGE1) == 2 && flashLatency(80000000UL, PWR_RANGE1) == 4,
+          "flash: range 1 wait states at 16 / 16.000001 / 48 / 80 MHz");
+    check(flashLatency(6000000UL, PWR_RANGE2) == 0 && flashLatency(12000000UL, PWR_RANGE2) == 1 &&
+          flashLatency(24000000UL, PWR_RANGE2) == 3 && flashLatency(26000000UL, PWR_RANGE2) == 3,
+          "flash: range 2 wait states at 6 / 12 / 24 / 26 MHz");
+    check(flashLatency(80000001UL, PWR_RANGE1) < 0 && flashLatency(27000000UL, PWR_RANGE2) < 0,
+          "flash: above 80 MHz (range 1) / 26 MHz (range 2) refused");
+
+    // The PLL switch before the wait states are raised is caught
+    mockReset();
+    configureClock();
+    check(mockViolations() == 1, "flash: 80 MHz with 0 wait states is reported");
+
+    // 80 MHz -> 16 MHz in range 2 and back. Slower: clock first, then flash.
+    mockReset();
+    configureFlash(80000000UL, 0);
+    configureClock();
+    RCC->CFGR &= ~(0b11 << 0);                  // back to MSI, 4 MHz
+    begin();
+    int ws = configureFlash(4000000UL, 1);
+    end("configureFlash(4 MHz, range 2)");
+    check(ws == 0 && (mockPeek(FLASH_BASE) & FLASH_ACR_LATENCY) == 0 &&
+          ((mockPeek(PWR_BASE) >> 9) & 3) == 2, "flash: 4 MHz in range 2, 0 wait states");
+    check(configureFlash(90000000UL, 0) < 0 && ((mockPeek(PWR_BASE) >> 9) & 3) == 2,
+          "flash: 90 MHz refused, nothing changed");
+    configureFlash(80000000UL, 0);
+    RCC->CFGR |= (0b11 << 0);                   // PLL again
+    check((mockPeek(FLASH_BASE) & FLASH_ACR_LATENCY) == 4 && ((mockPeek(PWR_BASE) >> 9) & 3) == 1,
+          "flash: back to range 1, 4 wait states");
+
+    begin();
+    flashCacheReset();
+    end("flashCacheReset");
+    uint32_t acr = mockPeek(FLASH_BASE);
+    check((acr & (FLASH_ACR_ICEN | FLASH_ACR_DCEN)) == (FLASH_ACR_ICEN | FLASH_ACR_DCEN) &&
+          !(acr & (FLASH_ACR_ICRST | FLASH_ACR_DCRST)), "flash: caches back on after the reset");
+
+    noViolations("flash");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ADC
+///////////////////////////////////////////////////////////////////////////////
+
+static uint16_t ramp(uint32_t n, void* ctx) {
+    (void)ctx;
+    return (uint16_t)((n * 37 + 5) & 0xFFF);
+}
+
+static uint16_t sine(uint32_t n, void* ctx) {
+    float hz = *(float*)ctx;
+    return (uint16_t)lroundf(2048.0f + 1500.0f * sinf(2.0f * (float)M_PI * hz * n / 8000.0f));
+}
+
+static void testADCPolled(void) {
+    mockReset();
+    mockSetAdcSource(ramp, NULL);
+
+    begin();
+    initADC(ADC_CHANNEL_5);
+    end("initADC");
+
+    startADC();
+    int ok = 1;
+    begin();
+    for (uint32_t n = 0; n < 4; n++) {
+        if (readADC() != ramp(n, NULL)) ok = 0;
+    }
+    end("readADC x4");
+    check(ok, "adc: polled conversions return the input");
+
+    stopADC();
+    uint32_t cr = mockPeek(ADC1_BASE + offsetof(ADC_TypeDef, CR));
+    check((cr & (1 << 0)) && !(cr & (1 << 2)), "adc: stopADC leaves the ADC enabled, idle");
+
+    noViolations("adc");
+}
+
+static uint16_t adcBuffer[ADC_BUFFER];
+static int halfTransfers, fullTransfers, overruns;
+
+static void dmaAdcHandler(void) {
+    // Same flag handling as DMA1_Channel1_IRQHandler in main.c
+    uint32_t flags = DMA1->ISR & 0xF;
+    DMA1->IFCR |= flags;
+    if (flags & (1 << 2)) halfTransfers++;
+    if (flags & (1 << 1)) fullTransfers++;
+}
+
+static void adcHandler(void) {
+    if (clearADCOverrun()) overruns++;
+}
+
+static void testADCDMA(void) {
+    float hz = 440.0f;
+
+    mockReset();
+    mockSetAdcRate(8000);
+    mockSetAdcSource(sine, &hz);
+    mockSetIrqHandler(11, dmaAdcHandler);
+    mockSetIrqHandler(18, adcHandler);
+    halfTransfers = fullTransfers = overruns = 0;
+
+    begin();
+    configureADCForDMA(11);
+    end("configureADCForDMA");
+
+    begin();
+    initDMA_ADC(adcBuffer, ADC_BUFFER);
+    enableDMA_ADC();
+    end("initDMA_ADC + enableDMA_ADC");
+
+    NVIC_ISER0 |= (1 << 11) | (1 << 18);
+    startADC();
+
+    // 256 samples at 8 kHz = 32 ms, HT after 16 ms
+    mockAdvanceUs(16000);
+    check(halfTransfers == 1 && fullTransfers == 0, "adc dma: half transfer after 128 samples");
+    check(getDMA_Counter() == ADC_BUFFER / 2, "adc dma: CNDTR counted down to 128");
+
+    mockAdvanceUs(16000);
+    check(fullTransfers == 1, "adc dma: transfer complete after 256 samples");
+    check(getDMA_Counter() == ADC_BUFFER, "adc dma: CNDTR reloaded (circular)");
+
+    int same = 1;
+    for (uint32_t n = 0; n < ADC_BUFFER; n++) {
+        if (adcBuffer[n] != sine(n, &hz)) same = 0;
+    }
+    check(same, "adc dma: buffer holds samples 0-255 in order");
+
+    mockAdvanceUs(64000);
+    check(fullTransfers == 3 && halfTransfers == 3, "adc dma: 3 frames in 96 ms");
+    check(overruns == 0, "adc dma: no overrun while DMA keeps up");
+    noViolations("adc dma");
+
+    // Stop the DMA and the ADC starts overrunning
+    begin();
+    disableDMA_ADC();
+    end("disableDMA_ADC");
+    mockAdvanceUs(1000);
+    check(overruns > 0, "adc dma: overrun interrupt once DMA stops");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Timers
+///////////////////////////////////////////////////////////////////////////////
+
+static void testTIM16(void) {
+    mockReset();
+
+    begin();
+    initTIM16PWM();
+    end("initTIM16PWM");
+
+    begin();
+    updateTIM16FREQ(1000);
+    end("updateTIM16FREQ");
+
+    // From the silent 1 ms idle period the first note starts within one
+    // idle period (at once, the output was low)
+    mockAdvanceUs(1000);
+    MockTimer t = mockTimer(TIM16_BASE);
+    check(t.arr == 99 && t.ccr1 == 50 && t.psc == 799, "tim16: 1 kHz, 50% within 1 ms of init");
+
+    // While a note plays the next one waits for the period boundary
+    updateTIM16FREQ(500);
+    check(mockTimer(TIM16_BASE).arr == 99, "tim16: playing period is not cut short");
+    mockAdvanceUs(1000);
+    check(mockTimer(TIM16_BASE).arr == 199, "tim16: new period after the update event");
+    updateTIM16FREQ(1000);
+    mockAdvanceUs(2000);
+    t = mockTimer(TIM16_BASE);
+
+    uint32_t before = t.updates;
+    mockAdvanceUs(10000);
+    check(mockTimer(TIM16_BASE).updates - before == 10, "tim16: 10 updates in 10 ms");
+
+    begin();
+    float cents = setTIM16FREQHiRes(440.0f);
+    end("setTIM16FREQHiRes");
+    mockAdvanceUs(2000);
+    t = mockTimer(TIM16_BASE);
+    check(fabs(timerHz(t) - 440.0) < 0.01 && fabsf(cents) < 0.1f,
+          "tim16: hi-res 440 Hz within 0.01 Hz");
+
+    noViolations("tim16");
+}
+
+// Samples TIM16 CH1 once per 100 kHz tick and keeps the longest high run
+static void sampleTIM16High(int ticks, uint32_t* run, uint32_t* longest) {
+    for (int i = 0; i < ticks; i++) {
+        mockAdvanceUs(10);
+        MockTimer t = mockTimer(TIM16_BASE);
+        if (t.cnt < t.ccr1) {
+            if (++*run > *longest) *longest = *run;
+        } else {
+            *run = 0;
+        }
+    }
+}
+
+static void testTIM16OffOn(void) {
+    mockReset();
+    initTIM16PWM();
+    setPulseLimits(2000, 0);        // 200 ticks, less than the 500 of 50%
+
+    uint32_t run = 0, longest = 0;
+    updateTIM16FREQ(100);
+    sampleTIM16High(2100, &run, &longest);  // 1 ms into the third pulse
+
+    // Off and on again before the period ends: the zero never latched, so
+    // the running pulse has to end at its own compare, not start over
+    updateTIM16FREQ(0);
+    updateTIM16FREQ(100);
+    sampleTIM16High(3000, &run, &longest);
+    check(longest == 200, "tim16: off -> on within a period, no pulse over the on-time limit");
+
+    // Off for longer than a period, the zero latched: the note starts at once
+    updateTIM16FREQ(0);
+    sampleTIM16High(1500, &run, &longest);
+    updateTIM16FREQ(1000);
+    check(mockTimer(TIM16_BASE).arr == 99, "tim16: from latched silence the note starts at once");
+    sampleTIM16High(1000, &run, &longest);
+    check(longest == 200, "tim16: restarted note keeps the on-time limit");
+
+    setPulseLimits(0, 0);
+    noViolations("tim16 off -> on");
+}
+
+static void testTIM16Schedule(void) {
+    static uint32_t schedule[2 * TIM16_SCHEDULE_WORDS];
+    static uint32_t longNote[4 * TIM16_SCHEDULE_WORDS];
+
+    // 2 s at 1 kHz is 2000 periods: 8 entries of up to 256
+    check(makeTIM16ScheduleEntry(1000, 2000, longNote, 4) < 0,
+          "tim16 schedule: note that needs 8 entries refused with room for 4");
+    int n = makeTIM16ScheduleEntry(1000, 1000, longNote, 4);
+    uint32_t periods = 0;
+    for (int i = 0; i < n; i++) periods += longNote[i * TIM16_SCHEDULE_WORDS + 1] + 1;
+    check(n == 4 && periods == 1000 && longNote[10] == 1000 - 3 * 256 - 1,
+          "tim16 schedule: 1000 periods split 256 + 256 + 256 + 232");
+
+    mockReset();
+    initTIM16PWM();
+    updateTIM16FREQ(1000);
+    mockAdvanceUs(1000);
+
+    makeTIM16ScheduleEntry(500, 100, &schedule[0], 1);  // ARR 199, 50 periods
+    makeTIM16ScheduleEntry(250, 40, &schedule[3], 1);   // ARR 399, 10 periods
+
+    begin();
+    startTIM16Schedule(schedule, 2, 1);
+    end("startTIM16Schedule");
+
+    // Sample the active period every ms, measure how long each entry plays
+    uint32_t last = mockTimer(TIM16_BASE).arr;
+    int runMs = 0, runs = 0, good = 0;
+    for (int ms = 0; ms < 600; ms++) {
+        mockAdvanceUs(1000);
+        uint32_t arr = mockTimer(TIM16_BASE).arr;
+        runMs++;
+        if (arr != last) {
+            if (runs > 0) {
+                int want = last == schedule[0] ? 100 : 40;
+                if (abs(runMs - want) <= 1) good++;
+            }
+            runs++;
+            runMs = 0;
+            last = arr;
+        }
+    }
+    check(runs >= 8 && good == runs - 1, "tim16 schedule: entries play 100 ms / 40 ms, looped");
+
+    stopTIM16Schedule();
+    noViolations("tim16 schedule");
+}
+
+static void testInterrupter(void) {
+    mockReset();
+
+    begin();
+    initInterrupter();
+    end("initInterrupter");
+
+    const float notes[3] = { 220.0f, 330.5f, 1046.5f };
+    begin();
+    interrupterSetNotes(notes, 3);
+    end("interrupterSetNotes");
+    mockAdvanceUs(5000);
+
+    int playing = 0, tuned = 0, pulses = 0;
+    for (int v = 0; v < INTERRUPTER_MAX_VOICES; v++) {
+        const Voice* voice = interrupterVoice(v);
+        if (voice->freq == 0) continue;
+        playing++;
+
+        MockTimer t = mockTimer((uintptr_t)voice->tim);
+        double cents = 1200.0 * log2(timerHz(t) / voice->freq);
+        if (fabs(cents) < 0.05) tuned++;
+
+        uint32_t ccr = voice->channel == 1 ? t.ccr1 : t.ccr2;
+        double onUs = ccr * (t.psc + 1.0) / (MOCK_CPU_HZ / 1e6);
+        if (onUs > 0 && onUs <= INTERRUPTER_PULSE_US + 0.1) pulses++;
+    }
+    check(playing == 3, "interrupter: 3 voices playing");
+    check(tuned == 3, "interrupter: every timer within 0.05 cents of its note");
+    check(pulses == 3, "interrupter: pulses within the on-time limit");
+
+    noViolations("interrupter");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SPI link
+///////////////////////////////////////////////////////////////////////////////
+
+static void testFPGALink(void) {
+    mockReset();
+    mockSetIrqHandler(13, DMA1_Channel3_IRQHandler);
+
+    begin();
+    initFPGALink();
+    end("initFPGALink");
+
+    uint8_t levels[FPGA_NUM_BANDS];
+    for (int b = 0; b < FPGA_NUM_BANDS; b++) levels[b] = (uint8_t)(b * 20);
+
+    begin();
+    int sent = fpgaSendLevels(levels);
+    end("fpgaSendLevels");
+    check(sent == 0 && fpgaLinkBusy(), "spi: frame queued, link busy");
+    check(fpgaSendLevels(levels) == -1, "spi: second frame dropped while busy");
+
+    mockAdvanceUs(100);
+    const uint8_t* out;
+    size_t len = mockSpiOutput(&out);
+    check(!fpgaLinkBusy() && mockSpiFrames() == 1, "spi: DMA done, CS released once");
+    check(len == 2 + FPGA_NUM_BANDS && out[0] == FPGA_FRAME_LEVELS && out[1] == 0 &&
+          memcmp(&out[2], levels, FPGA_NUM_BANDS) == 0, "spi: frame bytes on the wire");
+
+    mockSpiClear();
+    fpgaSendLevels(levels);
+    mockAdvanceUs(100);
+    len = mockSpiOutput(&out);
+    check(len == 2 + FPGA_NUM_BANDS && out[1] == 1, "spi: sequence number counts on");
+
+    noViolations("spi");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Telemetry over USART2
+///////////////////////////////////////////////////////////////////////////////
+
+static void testTelemetry(void) {
+    static uint8_t frame[TELEMETRY_SPECTRUM_BYTES(3, 128, FPGA_NUM_BANDS)];
+    static float mags[128];
+    static TelemetrySpectrum spec;
+    float freqs[3] = { 440.0f, 880.0f, 1320.5f };
+    float peaks[3] = { 40.0f, 20.5f, 10.25f };
+    uint8_t bands[FPGA_NUM_BANDS];
+
+    mockReset();
+    mockSetIrqHandler(17, DMA1_Channel7_IRQHandler);
+    for (int i = 0; i < 128; i++) mags[i] = i * 0.37f;
+    for (int b = 0; b < FPGA_NUM_BANDS; b++) bands[b] = (uint8_t)(255 - b);
+
+    check(telemetryCrc16((const uint8_t*)"123456789", 9) == 0x29B1, "telemetry: CRC-16/CCITT-FALSE check value");
+
+    begin();
+    initUSART(2000000);
+    NVIC_ISER0 |= (1 << 17);
+    end("initUSART");
+    check(USART2->BRR == 40, "usart: BRR 40 for 2 Mbaud at 80 MHz");
+
+    int len = telemetryPackSpectrum(frame, 0x1234, 0xDEADBEEF, TELEMETRY_FLAG_DETECTED,
+                                    freqs, peaks, 3, mags, 128, bands, FPGA_NUM_BANDS);
+    check(len == (int)sizeof(frame), "telemetry: frame length");
+
+    begin();
+    int sent = usartSendDMA(frame, len);
+    end("usartSendDMA");
+    check(sent == 0 && usartDMABusy() && usartSendDMA(frame, len) == -1,
+          "usart: DMA started, second send refused");
+
+    // 10 bits per byte at 2 Mbaud = 5 us per byte
+    mockAdvanceUs(5 * len + 10);
+    const uint8_t* out;
+    size_t n = mockUsartOutput(&out);
+    check(!usartDMABusy() && n == (size_t)len && memcmp(out, frame, len) == 0,
+          "usart: frame bytes on the wire, DMA done");
+
+    // Decoder: junk in front, the frame, half of a second one
+    static uint8_t stream[16 + 2 * sizeof(frame)];
+    memset(stream, 0xA5, 16);
+    memcpy(&stream[16], frame, len);
+    memcpy(&stream[16 + len], frame, len / 2);
+
+    TelemetryFrame f;
+    size_t used;
+    int found = telemetryFind(stream, 16 + len + len / 2, &f, &used);
+    check(found == 1 && used == 16 + (size_t)len && f.seq == 0x1234 && f.timestamp == 0xDEADBEEF,
+          "telemetry: frame found behind junk, header fields");
+    check(telemetryFind(&stream[used], len / 2, &f, &used) == 0, "telemetry: partial frame waits");
+
+    found = telemetryFind(stream, 16 + len, &f, &used);
+    check(found == 1 && telemetrySpectrum(&f, &spec) == 0 && spec.flags == TELEMETRY_FLAG_DETECTED &&
+          spec.peakCount == 3 && spec.binCount == 128 && spec.bandCount == FPGA_NUM_BANDS,
+          "telemetry: spectrum counts");
+    check(fabsf(spec.peakFreqs[2] - 1320.5f) < 1.0f / 16 && fabsf(spec.peakMags[1] - 20.5f) < 1.0f / 256 &&
+          fabsf(spec.mags[100] - 37.0f) < 1.0f / 256 && spec.bands[11] == 244,
+          "telemetry: peaks, bins and bands round trip");
+
+    stream[16 + 40] ^= 0x10;
+    found = telemetryFind(stream, 16 + len, &f, &used);
+    check(found == -1 && used == 16 + 2, "telemetry: CRC error skips the sync");
+
+    // Golden vector run: VECTOR frame in over RX, polled a byte at a time
+    static uint16_t codes[256], back[256];
+    static uint8_t vec[TELEMETRY_VECTOR_BYTES(256)], rx[sizeof(vec)];
+    for (int i = 0; i < 256; i++) codes[i] = (uint16_t)(i * 16);
+    int vlen = telemetryPackVector(vec, 7, codes, 256);
+    check(vlen == (int)sizeof(vec), "telemetry: vector frame length");
+
+    uint8_t c;
+    check(usartReceiveChar(&c) == 0, "usart: nothing received yet");
+    mockUsartInput(vec, vlen);
+    size_t got = 0;
+    begin();
+    while (got < sizeof(rx) && usartReceiveChar(&rx[got])) got++;
+    end("usartReceiveChar");
+    check(got == (size_t)vlen && usartReceiveChar(&c) == 0, "usart: every byte received once");
+    check(telemetryFind(rx, got, &f, &used) == 1 && f.type == TELEMETRY_VECTOR && f.seq == 7 &&
+          telemetryVector(&f, back, 256) == 256 && memcmp(back, codes, sizeof(codes)) == 0,
+          "telemetry: vector codes round trip");
+    check(telemetrySpectrum(&f, &spec) == -1, "telemetry: vector is not a spectrum");
+
+    // ... and the RESULT frame back, decoded like a spectrum
+    len = telemetryPackResult(frame, 7, 123456, 0, freqs, peaks, 2, mags, 128);
+    check(len == TELEMETRY_SPECTRUM_BYTES(2, 128, 0), "telemetry: result frame length");
+    check(telemetryFind(frame, len, &f, &used) == 1 && f.type == TELEMETRY_RESULT &&
+          f.timestamp == 123456 && telemetrySpectrum(&f, &spec) == 0 && spec.peakCount == 2 &&
+          spec.bandCount == 0, "telemetry: result decodes as a spectrum");
+
+    noViolations("usart");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Profile zones (DWT)
+///////////////////////////////////////////////////////////////////////////////
+
+static void testProfile(void) {
+    static const char* const names[2] = { "short", "long" };
+    mockReset();
+
+    begin();
+    profileInit(names, 2);
+    end("profileInit");
+
+    profileEnd(0);                      // first pass of a loop, never begun
+    for (int i = 1; i <= 4; i++) {
+        profileBegin(0);
+        mockAdvanceCycles(1000 * i);
+        profileEnd(0);
+    }
+    profileBegin(1);
+    mockAdvanceCycles(5000000);
+    profileEnd(1);
+
+    const ProfileZone* z = profileZone(0);
+    check(z->count == 4, "profile: an end without a begin is not counted");
+    check(z->minCycles == 1000 && z->maxCycles == 4000 && z->totalCycles == 10000,
+          "profile: min / max / total cycles");
+    check(z->hist[2] == 1 && z->hist[3] == 1 && z->hist[4] == 2,
+          "profile: histogram buckets by powers of two");
+    check(profileZone(1)->hist[PROFILE_HIST_BUCKETS - 1] == 1,
+          "profile: long zone in the last bucket");
+    if (verbose) profilePrint();
+
+    profileReset();
+    check(profileZone(0)->count == 0 && profileZone(0)->hist[4] == 0, "profile: reset");
+
+    noViolations("profile");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Onset to output latency (DWT)
+///////////////////////////////////////////////////////////////////////////////
+
+static void testLatency(void) {
+    static const char* const names[2] = { "led", "fpga" };
+    static uint16_t quiet[128], burst[128];
+    const uint32_t sample = MOCK_CPU_HZ / 8000;
+    mockReset();
+
+    for (int i = 0; i < 128; i++) {
+        quiet[i] = 2048 + (i & 1 ? 3 : -3);
+        burst[i] = (i < 100) ? 2048 : 2048 + 500;
+    }
+
+    begin();
+    initLatency(names, 2, 8000, 64);
+    end("initLatency");
+
+    // Sound before enough silence is not an onset
+    latencyScan(burst, 128);
+    check(latencyOnsets() == 0, "latency: no onset without silence first");
+
+    for (int b = 0; b < LATENCY_QUIET_BLOCKS; b++) latencyScan(quiet, 128);
+    latencyScan(burst, 128);
+    check(latencyOnsets() == 1, "latency: onset after the quiet blocks");
+
+    // Onset was sample 100 of 128, i.e. 27 samples before the interrupt
+    mockAdvanceCycles(30 * MOCK_CPU_HZ / 1000 - 27 * sample);
+    latencyOutput(0, 0);
+    latencyOutput(1, 1);
+    mockAdvanceCycles(10 * MOCK_CPU_HZ / 1000);
+    latencyOutput(0, 1);
+    latencyOutput(1, 1);                // still on, not a new change
+    const LatencyOutput* led = latencyStats(0);
+    const LatencyOutput* fpga = latencyStats(1);
+    check(fpga->count == 1 && fpga->minCycles == 30 * MOCK_CPU_HZ / 1000,
+          "latency: onset back-dated from the interrupt");
+    check(led->count == 1 && led->minCycles == 40 * MOCK_CPU_HZ / 1000 && led->hist[10] == 1,
+          "latency: first off -> on change only, 4 ms buckets");
+
+    // Second burst: the LED goes off and on again, the FPGA output never
+    // goes off, so it has missed this onset by the third one
+    for (int b = 0; b < LATENCY_QUIET_BLOCKS; b++) latencyScan(quiet, 128);
+    latencyOutput(0, 0);
+    latencyScan(burst, 128);
+    mockAdvanceCycles(20 * MOCK_CPU_HZ / 1000);
+    latencyOutput(0, 1);
+    latencyOutput(1, 1);
+    for (int b = 0; b < LATENCY_QUIET_BLOCKS; b++) latencyScan(quiet, 128);
+    latencyScan(burst, 128);
+    check(led->count == 2 && led->missed == 0 && fpga->count == 1 && fpga->missed == 1,
+          "latency: an output that does not change is missed");
+    if (verbose) latencyPrint();
+
+    latencyReset();
+    check(led->count == 0 && led->hist[10] == 0, "latency: reset");
+
+    noViolations("latency");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// The model itself: writes without the peripheral clock are dropped
+///////////////////////////////////////////////////////////////////////////////
+
+static void testClockGate(void) {
+    mockReset();
+    TIM15->PSC = 7999;
+    check(mockCounts().ignored == 1 && mockPeek(TIM15_BASE + offsetof(TIM_TypeDef, PSC)) == 0,
+          "mock: write to an unclocked timer is ignored");
+    check(mockViolations() == 1, "mock: and reported");
+
+    mockReset();
+    RCC->APB2ENR |= (1 << 16);
+    TIM15->PSC = 7999;
+    check(mockPeek(TIM15_BASE + offsetof(TIM_TypeDef, PSC)) == 7999, "mock: sticks with the clock on");
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "-v") == 0) verbose = 1;
+    if (mockInit() != 0) return 1;
+
+    testClock();
+    testFlash();
+    testADCPolled();
+    testADCDMA();
+    testTIM16();
+    testTIM16OffOn();
+    testTIM16Schedule();
+    testInterrupter();
+    testFPGALink();
+    testTelemetry();
+    testProfile();
+    testLatency();
+    testClockGate();
+
+    printf("%s\n", fails ? "FAILED" : "PASSED");
+    return fails ? 1 : 0;
+}
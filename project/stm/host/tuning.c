@@ -0,0 +1,62 @@
+// tuning.c
+// Pitch error of each coil synthesis mode across the equal tempered scale
+//
+//   tuning [low Hz] [high Hz]     (default 27.5 .. 4186 Hz, the piano range)
+//
+// Per note: setTIM16FREQ() at 100 kHz, setTIM16FREQHiRes() (TIM16 with the
+// prescaler picked per note) and setTIM2FREQ() (80 MHz ticks), in cents.
+// The real setters run against the register model (periph_mock.c) and the
+// error comes from the PSC / ARR they leave behind, so the report follows
+// any change to the setter arithmetic.
+
+#include "../lib/STM32L432KC_TIM.h"
+#include "periph_mock.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// What the timer really plays with PSC / ARR, against the note
+static double cents(uint32_t psc, uint32_t arr, float targetHz) {
+    double hz = (double)TIM_KERNEL_CLK_HZ / (((double)psc + 1.0) * ((double)arr + 1.0));
+    return 1200.0 * log2(hz / targetHz);
+}
+
+static void printTuningReport(float lowHz, float highHz) {
+    initTIM16PWM();
+    initTIM2Synth();
+
+    // A4 = 440 Hz
+    printf("note  freq(Hz)  TIM16@100k  TIM16 hi-res  TIM2@80M (cents)\n");
+    for (int midi = 21; midi <= 108; midi++) {
+        float f = 440.0f * powf(2.0f, (midi - 69) / 12.0f);
+        if (f < lowHz || f > highHz) continue;
+
+        // The preload registers, what the next update event latches
+        setTIM16FREQ((uint32_t)f);
+        double old = cents(TIM16->PSC, TIM16->ARR, f);
+
+        setTIM16FREQHiRes(f);
+        double hiRes = cents(TIM16->PSC, TIM16->ARR, f);
+
+        setTIM2FREQ(f);
+        double t2 = cents(TIM2->PSC, TIM2->ARR, f);
+
+        printf("%4d  %8.2f  %+10.2f  %+12.3f  %+9.4f\n", midi, f, old, hiRes, t2);
+    }
+}
+
+int main(int argc, char** argv) {
+    float low = argc > 1 ? (float)atof(argv[1]) : 27.5f;
+    float high = argc > 2 ? (float)atof(argv[2]) : 4186.0f;
+    if (mockInit() != 0) return 1;
+    mockReset();
+    printTuningReport(low, high);
+
+    // A setter the model rejects would make the numbers meaningless
+    if (mockViolations()) {
+        mockPrintViolations(stderr);
+        return 1;
+    }
+    return 0;
+}
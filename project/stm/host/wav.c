@@ -0,0 +1,106 @@
+// wav.c
+// Minimal RIFF/WAVE reader for the host replay tool
+
+#include "wav.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t le16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// One sample of the given format at p, -1.0..+1.0
+static float sampleAt(const uint8_t* p, int format, int bits) {
+    if (format == 3) {
+        float f;
+        memcpy(&f, p, sizeof(f));
+        return f;
+    }
+    switch (bits) {
+    case 8:  return ((int)p[0] - 128) / 128.0f;
+    case 16: return (int16_t)le16(p) / 32768.0f;
+    case 24: return (int32_t)(le32((const uint8_t[4]){0, p[0], p[1], p[2]})) / 2147483648.0f;
+    default: return (int32_t)le32(p) / 2147483648.0f;
+    }
+}
+
+int wavRead(const char* path, WavFile* wav) {
+    memset(wav, 0, sizeof(*wav));
+
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* buf = malloc(size > 0 ? (size_t)size : 1);
+    size_t len = fread(buf, 1, (size_t)size, f);
+    fclose(f);
+
+    if (len < 12 || memcmp(buf, "RIFF", 4) != 0 || memcmp(buf + 8, "WAVE", 4) != 0) {
+        fprintf(stderr, "%s: not a RIFF/WAVE file\n", path);
+        free(buf);
+        return -1;
+    }
+
+    int format = 0, bits = 0;
+    const uint8_t* data = NULL;
+    size_t dataLen = 0;
+
+    // Walk the chunks, fmt and data are all we need
+    size_t pos = 12;
+    while (pos + 8 <= len) {
+        uint32_t chunkLen = le32(buf + pos + 4);
+        const uint8_t* body = buf + pos + 8;
+        if (chunkLen > len - pos - 8) chunkLen = (uint32_t)(len - pos - 8);
+
+        if (memcmp(buf + pos, "fmt ", 4) == 0 && chunkLen >= 16) {
+            format = le16(body);
+            wav->channels = le16(body + 2);
+            wav->sampleRate = (int)le32(body + 4);
+            bits = le16(body + 14);
+            // WAVE_FORMAT_EXTENSIBLE: the real format is in the sub-format GUID
+            if (format == 0xFFFE && chunkLen >= 26) format = le16(body + 24);
+        } else if (memcmp(buf + pos, "data", 4) == 0) {
+            data = body;
+            dataLen = chunkLen;
+        }
+        pos += 8 + chunkLen + (chunkLen & 1);
+    }
+
+    int bytes = bits / 8;
+    if (data == NULL || wav->channels < 1 || wav->sampleRate <= 0 ||
+        !((format == 1 && bytes >= 1 && bytes <= 4) || (format == 3 && bits == 32))) {
+        fprintf(stderr, "%s: unsupported WAV (format %d, %d bit, %d channels)\n",
+                path, format, bits, wav->channels);
+        free(buf);
+        return -1;
+    }
+
+    size_t frameBytes = (size_t)bytes * wav->channels;
+    wav->frames = dataLen / frameBytes;
+    wav->samples = malloc((wav->frames ? wav->frames : 1) * sizeof(float));
+    for (size_t i = 0; i < wav->frames; i++) {
+        float sum = 0.0f;
+        for (int c = 0; c < wav->channels; c++) {
+            sum += sampleAt(data + i * frameBytes + (size_t)c * bytes, format, bits);
+        }
+        wav->samples[i] = sum / wav->channels;
+    }
+
+    free(buf);
+    return 0;
+}
+
+void wavFree(WavFile* wav) {
+    free(wav->samples);
+    wav->samples = NULL;
+}
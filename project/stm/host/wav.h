@@ -0,0 +1,22 @@
+// wav.h
+// Minimal RIFF/WAVE reader for the host replay tool
+
+#ifndef WAV_H
+#define WAV_H
+
+#include <stddef.h>
+
+typedef struct {
+    int sampleRate;
+    int channels;
+    size_t frames;      // samples per channel
+    float* samples;     // mono mix, -1.0..+1.0
+} WavFile;
+
+/* Reads PCM 8/16/24/32 bit or IEEE float 32 bit, any channel count (mixed
+ * down to mono). Returns 0 on success, -1 with a message on stderr. */
+int wavRead(const char* path, WavFile* wav);
+
+void wavFree(WavFile* wav);
+
+#endif
@@ -106,7 +106,10 @@ void configureADCForDMA(uint8_t channel) {
     ADC1->CFGR |= (1 << 1);   // DMACFG = 1 (circular mode)
 
     // Configure overrun mode
+    // OVRMOD = 1 keeps converting and overwrites DR, but the OVR flag is still
+    // set, so turn on its interrupt and count it (see acq_health.c)
     ADC1->CFGR |= (1 << 12);  // OVRMOD = 1
+    enableADCOverrunIRQ();
 
     // Set sampling time (fast: 2.5 cycles for high-speed audio sampling)
     if (channel < 10) {
@@ -146,3 +149,17 @@ uint16_t readADC(void) {
     // Read data
     return (uint16_t)(ADC1->DR & 0xFFFF);
 }
+
+void enableADCOverrunIRQ(void) {
+    ADC1->ISR |= (1 << 4);  // Clear stale OVR flag (write 1)
+    ADC1->IER |= (1 << 4);  // OVRIE = 1
+}
+
+int clearADCOverrun(void) {
+    // Returns 1 if an overrun was pending
+    if (ADC1->ISR & (1 << 4)) {
+        ADC1->ISR |= (1 << 4);
+        return 1;
+    }
+    return 0;
+}
@@ -118,5 +118,7 @@ void startADC(void);
 void stopADC(void);
 uint16_t readADC(void);
 void calibrateADC(void);
+void enableADCOverrunIRQ(void);
+int clearADCOverrun(void);
 
 #endif
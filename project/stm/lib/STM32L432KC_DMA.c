@@ -4,6 +4,7 @@
 #include "STM32L432KC_DMA.h"
 #include "STM32L432KC_RCC.h"
 #include "STM32L432KC_ADC.h"
+#include "STM32L432KC_TIM.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // Function definitions
@@ -24,10 +25,10 @@ void initDMA_ADC(uint16_t* buffer, uint32_t buffer_size) {
     DMA1_CSELR->CSELR |= (DMA_REQUEST_ADC1 << 0);
 
     // Configure peripheral address (ADC1 data register)
-    DMA1_Channel1->CPAR = (uint32_t)(&(ADC1->DR));
+    DMA1_Channel1->CPAR = (uint32_t)(uintptr_t)(&(ADC1->DR));
 
     // Configure memory address (buffer)
-    DMA1_Channel1->CMAR = (uint32_t)buffer;
+    DMA1_Channel1->CMAR = (uint32_t)(uintptr_t)buffer;
 
     // Configure number of data items to transfer
     DMA1_Channel1->CNDTR = buffer_size;
@@ -58,6 +59,9 @@ void initDMA_ADC(uint16_t* buffer, uint32_t buffer_size) {
 
     // Enable Half Transfer interrupt
     DMA1_Channel1->CCR |= (1 << 2);  // HTIE = 1
+
+    // Enable Transfer Error interrupt so bus errors get counted
+    DMA1_Channel1->CCR |= (1 << 3);  // TEIE = 1
 }
 
 void enableDMA_ADC(void) {
@@ -79,3 +83,60 @@ void disableDMA_ADC(void) {
 uint32_t getDMA_Counter(void) {
     return DMA1_Channel1->CNDTR;
 }
+
+void initDMA_TIM16(const uint32_t* schedule, uint32_t words, int circular) {
+    // Enable DMA1 clock
+    RCC->AHB1ENR |= (1 << 0);  // DMA1EN
+
+    // Disable DMA1 Channel 6 before configuration
+    disableDMA_TIM16();
+
+    // Configure DMA request mapping (TIM16_UP -> DMA1 Channel 6)
+    DMA1_CSELR->CSELR &= ~(0xF << 20);  // Clear C6S bits
+    DMA1_CSELR->CSELR |= (DMA_REQUEST_TIM16_UP << 20);
+
+    // Peripheral address is the timer DMA burst register (TIM16_DMAR, 0x4C)
+    DMA1_Channel6->CPAR = (uint32_t)(TIM16_BASE + 0x4C);
+
+    // Memory address is the schedule
+    DMA1_Channel6->CMAR = (uint32_t)(uintptr_t)schedule;
+
+    // Number of 32-bit words, three per schedule entry
+    DMA1_Channel6->CNDTR = words;
+
+    DMA1_Channel6->CCR = 0;  // Clear all bits first
+
+    // Memory increment mode
+    DMA1_Channel6->CCR |= (1 << 7);  // MINC = 1
+
+    // Circular mode loops the schedule forever
+    if (circular) {
+        DMA1_Channel6->CCR |= (1 << 5);  // CIRC = 1
+    }
+
+    // Memory and peripheral size: 32-bit
+    DMA1_Channel6->CCR |= (DMA_SIZE_32BIT << 10);  // MSIZE
+    DMA1_Channel6->CCR |= (DMA_SIZE_32BIT << 8);   // PSIZE
+
+    // Priority: High (below the ADC stream)
+    DMA1_Channel6->CCR |= (DMA_PRIORITY_HIGH << 12);  // PL
+
+    // Direction: Memory to Peripheral
+    DMA1_Channel6->CCR |= (1 << 4);  // DIR = 1
+}
+
+void enableDMA_TIM16(void) {
+    // Clear any pending flags for channel 6
+    DMA1->IFCR |= (0xF << 20);
+
+    // Enable DMA1 Channel 6
+    DMA1_Channel6->CCR |= (1 << 0);  // EN = 1
+}
+
+void disableDMA_TIM16(void) {
+    // Disable DMA1 Channel 6
+    DMA1_Channel6->CCR &= ~(1 << 0);  // EN = 0
+
+    // Wait until disabled
+    while (DMA1_Channel6->CCR & (1 << 0));
+}
@@ -24,7 +24,10 @@
 #define DMA1_Channel7_BASE  (0x40020080UL)
 
 // DMA Request mapping (CSELR register)
-#define DMA_REQUEST_ADC1    0
+#define DMA_REQUEST_ADC1        0
+#define DMA_REQUEST_TIM16_UP    4   // DMA1 Channel 6, C6S = 0100
+#define DMA_REQUEST_SPI1_TX     1   // DMA1 Channel 3, C3S = 0001
+#define DMA_REQUEST_USART2_TX   2   // DMA1 Channel 7, C7S = 0010
 
 // DMA Priority levels
 #define DMA_PRIORITY_LOW        0b00
@@ -64,6 +67,11 @@ typedef struct {
 #define DMA1            ((DMA_TypeDef *) DMA1_BASE)
 #define DMA1_Channel1   ((DMA_Channel_TypeDef *) DMA1_Channel1_BASE)
 #define DMA1_Channel2   ((DMA_Channel_TypeDef *) DMA1_Channel2_BASE)
+#define DMA1_Channel3   ((DMA_Channel_TypeDef *) DMA1_Channel3_BASE)
+#define DMA1_Channel4   ((DMA_Channel_TypeDef *) DMA1_Channel4_BASE)
+#define DMA1_Channel5   ((DMA_Channel_TypeDef *) DMA1_Channel5_BASE)
+#define DMA1_Channel6   ((DMA_Channel_TypeDef *) DMA1_Channel6_BASE)
+#define DMA1_Channel7   ((DMA_Channel_TypeDef *) DMA1_Channel7_BASE)
 #define DMA1_CSELR      ((DMA_Request_TypeDef *) (DMA1_BASE + 0xA8))
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -74,5 +82,8 @@ void initDMA_ADC(uint16_t* buffer, uint32_t buffer_size);
 void enableDMA_ADC(void);
 void disableDMA_ADC(void);
 uint32_t getDMA_Counter(void);
+void initDMA_TIM16(const uint32_t* schedule, uint32_t words, int circular);
+void enableDMA_TIM16(void);
+void disableDMA_TIM16(void);
 
 #endif
@@ -0,0 +1,21 @@
+// STM32L432KC_DWT.c
+// Source code for the DWT cycle counter
+
+#include "STM32L432KC_DWT.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Function definitions
+///////////////////////////////////////////////////////////////////////////////
+
+void initDWT(void) {
+    // Turn on the trace block, otherwise DWT writes are ignored
+    COREDEBUG->DEMCR |= (1 << 24);  // TRCENA
+
+    // Start counting from zero
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= (1 << 0);          // CYCCNTENA
+}
+
+uint32_t cyclesToMicros(uint32_t cycles) {
+    return cycles / (DWT_CPU_HZ / 1000000UL);
+}
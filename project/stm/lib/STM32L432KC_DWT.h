@@ -0,0 +1,57 @@
+// STM32L432KC_DWT.h
+// Header for the Cortex-M4 DWT cycle counter
+
+#ifndef STM32L4_DWT_H
+#define STM32L4_DWT_H
+
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Definitions
+///////////////////////////////////////////////////////////////////////////////
+
+#define __IO volatile
+
+// Base addresses
+#define DWT_BASE        (0xE0001000UL) // Data watchpoint and trace unit
+#define COREDEBUG_BASE  (0xE000EDF0UL) // Core debug registers
+
+// CPU clock the cycle counter runs at
+#define DWT_CPU_HZ      80000000UL
+
+///////////////////////////////////////////////////////////////////////////////
+// DWT register structures
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    __IO uint32_t CTRL;     // Control register,                      offset: 0x00
+    __IO uint32_t CYCCNT;   // Cycle count register,                  offset: 0x04
+    __IO uint32_t CPICNT;   // CPI count register,                    offset: 0x08
+    __IO uint32_t EXCCNT;   // Exception overhead count register,     offset: 0x0C
+    __IO uint32_t SLEEPCNT; // Sleep count register,                  offset: 0x10
+    __IO uint32_t LSUCNT;   // LSU count register,                    offset: 0x14
+    __IO uint32_t FOLDCNT;  // Folded instruction count register,     offset: 0x18
+} DWT_TypeDef;
+
+typedef struct {
+    __IO uint32_t DHCSR;    // Debug halting control and status,      offset: 0x00
+    __IO uint32_t DCRSR;    // Debug core register selector,          offset: 0x04
+    __IO uint32_t DCRDR;    // Debug core register data,              offset: 0x08
+    __IO uint32_t DEMCR;    // Debug exception and monitor control,   offset: 0x0C
+} CoreDebug_TypeDef;
+
+#define DWT         ((DWT_TypeDef *) DWT_BASE)
+#define COREDEBUG   ((CoreDebug_TypeDef *) COREDEBUG_BASE)
+
+// Raw cycle count, wraps every ~53 s at 80 MHz. Subtracting two readings as
+// uint32_t gives the right answer across one wrap.
+#define DWT_CYCLES() (DWT->CYCCNT)
+
+///////////////////////////////////////////////////////////////////////////////
+// Function prototypes
+///////////////////////////////////////////////////////////////////////////////
+
+void initDWT(void);
+uint32_t cyclesToMicros(uint32_t cycles);
+
+#endif
@@ -2,8 +2,60 @@
 // Source code for FLASH functions
 
 #include "STM32L432KC_FLASH.h"
+#include "STM32L432KC_PWR.h"
 
-void configureFlash() {
-    FLASH->ACR |= (0b100); // Set to 4 waitstates
-    FLASH->ACR |= (1 << 8); // Turn on the ART
-}
\ No newline at end of file
+///////////////////////////////////////////////////////////////////////////////
+// Function definitions
+///////////////////////////////////////////////////////////////////////////////
+
+int flashLatency(uint32_t hclkHz, int range) {
+    uint32_t step = FLASH_RANGE1_STEP_HZ;
+    uint32_t max = FLASH_RANGE1_MAX_HZ;
+    if (range == PWR_RANGE2) {
+        step = FLASH_RANGE2_STEP_HZ;
+        max = FLASH_RANGE2_MAX_HZ;
+    }
+    if (hclkHz > max) return -1;
+
+    // Range 2's last step is 18 -> 26 MHz, the rest are even
+    int ws = (int)((hclkHz + step - 1) / step) - 1;
+    if (ws < 0) ws = 0;
+    if (range == PWR_RANGE2 && ws > 3) ws = 3;
+    return ws;
+}
+
+static void setLatency(int ws) {
+    FLASH->ACR = (FLASH->ACR & ~FLASH_ACR_LATENCY) | (uint32_t)ws;
+
+    // The new value only applies once it reads back
+    while ((int)(FLASH->ACR & FLASH_ACR_LATENCY) != ws);
+}
+
+int configureFlash(uint32_t hclkHz, int lowPower) {
+    int range = (lowPower && hclkHz <= FLASH_RANGE2_MAX_HZ) ? PWR_RANGE2 : PWR_RANGE1;
+    int ws = flashLatency(hclkHz, range);
+    if (ws < 0) return -1;
+
+    // At the same HCLK range 2 needs at least the wait states of range 1,
+    // so the wait states change on the range 1 side of a range change
+    if (range == PWR_RANGE1) {
+        pwrSetRange(PWR_RANGE1);
+        setLatency(ws);
+    } else {
+        setLatency(ws);
+        pwrSetRange(PWR_RANGE2);
+    }
+
+    FLASH->ACR |= FLASH_ACR_PRFTEN | FLASH_ACR_ICEN | FLASH_ACR_DCEN;
+    return ws;
+}
+
+void flashCacheReset(void) {
+    uint32_t on = FLASH->ACR & (FLASH_ACR_ICEN | FLASH_ACR_DCEN);
+
+    // ICRST / DCRST are only taken with the caches off
+    FLASH->ACR &= ~(FLASH_ACR_ICEN | FLASH_ACR_DCEN);
+    FLASH->ACR |= FLASH_ACR_ICRST | FLASH_ACR_DCRST;
+    FLASH->ACR &= ~(FLASH_ACR_ICRST | FLASH_ACR_DCRST);
+    FLASH->ACR |= on;
+}
@@ -15,6 +15,20 @@
 // Base addresses for GPIO ports
 #define FLASH_BASE (0x40022000UL) // base address of RCC
 
+// ACR bits
+#define FLASH_ACR_LATENCY   (0b111 << 0)    // wait states
+#define FLASH_ACR_PRFTEN    (1 << 8)        // prefetch
+#define FLASH_ACR_ICEN      (1 << 9)        // instruction cache
+#define FLASH_ACR_DCEN      (1 << 10)       // data cache
+#define FLASH_ACR_ICRST     (1 << 11)       // instruction cache reset
+#define FLASH_ACR_DCRST     (1 << 12)       // data cache reset
+
+// Highest HCLK for 0, 1, 2... wait states (RM0394 table 9)
+#define FLASH_RANGE1_STEP_HZ    16000000UL  // 16, 32, 48, 64, 80 MHz
+#define FLASH_RANGE1_MAX_HZ     80000000UL
+#define FLASH_RANGE2_STEP_HZ    6000000UL   // 6, 12, 18, 26 MHz
+#define FLASH_RANGE2_MAX_HZ     26000000UL
+
 ///////////////////////////////////////////////////////////////////////////////
 // Bitfield struct for GPIO
 ///////////////////////////////////////////////////////////////////////////////
@@ -35,6 +49,19 @@ typedef struct {
 // Function prototypes
 ///////////////////////////////////////////////////////////////////////////////
 
-void configureFlash(void);
+// Fewest wait states that are legal at hclkHz in the voltage range
+// (PWR_RANGE1 / PWR_RANGE2), -1 if hclkHz is above what the range allows
+int flashLatency(uint32_t hclkHz, int range);
+
+// Sets the voltage range and the fewest wait states for the HCLK about to be
+// used, and turns on prefetch, I-cache and D-cache. Call it before switching
+// to a faster clock and after switching to a slower one. Range 2 is picked
+// when lowPower is set and hclkHz allows it, range 1 otherwise. Returns the
+// wait states, or -1 (nothing changed) if hclkHz is above 80 MHz.
+int configureFlash(uint32_t hclkHz, int lowPower);
+
+// Invalidates both caches, e.g. after the flash was programmed. They are
+// turned off for the reset and back on as they were.
+void flashCacheReset(void);
 
-#endif
\ No newline at end of file
+#endif
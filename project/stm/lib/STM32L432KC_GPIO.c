@@ -39,4 +39,23 @@ void digitalWrite(int pin, int val) {
 void togglePin(int pin) {
     // Use XOR to toggle
     GPIO->ODR ^= (1 << pin);
-}
\ No newline at end of file
+}
+
+void gpioAltFunction(int pin, int af) {
+    gpioPortAltFunction(GPIO, pin, af);
+}
+
+void gpioPortAltFunction(GPIO_TypeDef* port, int pin, int af) {
+    // MODER = 10 (alternate function)
+    port->MODER &= ~(0b11 << 2*pin);
+    port->MODER |= (0b10 << 2*pin);
+
+    // AFRL holds pins 0-7, AFRH holds pins 8-15, 4 bits each
+    if (pin < 8) {
+        port->AFRL &= ~(0xF << (4*pin));
+        port->AFRL |= ((af & 0xF) << (4*pin));
+    } else {
+        port->AFRH &= ~(0xF << (4*(pin-8)));
+        port->AFRH |= ((af & 0xF) << (4*(pin-8)));
+    }
+}
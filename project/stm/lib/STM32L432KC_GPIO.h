@@ -62,6 +62,10 @@ void togglePin(int pin);
 
 void initAltFxn(void);
 
+void gpioAltFunction(int pin, int af);
+
+void gpioPortAltFunction(GPIO_TypeDef* port, int pin, int af);
+
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+// STM32L432KC_PWR.c
+// Source code for PWR functions
+
+#include "STM32L432KC_PWR.h"
+#include "STM32L432KC_RCC.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Function definitions
+///////////////////////////////////////////////////////////////////////////////
+
+void pwrSetRange(int range) {
+    // PWR registers need the APB1 clock
+    RCC->APB1ENR1 |= (1 << 28);     // PWREN
+
+    uint32_t vos = (range == PWR_RANGE2) ? 0b10 : 0b01;
+    if (((PWR->CR1 >> 9) & 0b11) == vos) return;
+
+    PWR->CR1 = (PWR->CR1 & ~(0b11 << 9)) | (vos << 9);
+
+    // Wait for the regulator to settle
+    while ((PWR->SR2 >> 10) & 1);   // VOSF
+}
+
+int pwrRange(void) {
+    return (((PWR->CR1 >> 9) & 0b11) == 0b10) ? PWR_RANGE2 : PWR_RANGE1;
+}
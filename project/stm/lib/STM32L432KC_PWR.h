@@ -0,0 +1,49 @@
+// STM32L432KC_PWR.h
+// Header for PWR functions (core voltage range)
+
+#ifndef STM32L4_PWR_H
+#define STM32L4_PWR_H
+
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Definitions
+///////////////////////////////////////////////////////////////////////////////
+
+#define __IO volatile
+
+// Base addresses
+#define PWR_BASE (0x40007000UL) // base address of PWR
+
+// Voltage scaling (CR1.VOS). Range 1 runs HCLK up to 80 MHz, range 2 up to
+// 26 MHz with more flash wait states (STM32L432KC_FLASH.h) and less current.
+#define PWR_RANGE1  1
+#define PWR_RANGE2  2
+
+///////////////////////////////////////////////////////////////////////////////
+// PWR register structure
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  __IO uint32_t CR1;      /*!< PWR power control register 1,        Address offset: 0x00 */
+  __IO uint32_t CR2;      /*!< PWR power control register 2,        Address offset: 0x04 */
+  __IO uint32_t CR3;      /*!< PWR power control register 3,        Address offset: 0x08 */
+  __IO uint32_t CR4;      /*!< PWR power control register 4,        Address offset: 0x0C */
+  __IO uint32_t SR1;      /*!< PWR power status register 1,         Address offset: 0x10 */
+  __IO uint32_t SR2;      /*!< PWR power status register 2,         Address offset: 0x14 */
+  __IO uint32_t SCR;      /*!< PWR power status reset register,     Address offset: 0x18 */
+} PWR_TypeDef;
+
+#define PWR ((PWR_TypeDef *) PWR_BASE)
+
+///////////////////////////////////////////////////////////////////////////////
+// Function prototypes
+///////////////////////////////////////////////////////////////////////////////
+
+// Turns the PWR clock on, selects the range and waits for the regulator
+// (SR2.VOSF). Raise to range 1 before raising HCLK above 26 MHz, lower to
+// range 2 only after HCLK is down to 26 MHz.
+void pwrSetRange(int range);
+int pwrRange(void);
+
+#endif
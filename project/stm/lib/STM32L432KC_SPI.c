@@ -0,0 +1,108 @@
+// STM32L432KC_SPI.c
+// Source code for SPI functions (SPI1 master, ported from lab5 with DMA transmit)
+
+#include "STM32L432KC_SPI.h"
+#include "STM32L432KC_RCC.h"
+#include "STM32L432KC_DMA.h"
+
+static volatile int dmaBusy = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+// Function definitions
+///////////////////////////////////////////////////////////////////////////////
+
+void initSPI(int br, int cpol, int cpha) {
+    // Turn on GPIOA and GPIOB clock domains (GPIOAEN and GPIOBEN bits in AHB2ENR)
+    RCC->AHB2ENR |= (1 << 0) | (1 << 1);
+
+    RCC->APB2ENR |= (1 << 12); // Turn on SPI1 clock domain (SPI1EN bit in APB2ENR)
+
+    // SPI pins on port B, AF5, high speed on SCK
+    gpioPortAltFunction(GPIOB, SPI_SCK, SPI_AF);  // SPI1_SCK
+    gpioPortAltFunction(GPIOB, SPI_MISO, SPI_AF); // SPI1_MISO
+    gpioPortAltFunction(GPIOB, SPI_MOSI, SPI_AF); // SPI1_MOSI
+    GPIOB->OSPEEDR |= (0b11 << (2*SPI_SCK));
+
+    // Manual CS, idle high
+    pinMode(SPI_CE, GPIO_OUTPUT);
+    digitalWrite(SPI_CE, GPIO_HIGH);
+
+    SPI1->CR1 = 0;
+    SPI1->CR1 |= ((br & 0x7) << 3);   // Set baud rate divider
+    SPI1->CR1 |= (1 << 2);            // MSTR
+    SPI1->CR1 |= ((cpol & 1) << 1);   // CPOL
+    SPI1->CR1 |= ((cpha & 1) << 0);   // CPHA
+
+    SPI1->CR2 &= ~(0xF << 8);
+    SPI1->CR2 |= (0b0111 << 8);       // DS = 8 bit
+    SPI1->CR2 |= (1 << 12) | (1 << 2); // FRXTH, SSOE
+
+    SPI1->CR1 |= (1 << 6);            // Enable SPI (SPE)
+}
+
+char spiSendReceive(char send) {
+    while(!(SPI1->SR & (1 << 1))); // Wait until the transmit buffer is empty (TXE)
+    *(volatile char *) (&SPI1->DR) = send; // Transmit the character over SPI
+    while(!(SPI1->SR & (1 << 0))); // Wait until data has been received (RXNE)
+    char rec = (volatile char) SPI1->DR;
+    return rec; // Return received character
+}
+
+int spiSendDMA(const uint8_t* data, uint32_t len) {
+    if (dmaBusy) return -1;
+    dmaBusy = 1;
+
+    RCC->AHB1ENR |= (1 << 0);  // DMA1EN
+
+    // Nothing reads the receive side during a DMA send, flush it and the
+    // overrun flag from the last transfer (read DR, then SR)
+    while (SPI1->SR & (1 << 0)) (void)*(volatile uint8_t *)&SPI1->DR;
+    (void)SPI1->SR;
+
+    DMA1_Channel3->CCR &= ~(1 << 0);
+    while (DMA1_Channel3->CCR & (1 << 0));
+
+    // SPI1_TX -> DMA1 Channel 3
+    DMA1_CSELR->CSELR &= ~(0xF << 8);
+    DMA1_CSELR->CSELR |= (DMA_REQUEST_SPI1_TX << 8);
+
+    DMA1_Channel3->CPAR = (uint32_t)(uintptr_t)(&(SPI1->DR));
+    DMA1_Channel3->CMAR = (uint32_t)(uintptr_t)data;
+    DMA1_Channel3->CNDTR = len;
+
+    DMA1_Channel3->CCR = 0;
+    DMA1_Channel3->CCR |= (1 << 7);                     // MINC
+    DMA1_Channel3->CCR |= (DMA_SIZE_8BIT << 10);        // MSIZE
+    DMA1_Channel3->CCR |= (DMA_SIZE_8BIT << 8);         // PSIZE
+    DMA1_Channel3->CCR |= (DMA_PRIORITY_MEDIUM << 12);  // PL
+    DMA1_Channel3->CCR |= (1 << 4);                     // DIR = mem -> periph
+    DMA1_Channel3->CCR |= (1 << 1);                     // TCIE
+
+    DMA1->IFCR |= (0xF << 8);  // Clear channel 3 flags
+
+    digitalWrite(SPI_CE, GPIO_LOW);     // start of frame
+    DMA1_Channel3->CCR |= (1 << 0);     // EN
+    SPI1->CR2 |= (1 << 1);              // TXDMAEN
+
+    return 0;
+}
+
+int spiDMABusy(void) {
+    return dmaBusy;
+}
+
+void DMA1_Channel3_IRQHandler(void) {
+    if (DMA1->ISR & (1 << 9)) {         // TCIF3
+        DMA1->IFCR |= (0xF << 8);
+
+        // DMA is done once the last byte is in the FIFO, wait for the wire:
+        // FTLVL = 0 then BSY = 0 (RM0394 40.4.9)
+        while (SPI1->SR & (0b11 << 11));
+        while (SPI1->SR & (1 << 7));
+
+        SPI1->CR2 &= ~(1 << 1);             // TXDMAEN off
+        DMA1_Channel3->CCR &= ~(1 << 0);
+        digitalWrite(SPI_CE, GPIO_HIGH);    // end of frame
+        dmaBusy = 0;
+    }
+}
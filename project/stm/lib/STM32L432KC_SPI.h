@@ -0,0 +1,67 @@
+// STM32L432KC_SPI.h
+// Header for SPI functions (SPI1 master, ported from lab5 with DMA transmit)
+
+#ifndef STM32L4_SPI_H
+#define STM32L4_SPI_H
+
+#include <stdint.h>
+#include "STM32L432KC_GPIO.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Definitions
+///////////////////////////////////////////////////////////////////////////////
+
+#define __IO volatile
+
+// Base addresses
+#define SPI1_BASE (0x40013000UL)
+
+// Pins, same as lab5: SCK PB3, MISO PB4, MOSI PB5 (AF5), manual CS on PA11
+#define SPI_SCK   3     // GPIOB
+#define SPI_MISO  4     // GPIOB
+#define SPI_MOSI  5     // GPIOB
+#define SPI_CE    11    // GPIOA
+#define SPI_AF    5
+
+///////////////////////////////////////////////////////////////////////////////
+// SPI register structures
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    __IO uint32_t CR1;      // SPI control register 1,              offset: 0x00
+    __IO uint32_t CR2;      // SPI control register 2,              offset: 0x04
+    __IO uint32_t SR;       // SPI status register,                 offset: 0x08
+    __IO uint32_t DR;       // SPI data register,                   offset: 0x0C
+    __IO uint32_t CRCPR;    // SPI CRC polynomial register,         offset: 0x10
+    __IO uint32_t RXCRCR;   // SPI RX CRC register,                 offset: 0x14
+    __IO uint32_t TXCRCR;   // SPI TX CRC register,                 offset: 0x18
+} SPI_TypeDef;
+
+#define SPI1 ((SPI_TypeDef *) SPI1_BASE)
+
+///////////////////////////////////////////////////////////////////////////////
+// Function prototypes
+///////////////////////////////////////////////////////////////////////////////
+
+/* Enables the SPI peripheral and intializes its clock speed (baud rate), polarity, and phase.
+ *    -- br: (0b000 - 0b111). The SPI clk will be the master clock / 2^(BR+1).
+ *    -- cpol: clock polarity (0: inactive state is logical 0, 1: inactive state is logical 1).
+ *    -- cpha: clock phase (0: data captured on leading edge of clk and changed on next edge,
+ *          1: data changed on leading edge of clk and captured on next edge)
+ * Refer to the datasheet for more low-level details. */
+void initSPI(int br, int cpol, int cpha);
+
+/* Transmits a character (1 byte) over SPI and returns the received character.
+ *    -- send: the character to send over SPI
+ *    -- return: the character received over SPI */
+char spiSendReceive(char send);
+
+/* Starts a DMA transfer of len bytes (DMA1 Channel 3). CS is pulled low here
+ * and released from the DMA interrupt once the last bit is on the wire.
+ *    -- return: 0 if started, -1 if the previous transfer is still going */
+int spiSendDMA(const uint8_t* data, uint32_t len);
+
+/* 1 while a DMA transfer is in flight */
+int spiDMABusy(void);
+
+#endif
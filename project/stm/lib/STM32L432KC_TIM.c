@@ -9,6 +9,47 @@
 #ifndef STM32L4_RCC_H
 #include "STM32L432KC_RCC.h"
 #endif
+#include "STM32L432KC_DMA.h"
+
+// Coil pulse limits shared by every output path, 0 = no limit (50% duty)
+static uint32_t pulseMaxOnUs = 0;
+static uint32_t pulseMaxDutyPermille = 0;
+
+// updateTIM16FREQ() wrote CCR1 = 0 and cleared UIF, so once UIF is set again
+// that zero has gone through an update event and the output really is low
+static int tim16ZeroWritten = 0;
+
+static int tim16Silent(void){
+  // CCR1 is only the preload, it says nothing about the running period.
+  // Anyone else writing a pulse into it (schedule, interrupter) also ends it.
+  return tim16ZeroWritten && TIM16->CCR1 == 0 && (TIM16->SR & (1 << 0));
+}
+
+void setPulseLimits(uint32_t maxOnTimeUs, uint32_t maxDutyPermille){
+  // Takes effect the next time a frequency is set. The limit ends up in the
+  // compare register, so the timer enforces it on every period by itself.
+  pulseMaxOnUs = maxOnTimeUs;
+  pulseMaxDutyPermille = maxDutyPermille;
+}
+
+uint32_t pulseTicks(uint32_t tickHz, uint32_t ticks){
+  // On-time for one period of `ticks` counts at `tickHz`:
+  // min(50%, max on-time, duty cap)
+  uint32_t on = ticks / 2;
+
+  if(pulseMaxOnUs != 0){
+    uint32_t onLimit = (uint32_t)(((uint64_t)tickHz * pulseMaxOnUs) / 1000000UL);
+    if(on > onLimit) on = onLimit;
+  }
+  if(pulseMaxDutyPermille != 0){
+    uint32_t dutyLimit = (uint32_t)(((uint64_t)ticks * pulseMaxDutyPermille) / 1000UL);
+    if(on > dutyLimit) on = dutyLimit;
+  }
+
+  if(on < 1) on = 1; // a limit that rounds to zero still makes a pulse
+  return on;
+}
+
 void initTIM16PWM(void){
    //////////////////////////////////////////////////////////////////
    // using TIM16 for driving a pin at pitch frequency
@@ -85,6 +126,9 @@ void initTIM16PWM(void){
 
   // try two, from scratch
   // using pwm channel 1
+  // clock has to be on before any of the register writes below stick
+  RCC->APB2ENR |= (1 << 17); // tim 16
+
   //16.6 bits per second, so  min freq is 1.5 hz (100000/(2^16))
   TIM16->PSC = 799; // 100000 hz
   // set PWM mode 1
@@ -129,8 +173,14 @@ void initTIM16PWM(void){
   //CC1NE 0
   TIM16->CCER &= ~(1 << 2); 
 
+  // start silent on a short 1 ms period with the output held low, so the
+  // first note latches within 1 ms instead of after the 0xFFFF reset period
+  TIM16->ARR = TIM16_CLK_HZ / 1000 - 1;
+  TIM16->CCR1 = 0;
+
   // Initialize all registers by setting UG bit in TIM16_EGR register
   TIM16->EGR |= (1<<0); // in instructions, this was earlier/ See page 906 of ref manual.
+  tim16ZeroWritten = 1; // UG latched the zero and set UIF
 
   //enable
   TIM16->CR1 |= (1<<0); 
@@ -227,15 +277,16 @@ void setTIM16FREQ(uint32_t freqHz){
     const int TIM16Freq = 100000;//hz. cycles/sec Calculated by: 80 Mhz / 800
     uint16_t maxcnt = ceil(TIM16Freq/freqHz) -1; // -1 or no?
 
-    //TIM16->PSC = 0; // freq/ (num + 1) -> No division.
+    TIM16->PSC = 799; // back to 100 kHz in case the hi-res mode moved it
     TIM16->ARR = maxcnt;// on reload new count register
-    TIM16->CCR1 = ceil(maxcnt/2); // Duty cycle 50% = 1/2 (ARR+1)
+    TIM16->CCR1 = pulseTicks(TIM16Freq, maxcnt + 1); // Duty cycle 50% = 1/2 (ARR+1), or less if limited
     //TIM16->EGR |= (1<<0); 
     TIM16->SR &= ~(1<<0); // TODO: UIF THIS IS BEING FORCED HIGH FOR SOME REASON SHDFLkHDSA
    //*((uint32_t*)(0x40014410)) &= ~(1<<0);
 
     TIM16->CNT = 0;
   }
+  tim16ZeroWritten = 0;
 }
 
 void setTIM15Count(int ms){
@@ -248,4 +299,198 @@ void setTIM15Count(int ms){
   TIM15->ARR = maxcnt;   /* Auto-Reload Register        0x2C */
   TIM15->EGR |= (0b1<<0); // force things to update by writing UG bit to 0
   TIM15->SR &= ~(1<<0);
-}
\ No newline at end of file
+}
+
+void updateTIM16FREQ(uint32_t freqHz){
+  // Glitch-free version of setTIM16FREQ.
+  // ARR and CCR1 are both preloaded (ARPE + OC1PE from initTIM16PWM), so the
+  // new values only move into the shadow registers on the next update event.
+  // The counter is never reset and the clock is never gated, so the pulse that
+  // is currently playing always finishes and the new note starts on the
+  // period boundary. From silence (a zero duty already latched, not just
+  // written) there is no pulse to finish, so the new note starts at once.
+  uint16_t maxcnt;
+  uint16_t duty;
+  int silent = tim16Silent();
+
+  if(freqHz == 0){
+    // keep the current period running, just hold the output low
+    maxcnt = TIM16->ARR;
+    duty = 0;
+  } else {
+    // round to nearest instead of ceil, halves the worst case pitch error
+    uint32_t ticks = (TIM16_CLK_HZ + freqHz/2) / freqHz;
+    if(ticks < 2) ticks = 2;
+    if(ticks > 0x10000) ticks = 0x10000;
+    maxcnt = ticks - 1;
+    duty = pulseTicks(TIM16_CLK_HZ, ticks); // 50% unless the pulse limits say less
+  }
+
+  // UDIS blocks the preload -> shadow transfer while we are halfway through
+  // writing the pair, so an overflow in between can never pair a new ARR with
+  // an old CCR1. The counter still wraps normally while UDIS is set.
+  TIM16->CR1 |= (1 << 1);  // UDIS
+  TIM16->PSC = 799;        // back to 100 kHz in case the hi-res mode moved it
+  TIM16->ARR = maxcnt;
+  TIM16->CCR1 = duty;
+  // From here UIF means these values latched. Already silent and staying
+  // silent, the zero in the shadow register still holds, keep the flag.
+  if(!(silent && duty == 0)) TIM16->SR &= ~(1 << 0);
+  TIM16->CR1 &= ~(1 << 1); // next overflow latches all three
+  tim16ZeroWritten = (duty == 0);
+
+  // Output is low for the whole period: restart the counter and latch now
+  // (UG) rather than wait out what may be a long silent period. A zero that
+  // is only in the preload leaves a pulse running, that one has to finish.
+  if(silent && duty != 0) TIM16->EGR |= (1 << 0);
+}
+
+int makeTIM16ScheduleEntry(uint32_t freqHz, uint32_t durationMs, uint32_t* entry,
+                           uint32_t maxEntries){
+  // One entry is the three registers the DMA burst writes: ARR, RCR, CCR1.
+  // RCR makes the entry last (RCR+1) periods, so the note length is handled
+  // by the timer too. RCR is only 8 bits, so a note longer than 256 periods
+  // is split over several entries with the same ARR / CCR1.
+  uint32_t ticks;
+  uint32_t duty;
+
+  if(freqHz == 0){
+    ticks = TIM16_CLK_HZ / 100; // rest in 10 ms steps
+    duty = 0;
+  } else {
+    ticks = (TIM16_CLK_HZ + freqHz/2) / freqHz;
+    if(ticks < 2) ticks = 2;
+    if(ticks > 0x10000) ticks = 0x10000;
+    duty = pulseTicks(TIM16_CLK_HZ, ticks);
+  }
+
+  // number of whole periods that fit in the duration
+  uint32_t periods = ((uint64_t)durationMs * TIM16_CLK_HZ) / (1000ULL * ticks);
+  if(periods < 1) periods = 1;
+
+  uint32_t needed = (periods + 255) / 256;
+  if(needed > maxEntries) return -1;
+
+  for(uint32_t i = 0; i < needed; i++){
+    uint32_t n = periods > 256 ? 256 : periods;
+    periods -= n;
+    entry[0] = ticks - 1;  // ARR
+    entry[1] = n - 1;      // RCR
+    entry[2] = duty;       // CCR1
+    entry += TIM16_SCHEDULE_WORDS;
+  }
+  return (int)needed;
+}
+
+void startTIM16Schedule(const uint32_t* schedule, uint32_t entries, int loop){
+  // Stream a list of {ARR, RCR, CCR1} entries into TIM16 with a DMA burst on
+  // every update event (section 28.4.21 / DMA burst mode). No CPU time per
+  // note once this is running.
+  RCC->AHB1ENR |= (1 << 0); // DMA1, stopTIM16Schedule writes channel 6
+  stopTIM16Schedule();
+  tim16ZeroWritten = 0;
+
+  initDMA_TIM16(schedule, entries * TIM16_SCHEDULE_WORDS, loop);
+
+  // DCR: DBA = offset of ARR in words (0x2C / 4 = 11), DBL = 3 transfers
+  TIM16->DCR = ((TIM16_SCHEDULE_WORDS - 1) << 8) | (0x2C >> 2);
+
+  enableDMA_TIM16();
+  TIM16->DIER |= (1 << 8); // UDE, DMA request on update
+}
+
+void stopTIM16Schedule(void){
+  TIM16->DIER &= ~(1 << 8); // UDE off first so nothing is half written
+  disableDMA_TIM16();
+}
+
+void initTIM2Synth(void){
+  // Same PWM mode 1 setup as TIM16, but TIM2 has a 32 bit counter so it can
+  // count the 80 MHz kernel clock directly. At 4 kHz that is 20000 ticks per
+  // period, so the rounding error is ~0.04 cents instead of ~4%.
+  RCC->APB1ENR1 |= (1 << 0); // tim 2
+
+  TIM2->PSC = 0; // 80 MHz
+
+  // PWM mode 1 on channel 1
+  TIM2->CCMR1 &= ~(0x7 << 4);
+  TIM2->CCMR1 |= (0b110 << 4);
+
+  // OC1PE, CCR1 is preloaded
+  TIM2->CCMR1 |= (0b1 << 3);
+
+  // ARPE, ARR is preloaded
+  TIM2->CR1 |= (0b1 << 7);
+
+  // start silent, 1 kHz period with the output held low
+  TIM2->ARR = TIM_KERNEL_CLK_HZ / 1000 - 1;
+  TIM2->CCR1 = 0;
+
+  // CC1E, active high (general purpose timer, no MOE/BDTR)
+  TIM2->CCER &= ~(1 << 1);
+  TIM2->CCER |= (1 << 0);
+
+  // load the preload registers and go
+  TIM2->EGR |= (1 << 0);
+  TIM2->CR1 |= (1 << 0);
+}
+
+float timerCentsError(uint32_t tickHz, uint32_t ticks, float targetHz){
+  // 1200 * log2(actual / wanted)
+  if(ticks == 0 || targetHz <= 0) return 0;
+  float actual = (float)tickHz / (float)ticks;
+  return 1200.0f * log2f(actual / targetHz);
+}
+
+float setTIM2FREQ(float freqHz){
+  uint32_t ticks;
+  uint32_t duty;
+
+  if(freqHz <= 0){
+    ticks = TIM2->ARR + 1;
+    duty = 0;
+  } else {
+    ticks = (uint32_t)((float)TIM_KERNEL_CLK_HZ / freqHz + 0.5f);
+    if(ticks < 2) ticks = 2;
+    duty = pulseTicks(TIM_KERNEL_CLK_HZ, ticks);
+  }
+
+  // same UDIS trick as updateTIM16FREQ, lands on the next period boundary
+  TIM2->CR1 |= (1 << 1);
+  TIM2->ARR = ticks - 1;
+  TIM2->CCR1 = duty;
+  TIM2->CR1 &= ~(1 << 1);
+
+  if(freqHz <= 0) return 0;
+  return timerCentsError(TIM_KERNEL_CLK_HZ, ticks, freqHz);
+}
+
+float setTIM16FREQHiRes(float freqHz){
+  // TIM16 is only 16 bits, so pick the smallest prescaler that still fits the
+  // period in ARR. Lower PSC = more ticks per period = finer pitch steps.
+  if(freqHz <= 0){
+    updateTIM16FREQ(0);
+    return 0;
+  }
+
+  uint32_t psc = (uint32_t)((float)TIM_KERNEL_CLK_HZ / (freqHz * 65536.0f));
+  if(psc > 0xFFFF) psc = 0xFFFF;
+  uint32_t tickHz = TIM_KERNEL_CLK_HZ / (psc + 1);
+  uint32_t ticks = (uint32_t)((float)tickHz / freqHz + 0.5f);
+  if(ticks > 0x10000){ // rounding pushed it over, go one prescaler up
+    psc++;
+    tickHz = TIM_KERNEL_CLK_HZ / (psc + 1);
+    ticks = (uint32_t)((float)tickHz / freqHz + 0.5f);
+  }
+  if(ticks < 2) ticks = 2;
+
+  // PSC is always buffered, so it latches on the same update as ARR/CCR1
+  TIM16->CR1 |= (1 << 1);
+  TIM16->PSC = psc;
+  TIM16->ARR = ticks - 1;
+  TIM16->CCR1 = pulseTicks(tickHz, ticks);
+  TIM16->CR1 &= ~(1 << 1);
+  tim16ZeroWritten = 0;
+
+  return timerCentsError(tickHz, ticks, freqHz);
+}
@@ -14,9 +14,20 @@
 #define __IO volatile
 
 // Base addresses
+#define TIM2_BASE  (0x40000000UL) // base address of TIM2 (32 bit counter)
+#define TIM1_BASE  (0x40012C00UL) // base address of TIM1 (advanced timer)
 #define TIM15_BASE (0x40014000UL) // base address of TIM15
 #define TIM16_BASE (0x40014400UL) // base address of TIM16
 
+// timer kernel clock, APB1/APB2 prescalers are left at 1
+#define TIM_KERNEL_CLK_HZ 80000000UL
+
+// TIM16 counts at 80 MHz / (PSC+1) = 100 kHz (PSC = 799 in initTIM16PWM)
+#define TIM16_CLK_HZ 100000UL
+
+// words per entry in a TIM16 DMA schedule: ARR, RCR, CCR1
+#define TIM16_SCHEDULE_WORDS 3
+
 /**
   * @brief Reset and Clock Control
   */
@@ -30,7 +41,7 @@ typedef struct
    __IO uint32_t SR;    /* Status Register          0x10 */
    __IO uint32_t EGR;   /* Event Generation reg     0x14 */
    __IO uint32_t CCMR1; /* CCMR1                    0x18 */
-   uint32_t reserved;   /*                          0x1C */
+   __IO uint32_t CCMR2; /* CCMR2 (TIM2 only)        0x1C */
    __IO uint32_t CCER;  /* Capture compare en reg   0x20 */
    __IO uint32_t CNT;   /* Counter                  0x24 */
    __IO uint32_t PSC;   /* Prescaler                0x28 */
@@ -38,8 +49,8 @@ typedef struct
    __IO uint32_t RCR;   /* Repitition Counter Reg   0x30 */
    __IO uint32_t CCR1;  /* Capture Compare Reg      0x34 */
    __IO uint32_t CCR2;  /* Caputre Compare Reg 2    0x38 */
-  uint32_t reserved0;    /*                         0x3C */
-  uint32_t reserved1;    /*                         0x40 */
+   __IO uint32_t CCR3;  /* CCR3 (TIM2 only)         0x3C */
+   __IO uint32_t CCR4;  /* CCR4 (TIM2 only)         0x40 */
    __IO uint32_t BDTR;  /* Break dead time reg      0x44 */
    __IO uint32_t DCR;   /* DMA Control Reg          0x48 */
    __IO uint32_t DMAR;  /* DMA addr full transfer   0x4C */
@@ -52,6 +63,8 @@ typedef struct
 } TIM_TypeDef;
 
 
+#define TIM1  ((TIM_TypeDef *) TIM1_BASE)
+#define TIM2  ((TIM_TypeDef *) TIM2_BASE)
 #define TIM15 ((TIM_TypeDef *) TIM15_BASE)
 #define TIM16 ((TIM_TypeDef *) TIM16_BASE)
 
@@ -64,6 +77,27 @@ void initTIM15Counter(void);
 void initTIM16Counter(void);
 //void setTIM16FREQ(int freqHz);
 void setTIM16FREQ(uint32_t freq);
+void updateTIM16FREQ(uint32_t freqHz);
+
+// Coil protection. Every frequency setter clamps the pulse to
+// min(50%, maxOnTimeUs, maxDutyPermille/1000 of the period). 0 = no limit.
+void setPulseLimits(uint32_t maxOnTimeUs, uint32_t maxDutyPermille);
+uint32_t pulseTicks(uint32_t tickHz, uint32_t ticks);
+
+// Writes the {ARR, RCR, CCR1} entries for one note (several for notes
+// longer than 256 periods) and returns how many, or -1 if more than
+// maxEntries would be needed
+int makeTIM16ScheduleEntry(uint32_t freqHz, uint32_t durationMs, uint32_t* entry,
+                           uint32_t maxEntries);
+void startTIM16Schedule(const uint32_t* schedule, uint32_t entries, int loop);
+void stopTIM16Schedule(void);
+
+// High resolution synthesis. TIM2 runs PSC = 0 (80 MHz ticks) on CH1, which
+// comes out on PA5 (AF1). Both setters return the pitch error in cents.
+void initTIM2Synth(void);
+float setTIM2FREQ(float freqHz);
+float setTIM16FREQHiRes(float freqHz);
+float timerCentsError(uint32_t tickHz, uint32_t ticks, float targetHz);
 void setTIM15Count(int ms);
 
 
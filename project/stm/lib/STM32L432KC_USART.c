@@ -0,0 +1,93 @@
+// STM32L432KC_USART.c
+// Source code for USART2 functions (DMA for long transmit frames, polled receive)
+
+#include "STM32L432KC_USART.h"
+#include "STM32L432KC_RCC.h"
+#include "STM32L432KC_DMA.h"
+
+static volatile int dmaBusy = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+// Function definitions
+///////////////////////////////////////////////////////////////////////////////
+
+void initUSART(uint32_t baud) {
+    RCC->AHB2ENR |= (1 << 0);   // GPIOAEN
+    RCC->APB1ENR1 |= (1 << 17); // USART2EN
+
+    gpioPortAltFunction(GPIOA, USART_TX, USART_AF);  // USART2_TX
+    GPIOA->OSPEEDR |= (0b11 << (2*USART_TX));
+    gpioPortAltFunction(GPIOA, USART_RX, USART_RX_AF);  // USART2_RX
+
+    USART2->CR1 = 0;                        // UE = 0 before BRR / CR3
+    USART2->BRR = (USART_CLK_HZ + baud / 2) / baud;
+    USART2->CR3 = 0;
+    USART2->CR1 |= (1 << 3);                // TE
+    USART2->CR1 |= (1 << 2);                // RE
+    USART2->CR1 |= (1 << 0);                // UE
+}
+
+void usartSendChar(uint8_t c) {
+    while (!(USART2->ISR & (1 << 7)));      // TXE
+    USART2->TDR = c;
+}
+
+int usartReceiveChar(uint8_t* c) {
+    if (USART2->ISR & (1 << 3)) {           // ORE
+        USART2->ICR = (1 << 3);             // ORECF
+    }
+    if (!(USART2->ISR & (1 << 5))) {        // RXNE
+        return 0;
+    }
+    *c = (uint8_t)USART2->RDR;              // Reading RDR clears RXNE
+    return 1;
+}
+
+int usartSendDMA(const uint8_t* data, uint32_t len) {
+    if (dmaBusy) return -1;
+    dmaBusy = 1;
+
+    RCC->AHB1ENR |= (1 << 0);  // DMA1EN
+
+    DMA1_Channel7->CCR &= ~(1 << 0);
+    while (DMA1_Channel7->CCR & (1 << 0));
+
+    // USART2_TX -> DMA1 Channel 7
+    DMA1_CSELR->CSELR &= ~(0xFUL << 24);
+    DMA1_CSELR->CSELR |= ((uint32_t)DMA_REQUEST_USART2_TX << 24);
+
+    DMA1_Channel7->CPAR = (uint32_t)(uintptr_t)(&(USART2->TDR));
+    DMA1_Channel7->CMAR = (uint32_t)(uintptr_t)data;
+    DMA1_Channel7->CNDTR = len;
+
+    DMA1_Channel7->CCR = 0;
+    DMA1_Channel7->CCR |= (1 << 7);                     // MINC
+    DMA1_Channel7->CCR |= (DMA_SIZE_8BIT << 10);        // MSIZE
+    DMA1_Channel7->CCR |= (DMA_SIZE_8BIT << 8);         // PSIZE
+    DMA1_Channel7->CCR |= (DMA_PRIORITY_LOW << 12);     // PL, behind ADC and SPI
+    DMA1_Channel7->CCR |= (1 << 4);                     // DIR = mem -> periph
+    DMA1_Channel7->CCR |= (1 << 1);                     // TCIE
+
+    DMA1->IFCR |= (0xFUL << 24);       // Clear channel 7 flags
+
+    DMA1_Channel7->CCR |= (1 << 0);     // EN
+    USART2->CR3 |= (1 << 7);            // DMAT
+
+    return 0;
+}
+
+int usartDMABusy(void) {
+    return dmaBusy;
+}
+
+void DMA1_Channel7_IRQHandler(void) {
+    if (DMA1->ISR & (1UL << 25)) {      // TCIF7
+        DMA1->IFCR |= (0xFUL << 24);
+
+        // The last byte is in TDR / the shift register. The next transfer
+        // may start at once, TXE paces it, no need to wait for TC here.
+        USART2->CR3 &= ~(1 << 7);           // DMAT off
+        DMA1_Channel7->CCR &= ~(1 << 0);
+        dmaBusy = 0;
+    }
+}
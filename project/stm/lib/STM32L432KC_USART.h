@@ -0,0 +1,73 @@
+// STM32L432KC_USART.h
+// Header for USART2 functions (DMA for long transmit frames, polled receive)
+
+#ifndef STM32L4_USART_H
+#define STM32L4_USART_H
+
+#include <stdint.h>
+#include "STM32L432KC_GPIO.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Definitions
+///////////////////////////////////////////////////////////////////////////////
+
+#define __IO volatile
+
+// Base addresses
+#define USART2_BASE (0x40004400UL)
+
+// TX on PA2 (AF7), RX on PA15 (AF3), wired to the ST-Link virtual COM port
+// on the Nucleo-32
+#define USART_TX    2     // GPIOA
+#define USART_AF    7
+#define USART_RX    15    // GPIOA
+#define USART_RX_AF 3
+
+// USART2 kernel clock, PCLK1 (CCIPR.USART2SEL = 00 after reset)
+#define USART_CLK_HZ  80000000UL
+
+///////////////////////////////////////////////////////////////////////////////
+// USART register structures
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    __IO uint32_t CR1;      // Control register 1,                  offset: 0x00
+    __IO uint32_t CR2;      // Control register 2,                  offset: 0x04
+    __IO uint32_t CR3;      // Control register 3,                  offset: 0x08
+    __IO uint32_t BRR;      // Baud rate register,                  offset: 0x0C
+    __IO uint32_t GTPR;     // Guard time and prescaler register,   offset: 0x10
+    __IO uint32_t RTOR;     // Receiver timeout register,           offset: 0x14
+    __IO uint32_t RQR;      // Request register,                    offset: 0x18
+    __IO uint32_t ISR;      // Interrupt and status register,       offset: 0x1C
+    __IO uint32_t ICR;      // Interrupt flag clear register,       offset: 0x20
+    __IO uint32_t RDR;      // Receive data register,               offset: 0x24
+    __IO uint32_t TDR;      // Transmit data register,              offset: 0x28
+} USART_TypeDef;
+
+#define USART2 ((USART_TypeDef *) USART2_BASE)
+
+///////////////////////////////////////////////////////////////////////////////
+// Function prototypes
+///////////////////////////////////////////////////////////////////////////////
+
+/* Enables USART2 transmit and receive, 8N1, 16x oversampling.
+ *    -- baud: bit rate, up to USART_CLK_HZ / 16 (5 Mbaud at 80 MHz) */
+void initUSART(uint32_t baud);
+
+/* Sends one byte, waits for room in the transmit register first */
+void usartSendChar(uint8_t c);
+
+/* Takes a received byte if there is one, never waits. An overrun (a byte
+ * not read in time) is cleared here, the bytes in between are lost.
+ *    -- return: 1 with the byte in *c, 0 if nothing has arrived */
+int usartReceiveChar(uint8_t* c);
+
+/* Starts a DMA transfer of len bytes (DMA1 Channel 7). The buffer must stay
+ * untouched until usartDMABusy() returns 0.
+ *    -- return: 0 if started, -1 if the previous transfer is still going */
+int usartSendDMA(const uint8_t* data, uint32_t len);
+
+/* 1 while a DMA transfer is in flight */
+int usartDMABusy(void);
+
+#endif
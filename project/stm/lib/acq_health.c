@@ -0,0 +1,84 @@
+// acq_health.c
+// Counters that show whether the ADC -> DMA -> DSP pipeline keeps up
+
+#include "acq_health.h"
+#include "STM32L432KC_DWT.h"
+#include <stdio.h>
+
+static volatile AcqHealth health;
+static uint32_t frameStartCycles;
+
+///////////////////////////////////////////////////////////////////////////////
+// Function definitions
+///////////////////////////////////////////////////////////////////////////////
+
+void initAcqHealth(uint32_t samplesPerFrame, uint32_t sampleRateHz) {
+    initDWT();
+
+    health.adcOverruns = 0;
+    health.dmaTransferErrors = 0;
+    health.dmaHalfTransfers = 0;
+    health.dmaTransferCompletes = 0;
+    health.framesProduced = 0;
+    health.framesProcessed = 0;
+    health.framesDropped = 0;
+    health.lastProcessCycles = 0;
+    health.maxProcessCycles = 0;
+
+    // e.g. 256 samples at 8 kHz = 32 ms = 2,560,000 cycles at 80 MHz
+    health.framePeriodCycles = (uint32_t)(((uint64_t)DWT_CPU_HZ * samplesPerFrame) / sampleRateHz);
+}
+
+void acqHealthDMAFlags(uint32_t flags) {
+    if (flags & (1 << 1)) health.dmaTransferCompletes++;
+    if (flags & (1 << 2)) health.dmaHalfTransfers++;
+    if (flags & (1 << 3)) health.dmaTransferErrors++;
+}
+
+void acqHealthADCOverrun(void) {
+    health.adcOverruns++;
+}
+
+void acqHealthFrameProduced(int previousStillPending) {
+    health.framesProduced++;
+    if (previousStillPending) health.framesDropped++;
+}
+
+void acqHealthFrameStart(void) {
+    frameStartCycles = DWT_CYCLES();
+}
+
+void acqHealthFrameEnd(void) {
+    uint32_t cycles = DWT_CYCLES() - frameStartCycles;
+    health.lastProcessCycles = cycles;
+    if (cycles > health.maxProcessCycles) health.maxProcessCycles = cycles;
+    health.framesProcessed++;
+}
+
+const AcqHealth* acqHealth(void) {
+    return (const AcqHealth*)&health;
+}
+
+void acqHealthPrint(void) {
+    // Load = worst frame processing time / frame period. Above 100% the
+    // pipeline is behind real time and framesDropped starts climbing.
+    uint32_t loadPermille = 0;
+    if (health.framePeriodCycles != 0) {
+        loadPermille = (uint32_t)(((uint64_t)health.maxProcessCycles * 1000) / health.framePeriodCycles);
+    }
+
+    printf("ACQ frames %lu/%lu (dropped %lu)  OVR %lu  DMA TC %lu HT %lu TE %lu\n",
+           (unsigned long)health.framesProcessed,
+           (unsigned long)health.framesProduced,
+           (unsigned long)health.framesDropped,
+           (unsigned long)health.adcOverruns,
+           (unsigned long)health.dmaTransferCompletes,
+           (unsigned long)health.dmaHalfTransfers,
+           (unsigned long)health.dmaTransferErrors);
+    printf("ACQ process last %lu us  max %lu us  period %lu us  load %lu.%lu%%\n",
+           (unsigned long)cyclesToMicros(health.lastProcessCycles),
+           (unsigned long)cyclesToMicros(health.maxProcessCycles),
+           (unsigned long)cyclesToMicros(health.framePeriodCycles),
+           (unsigned long)(loadPermille / 10),
+           (unsigned long)(loadPermille % 10));
+}
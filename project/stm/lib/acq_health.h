@@ -0,0 +1,50 @@
+// acq_health.h
+// Counters that show whether the ADC -> DMA -> DSP pipeline keeps up
+
+#ifndef ACQ_HEALTH_H
+#define ACQ_HEALTH_H
+
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Definitions
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    // Interrupt side
+    uint32_t adcOverruns;           // ADC OVR flags, a sample was overwritten
+    uint32_t dmaTransferErrors;     // DMA TEIF, bus error on the ADC channel
+    uint32_t dmaHalfTransfers;      // DMA HTIF
+    uint32_t dmaTransferCompletes;  // DMA TCIF
+
+    // Frame accounting
+    uint32_t framesProduced;        // full buffers handed to the main loop
+    uint32_t framesProcessed;       // buffers the main loop finished
+    uint32_t framesDropped;         // buffer filled again before it was read
+
+    // Processing time in CPU cycles against the time one frame takes to fill
+    uint32_t lastProcessCycles;
+    uint32_t maxProcessCycles;
+    uint32_t framePeriodCycles;
+} AcqHealth;
+
+///////////////////////////////////////////////////////////////////////////////
+// Function prototypes
+///////////////////////////////////////////////////////////////////////////////
+
+void initAcqHealth(uint32_t samplesPerFrame, uint32_t sampleRateHz);
+
+// Call from the DMA and ADC interrupt handlers with the channel's flag bits
+// already shifted down to bit 0 (GIF, TCIF, HTIF, TEIF)
+void acqHealthDMAFlags(uint32_t flags);
+void acqHealthADCOverrun(void);
+void acqHealthFrameProduced(int previousStillPending);
+
+// Bracket the per-frame processing in the main loop
+void acqHealthFrameStart(void);
+void acqHealthFrameEnd(void);
+
+const AcqHealth* acqHealth(void);
+void acqHealthPrint(void);
+
+#endif
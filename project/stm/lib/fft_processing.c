@@ -0,0 +1,180 @@
+// fft_processing.c
+// Analyzer DSP chain: ADC block -> FFT -> notes -> detection
+
+#include "fft_processing.h"
+#include "placement.h"
+#include <math.h>
+
+// Math Constant
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+RAMFUNC void fftNormalize(const uint16_t* adc, Complex* out, int n) {
+    // ADC range: 0-4095 (12-bit)
+    // Normalize to: -1.0 to +1.0 (centered at 2048 = 1.65V)
+    for (int i = 0; i < n; i++) {
+        out[i].real = ((float)adc[i] - 2048.0f) / 2048.0f;
+        out[i].imag = 0.0f;  // No imaginary component (real signal)
+    }
+}
+
+/*******************************************************************************
+ * FAST FOURIER TRANSFORM (FFT) IMPLEMENTATION
+ * Algorithm: Cooley-Tukey Radix-2 Decimation-in-Time FFT
+ * Complexity: O(N log N) where N = FFT_SIZE
+ ******************************************************************************/
+
+/**
+ * @brief Performs in-place Fast Fourier Transform
+ * @param data Pointer to complex data array (length n, must be power of 2)
+ * @param n Number of samples (must be power of 2)
+ *
+ * ALGORITHM:
+ *   1. Bit-reversal permutation: Reorder input for in-place computation
+ *   2. Cooley-Tukey butterfly operations: Combine frequency components
+ *
+ * MATHEMATICAL BASIS:
+ *   X[k] = Σ(n=0 to N-1) x[n] * e^(-j*2π*k*n/N)
+ *   where X[k] is the frequency domain representation
+ */
+RAMFUNC void fft_compute(Complex* data, int n) {
+    int i, j;
+
+    // STEP 1: Bit-Reversal Permutation
+    // Reorders array elements so FFT can be computed in-place
+    // Example (n=8): [0,1,2,3,4,5,6,7] → [0,4,2,6,1,5,3,7]
+    for (i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+
+        // Calculate bit-reversed index
+        for (; j >= bit; bit >>= 1) {
+            j -= bit;
+        }
+        j += bit;
+
+        // Swap elements if needed
+        if (i < j) {
+            Complex temp = data[i];
+            data[i] = data[j];
+            data[j] = temp;
+        }
+    }
+
+    // STEP 2: Cooley-Tukey FFT Butterfly Operations
+    // Process in stages: pairs, then groups of 4, 8, 16, etc.
+    for (int len = 2; len <= n; len <<= 1) {
+        // Calculate twiddle factor for this stage
+        // w = e^(-j*2π/len) = cos(-2π/len) + j*sin(-2π/len)
+        float angle = -2.0f * M_PI / len;
+        Complex wlen = {cosf(angle), sinf(angle)};
+
+        // Process each group of size 'len'
+        for (i = 0; i < n; i += len) {
+            Complex w = {1.0f, 0.0f};  // w^0 = 1
+
+            // Butterfly operations within this group
+            for (j = 0; j < len / 2; j++) {
+                // Extract the two elements for butterfly
+                Complex u = data[i + j];
+
+                // Complex multiplication: v = data[i + j + len/2] * w
+                Complex v = {
+                    data[i + j + len/2].real * w.real - data[i + j + len/2].imag * w.imag,
+                    data[i + j + len/2].real * w.imag + data[i + j + len/2].imag * w.real
+                };
+
+                // Butterfly combination
+                data[i + j].real = u.real + v.real;
+                data[i + j].imag = u.imag + v.imag;
+                data[i + j + len/2].real = u.real - v.real;
+                data[i + j + len/2].imag = u.imag - v.imag;
+
+                // Update twiddle factor: w = w * wlen
+                float w_temp = w.real;
+                w.real = w.real * wlen.real - w.imag * wlen.imag;
+                w.imag = w_temp * wlen.imag + w.imag * wlen.real;
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+ * NOTE SEARCH + DETECTION
+ ******************************************************************************/
+
+RAMFUNC int fftFindNotes(const Complex* spectrum, int n, float sampleRate, float magThreshold,
+                         float minFreq, float* mags, float* noteFreqs, float* noteMags,
+                         int maxNotes) {
+    // A note is a local maximum in the magnitude spectrum. Keep the
+    // maxNotes largest, sorted loudest first (insertion sort, tiny n).
+    int noteCount = 0;
+    float prevMag = 0.0f;
+    float curMag = 0.0f;
+
+    // First bin strictly above minFreq, the search starts there. Bins below
+    // still get their magnitude and are still neighbours.
+    int firstBin = (int)(minFreq * n / sampleRate) + 1;
+    if (firstBin < 1) firstBin = 1;
+
+    mags[0] = fabsf(spectrum[0].real);
+
+    // Only check bins 1 to n/2 (skip DC, use Nyquist limit)
+    for (int i = 1; i <= n / 2; i++) {
+        // Magnitude = sqrt(real² + imag²)
+        float nextMag = 0.0f;
+        if (i < n / 2) {
+            float real = spectrum[i].real;
+            float imag = spectrum[i].imag;
+            nextMag = sqrtf(real * real + imag * imag);
+            mags[i] = nextMag;
+        }
+
+        // curMag is bin i-1, check it against both neighbours
+        int bin = i - 1;
+        if (bin >= firstBin && curMag > prevMag && curMag >= nextMag &&
+            curMag > magThreshold) {
+            int pos = noteCount < maxNotes ? noteCount : maxNotes;
+            while (pos > 0 && noteMags[pos - 1] < curMag) {
+                if (pos < maxNotes) {
+                    noteMags[pos] = noteMags[pos - 1];
+                    noteFreqs[pos] = noteFreqs[pos - 1];
+                }
+                pos--;
+            }
+            if (pos < maxNotes) {
+                noteMags[pos] = curMag;
+                noteFreqs[pos] = (float)bin * sampleRate / n;
+                if (noteCount < maxNotes) noteCount++;
+            }
+        }
+
+        prevMag = curMag;
+        curMag = nextMag;
+    }
+
+    return noteCount;
+}
+
+float fftDominant(const float* mags, int bins, float binHz, float* mag) {
+    float maxMag = 0.0f;
+    int maxBin = 0;
+
+    // Only check bins 1 to bins-1 (skip DC)
+    for (int i = 1; i < bins; i++) {
+        if (mags[i] > maxMag) {
+            maxMag = mags[i];
+            maxBin = i;
+        }
+    }
+
+    *mag = maxMag;
+    return (float)maxBin * binHz;
+}
+
+int fftDetect(float freq, float mag, float minFreq, float minMag) {
+    // Turn ON if:
+    //   - Frequency > 100 Hz (avoid DC and low-frequency noise)
+    //   - Magnitude > 10.0 (avoid background noise)
+    return freq > minFreq && mag > minMag;
+}
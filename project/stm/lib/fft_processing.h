@@ -0,0 +1,58 @@
+// fft_processing.h
+// Analyzer DSP chain: ADC block -> FFT -> notes -> detection
+//
+// No register access in here, so the same file builds for the STM32 and
+// natively on a PC (host/ replays WAV files through it).
+
+#ifndef FFT_PROCESSING_H
+#define FFT_PROCESSING_H
+
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Definitions
+///////////////////////////////////////////////////////////////////////////////
+
+#define FFT_SIZE        256     // FFT window size (must be power of 2)
+#define SAMPLE_RATE     8000    // Sampling frequency in Hz
+
+// The transform behind fft_compute(), for reports that compare builds
+#define FFT_BACKEND     "radix-2 f32"
+
+// Detection Thresholds
+#define FREQ_THRESHOLD  100.0f  // Minimum frequency to trigger LED (Hz)
+#define MAG_THRESHOLD   10.0f   // Minimum magnitude to avoid noise
+
+// Complex number for FFT computation
+typedef struct {
+    float real;     // Real component
+    float imag;     // Imaginary component
+} Complex;
+
+///////////////////////////////////////////////////////////////////////////////
+// Function prototypes
+///////////////////////////////////////////////////////////////////////////////
+
+/* 12 bit ADC codes -> -1.0..+1.0 (mid-scale 2048 = 0), imaginary part 0 */
+void fftNormalize(const uint16_t* adc, Complex* out, int n);
+
+/* In-place radix-2 FFT, n must be a power of 2 */
+void fft_compute(Complex* data, int n);
+
+/* Magnitude of bins 0..n/2-1 into mags and the loudest local maxima above
+ * magThreshold and above minFreq into noteFreqs / noteMags, loudest first.
+ * Maxima at or below minFreq (DC / rumble) are never candidates, so they do
+ * not take a slot. Returns the number of notes found (at most maxNotes). */
+int fftFindNotes(const Complex* spectrum, int n, float sampleRate, float magThreshold,
+                 float minFreq, float* mags, float* noteFreqs, float* noteMags,
+                 int maxNotes);
+
+/* Dominant bin of mags (bins 1..bins-1, DC skipped): returns its frequency,
+ * its magnitude goes to *mag */
+float fftDominant(const float* mags, int bins, float binHz, float* mag);
+
+/* Detection decision for the LED: the dominant bin is above minFreq and
+ * minMag (notes are for the coil, the LED follows the single loudest bin) */
+int fftDetect(float freq, float mag, float minFreq, float minMag);
+
+#endif
@@ -0,0 +1,207 @@
+// fpga_link.c
+// Framed SPI link to the FPGA LED display
+
+#include "fpga_link.h"
+#include "STM32L432KC_SPI.h"
+#include "placement.h"
+#include <math.h>
+#include <string.h>
+
+// Upper edge of every band in Hz. Same split the square wave encoding used,
+// ~167 Hz per LED, with the last band running up to Nyquist.
+static const float bandEdges[FPGA_NUM_BANDS] = {
+    170.0f, 330.0f, 500.0f, 670.0f, 830.0f, 1000.0f,
+    1170.0f, 1340.0f, 1500.0f, 1670.0f, 1840.0f, 4000.0f
+};
+
+// DMA reads straight out of these, so a frame is built in the buffer that is
+// not on the wire
+DMA_BUFFER static uint8_t frames[2][FPGA_FRAME_MAX];
+static int frameIndex = 0;
+static uint8_t seq = 0;
+static uint32_t sent = 0;
+static uint32_t dropped = 0;
+
+// SPI1 DMA channel 3 is IRQ 13
+#define NVIC_ISER0 (*(volatile uint32_t *) 0xE000E100UL)
+
+void initFPGALink(void) {
+    initSPI(FPGA_SPI_BR, 0, 0);
+    NVIC_ISER0 |= (1 << 13);
+}
+
+// dB above the floor, scaled to 0-255
+static uint8_t levelFromMag(float peak, float floor) {
+    float level = 0.0f;
+    if (peak > floor) {
+        level = 20.0f * log10f(peak / floor) * (255.0f / FPGA_LEVEL_DB_RANGE);
+    }
+    return level >= 255.0f ? 255 : (uint8_t)level;
+}
+
+void fpgaBandLevels(const float* mags, int bins, float binHz, float floor,
+                    uint8_t* levels) {
+    float peak[FPGA_NUM_BANDS] = {0};
+
+    // Peak magnitude per band, DC bin skipped
+    int band = 0;
+    for (int i = 1; i < bins; i++) {
+        float f = i * binHz;
+        while (band < FPGA_NUM_BANDS - 1 && f > bandEdges[band]) band++;
+        if (mags[i] > peak[band]) peak[band] = mags[i];
+    }
+
+    for (int b = 0; b < FPGA_NUM_BANDS; b++) {
+        levels[b] = levelFromMag(peak[b], floor);
+    }
+}
+
+void fpgaBarLevels(const float* mags, int bins, float floor, uint8_t* levels) {
+    float peak[FPGA_NUM_BARS] = {0};
+
+    for (int i = 1; i < bins; i++) {
+        int bar = (i - 1) * FPGA_NUM_BARS / bins;
+        if (mags[i] > peak[bar]) peak[bar] = mags[i];
+    }
+
+    for (int b = 0; b < FPGA_NUM_BARS; b++) {
+        levels[b] = levelFromMag(peak[b], floor);
+    }
+}
+
+// Free frame buffer with the header filled in, NULL if the link is busy
+static uint8_t* beginFrame(uint8_t type) {
+    if (spiDMABusy()) {
+        dropped++;
+        return NULL;
+    }
+
+    uint8_t* frame = frames[frameIndex];
+    frameIndex ^= 1;
+
+    frame[0] = type;
+    frame[1] = seq++;
+    return frame;
+}
+
+static void endFrame(uint8_t* frame, int len) {
+    spiSendDMA(frame, 2 + len);
+    sent++;
+}
+
+static int sendFrame(uint8_t type, const uint8_t* payload, int len) {
+    uint8_t* frame = beginFrame(type);
+    if (frame == NULL) return -1;
+
+    memcpy(&frame[2], payload, len);
+    endFrame(frame, len);
+    return 0;
+}
+
+int fpgaSendLevels(const uint8_t* levels) {
+    return sendFrame(FPGA_FRAME_LEVELS, levels, FPGA_NUM_BANDS);
+}
+
+int fpgaSendBars(const uint8_t* levels) {
+    return sendFrame(FPGA_FRAME_BARS, levels, FPGA_NUM_BARS);
+}
+
+int fpgaSendSamples(const uint16_t* adc) {
+    uint8_t* frame = beginFrame(FPGA_FRAME_SAMPLES);
+    if (frame == NULL) return -1;
+
+    // Signed, centred on mid-scale, big-endian
+    for (int n = 0; n < FPGA_SAMPLES_PER_FRAME; n++) {
+        int16_t x = (int16_t)adc[n] - 2048;
+        frame[2 + 2*n] = (uint8_t)((uint16_t)x >> 8);
+        frame[3 + 2*n] = (uint8_t)x;
+    }
+
+    endFrame(frame, 2 * FPGA_SAMPLES_PER_FRAME);
+    return 0;
+}
+
+int fpgaSendVoices(const float* freqs, int count, float pulseUs, int maxDutyPermille) {
+    uint8_t payload[6 * FPGA_NUM_VOICES];
+
+    for (int v = 0; v < FPGA_NUM_VOICES; v++) {
+        uint32_t word = 0;
+        uint32_t width = 0;
+        if (v < count && freqs[v] > 0.0f) {
+            // DDS word: f * 2^32 / 48 MHz
+            word = (uint32_t)((double)freqs[v] * 4294967296.0 / FPGA_CLK_HZ + 0.5);
+
+            float us = pulseUs;
+            float dutyUs = 1e6f / freqs[v] * maxDutyPermille / 1000.0f;
+            if (dutyUs < us) us = dutyUs;
+            width = (uint32_t)(us * (FPGA_CLK_HZ / 1000000UL));
+            if (width > 0xFFFF) width = 0xFFFF;
+            if (width == 0) width = 1;
+        }
+        payload[6*v + 0] = (word >> 24) & 0xFF;
+        payload[6*v + 1] = (word >> 16) & 0xFF;
+        payload[6*v + 2] = (word >> 8) & 0xFF;
+        payload[6*v + 3] = word & 0xFF;
+        payload[6*v + 4] = (width >> 8) & 0xFF;
+        payload[6*v + 5] = width & 0xFF;
+    }
+
+    while (spiDMABusy());
+    return sendFrame(FPGA_FRAME_VOICES, payload, sizeof(payload));
+}
+
+static int sendHistoryCommand(uint8_t cmd, uint16_t count) {
+    const uint8_t payload[3] = {cmd, (uint8_t)(count >> 8), (uint8_t)count};
+    return sendFrame(FPGA_FRAME_HISTORY, payload, sizeof(payload));
+}
+
+int fpgaHistoryDump(uint16_t count) {
+    return sendHistoryCommand(FPGA_HISTORY_DUMP, count);
+}
+
+int fpgaHistoryFreeze(int freeze) {
+    return sendHistoryCommand(freeze ? FPGA_HISTORY_FREEZE : FPGA_HISTORY_RESUME, 0);
+}
+
+void fpgaLogBucketEdges(float lowHz, float highHz, float* edgesHz) {
+    float ratio = powf(highHz / lowHz, 1.0f / (FPGA_NUM_BANDS - 2));
+    float f = lowHz;
+    for (int k = 0; k < FPGA_NUM_BANDS - 1; k++) {
+        edgesHz[k] = f;
+        f *= ratio;
+    }
+}
+
+int fpgaSendBucketTable(const float* edgesHz) {
+    uint8_t payload[3 * (FPGA_NUM_BANDS - 1)];
+
+    for (int k = 0; k < FPGA_NUM_BANDS - 1; k++) {
+        // Reciprocal mode compares the cycles across N edges, gated mode
+        // compares edges per 100 ms
+        uint32_t thr;
+        if (FPGA_COUNTER_RECIPROCAL) {
+            thr = (uint32_t)((float)FPGA_CLK_HZ * FPGA_COUNTER_N_EDGES / edgesHz[k] + 0.5f);
+        } else {
+            thr = (uint32_t)(edgesHz[k] / 10.0f + 0.5f);
+        }
+        if (thr > 0xFFFFFF) thr = 0xFFFFFF;
+
+        payload[3*k + 0] = (thr >> 16) & 0xFF;
+        payload[3*k + 1] = (thr >> 8) & 0xFF;
+        payload[3*k + 2] = thr & 0xFF;
+    }
+
+    return sendFrame(FPGA_FRAME_THRESHOLDS, payload, sizeof(payload));
+}
+
+int fpgaLinkBusy(void) {
+    return spiDMABusy();
+}
+
+uint32_t fpgaFramesSent(void) {
+    return sent;
+}
+
+uint32_t fpgaFramesDropped(void) {
+    return dropped;
+}
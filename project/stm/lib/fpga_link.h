@@ -0,0 +1,122 @@
+// fpga_link.h
+// Framed SPI link to the FPGA LED display
+
+#ifndef FPGA_LINK_H
+#define FPGA_LINK_H
+
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Definitions
+///////////////////////////////////////////////////////////////////////////////
+
+// Every frame is one CS low period, SPI mode 0, MSB first:
+//
+//   byte 0      frame type
+//   byte 1      sequence number (wraps, lets the FPGA side spot drops)
+//   byte 2..    payload
+//
+// The FPGA throws away any frame whose length does not match its type, so a
+// glitch on CS costs one frame and never shifts the next one.
+
+#define FPGA_FRAME_LEVELS       0x01    // 12 band levels, 0-255
+#define FPGA_FRAME_THRESHOLDS   0x02    // 11 bucket thresholds, 24 bit big-endian
+#define FPGA_FRAME_SAMPLES      0x03    // 256 signed 16 bit samples, big-endian
+#define FPGA_FRAME_VOICES       0x04    // per voice: 32 bit DDS word, 16 bit pulse width
+#define FPGA_FRAME_BARS         0x05    // WS2812 bar graph levels, 0-255
+#define FPGA_FRAME_HISTORY      0x06    // history command, 16 bit count
+
+#define FPGA_NUM_BANDS          12
+#define FPGA_SAMPLES_PER_FRAME  256     // one Goertzel block (goertzel_bank.sv N)
+#define FPGA_NUM_VOICES         4       // dds_voices.sv NUM_VOICES in top.sv
+#define FPGA_NUM_BARS           64      // STRIP_BANDS in top.sv
+#define FPGA_FRAME_MAX          (2 + 2 * FPGA_SAMPLES_PER_FRAME)  // largest frame, header included
+
+// History buffer commands (history_buffer.sv)
+#define FPGA_HISTORY_DUMP       0
+#define FPGA_HISTORY_FREEZE     1
+#define FPGA_HISTORY_RESUME     2
+
+// Square wave counter in top.sv (COUNTER_MODE / N_EDGES parameters), needed
+// to turn bucket edges in Hz into the units the FPGA compares against
+#define FPGA_CLK_HZ             48000000UL
+#define FPGA_COUNTER_RECIPROCAL 1       // 0 = gated 100 ms window
+#define FPGA_COUNTER_N_EDGES    4
+
+// SPI clock = 80 MHz / 2^(BR+1). The FPGA oversamples SCK with its 48 MHz
+// clock, so it must stay well under 12 MHz, and the Goertzel bank needs 127
+// clocks per sample (<= 5 MHz). BR = 3 gives 5 MHz, a levels frame (14
+// bytes) takes ~22 us, a samples frame (514 bytes) ~0.8 ms.
+#define FPGA_SPI_BR         3
+
+// Level mapping: magnitudes at the detection threshold are level 0, every
+// FPGA_LEVEL_DB_RANGE dB above that spreads over 0-255
+#define FPGA_LEVEL_DB_RANGE 40.0f
+
+///////////////////////////////////////////////////////////////////////////////
+// Function prototypes
+///////////////////////////////////////////////////////////////////////////////
+
+/* Sets up SPI1 (mode 0) and its DMA channel for the FPGA link */
+void initFPGALink(void);
+
+/* Reduces a magnitude spectrum to FPGA_NUM_BANDS levels (0-255).
+ *    -- mags: magnitude of bins 0..bins-1
+ *    -- binHz: width of one bin in Hz
+ *    -- floor: magnitude mapped to level 0
+ *    -- levels: FPGA_NUM_BANDS outputs */
+void fpgaBandLevels(const float* mags, int bins, float binHz, float floor,
+                    uint8_t* levels);
+
+/* Reduces a magnitude spectrum to FPGA_NUM_BARS levels for the WS2812 bar
+ * graph: equal width bands from bin 1 up, the same split the FPGA uses for
+ * Goertzel bins (2 bins per bar for 128 bins). Level mapping as above.
+ *    -- mags: magnitude of bins 0..bins-1
+ *    -- floor: magnitude mapped to level 0
+ *    -- levels: FPGA_NUM_BARS outputs */
+void fpgaBarLevels(const float* mags, int bins, float floor, uint8_t* levels);
+
+/* Queues a levels frame. Returns 0 if sent, -1 if the previous frame is
+ * still on the wire (this one is dropped, the next one supersedes it). */
+int fpgaSendLevels(const uint8_t* levels);
+
+/* Queues a bar graph frame (FPGA_NUM_BARS levels, ~110 us on the wire).
+ * Returns 0 if sent, -1 if the link was busy. */
+int fpgaSendBars(const uint8_t* levels);
+
+/* Sends a block of FPGA_SAMPLES_PER_FRAME raw 12 bit ADC samples for the
+ * on-FPGA Goertzel bank. Returns 0 if sent, -1 if the link was busy. */
+int fpgaSendSamples(const uint16_t* adc);
+
+/* Sets every FPGA DDS voice in one frame: voice i plays freqs[i] for
+ * i < count, the rest are off. The pulse is pulseUs, shortened so one voice
+ * never exceeds maxDutyPermille (the FPGA clamps on-time and duty as well).
+ * Waits for a frame already on the wire, notes must not be dropped.
+ * Returns 0 once the frame is queued. */
+int fpgaSendVoices(const float* freqs, int count, float pulseUs, int maxDutyPermille);
+
+/* Makes the FPGA stream its band frame history out of hist_tx (1 Mbaud,
+ * read on a host with sim/history_decode), the newest count frames, 0 = all
+ * (up to 2048, ~65 s). Returns 0 if sent, -1 if the link was busy. */
+int fpgaHistoryDump(uint16_t count);
+
+/* Stops (1) or restarts (0) history recording, e.g. freeze on a fault and
+ * dump later. Returns 0 if sent, -1 if the link was busy. */
+int fpgaHistoryFreeze(int freeze);
+
+/* Fills edgesHz[FPGA_NUM_BANDS - 1] with log spaced bucket edges from
+ * lowHz to highHz (100 Hz to 2 kHz: ~5.2 semitones each) */
+void fpgaLogBucketEdges(float lowHz, float highHz, float* edgesHz);
+
+/* Loads the FPGA square wave bucket table. edgesHz must be ascending.
+ * Returns 0 if sent, -1 if the link was busy (send it again). */
+int fpgaSendBucketTable(const float* edgesHz);
+
+/* 1 while a frame is on the wire */
+int fpgaLinkBusy(void);
+
+/* Frames handed to DMA / frames dropped because the link was busy */
+uint32_t fpgaFramesSent(void);
+uint32_t fpgaFramesDropped(void);
+
+#endif
@@ -0,0 +1,196 @@
+// interrupter.c
+// Polyphonic Tesla coil interrupter built from hardware timers
+
+#include "interrupter.h"
+#include "STM32L432KC_RCC.h"
+#include "STM32L432KC_GPIO.h"
+#include "STM32L432KC_DWT.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Voice table
+///////////////////////////////////////////////////////////////////////////////
+
+static Voice voices[INTERRUPTER_MAX_VOICES] = {
+    { TIM2,  1, 5, 1,  0, 0xFFFFFFFFUL, 0 },
+    { TIM1,  1, 8, 1,  1, 0x10000UL,    0 },
+    { TIM15, 2, 3, 14, 1, 0x10000UL,    0 },
+#if INTERRUPTER_USE_TIM16
+    { TIM16, 1, 6, 14, 1, 0x10000UL,    0 },
+#endif
+};
+
+static InterrupterStats stats;
+
+// A detected note within half a semitone of a playing voice is the same note
+// (2^(1/24) = 1.0293)
+#define SAME_NOTE_LOW   0.9715f
+#define SAME_NOTE_HIGH  1.0293f
+
+///////////////////////////////////////////////////////////////////////////////
+// Helpers
+///////////////////////////////////////////////////////////////////////////////
+
+static void setCompare(Voice* v, uint32_t value) {
+    if (v->channel == 1) v->tim->CCR1 = value;
+    else                 v->tim->CCR2 = value;
+}
+
+static void voiceTimerInit(Voice* v) {
+    v->tim->PSC = 0;
+    v->tim->ARR = TIM_KERNEL_CLK_HZ / 1000 - 1;  // idle at 1 kHz, output low
+    setCompare(v, 0);
+
+    // PWM mode 1 + compare preload on the selected channel
+    if (v->channel == 1) {
+        v->tim->CCMR1 &= ~(0x7 << 4);
+        v->tim->CCMR1 |= (0b110 << 4) | (1 << 3);   // OC1M, OC1PE
+        v->tim->CCER |= (1 << 0);                   // CC1E
+    } else {
+        v->tim->CCMR1 &= ~(0x7 << 12);
+        v->tim->CCMR1 |= (0b110 << 12) | (1 << 11); // OC2M, OC2PE
+        v->tim->CCER |= (1 << 4);                   // CC2E
+    }
+
+    // main output enable on the timers with a break/dead-time block
+    if (v->advanced) {
+        v->tim->BDTR |= (1 << 15);  // MOE
+    }
+
+    v->tim->CR1 |= (1 << 7);    // ARPE
+    v->tim->EGR |= (1 << 0);    // UG, load preloads
+    v->tim->CR1 |= (1 << 0);    // CEN
+
+    gpioAltFunction(v->pin, v->af);
+    v->freq = 0;
+}
+
+static void voiceSetFreq(Voice* v, float freqHz) {
+    // Smallest prescaler that fits the period into the counter, so every
+    // voice gets the finest pitch step it can.
+    float ticksF = (float)TIM_KERNEL_CLK_HZ / freqHz;
+    uint32_t psc = (uint32_t)(ticksF / (float)v->maxTicks);
+    uint32_t tickHz = TIM_KERNEL_CLK_HZ / (psc + 1);
+    uint32_t ticks = (uint32_t)((float)tickHz / freqHz + 0.5f);
+    if (ticks > v->maxTicks) ticks = v->maxTicks;
+    if (ticks < 2) ticks = 2;
+
+    // fixed width pulse, clamped by the on-time and duty limits
+    uint32_t pulse = pulseTicks(tickHz, ticks);
+
+    // preloaded, lands on the next period boundary (see updateTIM16FREQ)
+    v->tim->CR1 |= (1 << 1);    // UDIS
+    v->tim->PSC = psc;
+    v->tim->ARR = ticks - 1;
+    setCompare(v, pulse);
+    v->tim->CR1 &= ~(1 << 1);
+
+    v->freq = freqHz;
+}
+
+static void voiceRelease(Voice* v) {
+    // counter keeps running, the compare just never goes high again
+    setCompare(v, 0);
+    v->freq = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Function definitions
+///////////////////////////////////////////////////////////////////////////////
+
+void initInterrupter(void) {
+    RCC->AHB2ENR |= (1 << 0);       // GPIOA
+    RCC->APB1ENR1 |= (1 << 0);      // TIM2
+    RCC->APB2ENR |= (1 << 11);      // TIM1
+    RCC->APB2ENR |= (1 << 16);      // TIM15
+#if INTERRUPTER_USE_TIM16
+    RCC->APB2ENR |= (1 << 17);      // TIM16
+#endif
+
+    initDWT();
+
+    // Interrupter pulses are fixed width: the max on-time is the pulse width
+    setPulseLimits(INTERRUPTER_PULSE_US, INTERRUPTER_MAX_DUTY_PERMILLE);
+
+    for (int i = 0; i < INTERRUPTER_MAX_VOICES; i++) {
+        voiceTimerInit(&voices[i]);
+    }
+
+    stats.updates = 0;
+    stats.lastCycles = 0;
+    stats.maxCycles = 0;
+}
+
+void interrupterSetNotes(const float* freqs, int count) {
+    // Voice allocation. freqs is the detector's note list, loudest first.
+    //   1. a voice whose note is still in the list keeps playing (retuned
+    //      through the preload if it drifted), so its phase is never reset
+    //   2. voices whose note went away are released
+    //   3. new notes go to free voices, loudest first, extras are dropped
+    uint32_t start = DWT_CYCLES();
+
+    uint8_t taken[INTERRUPTER_MAX_VOICES * 4] = {0};
+    if (count > INTERRUPTER_MAX_VOICES * 4) count = INTERRUPTER_MAX_VOICES * 4;
+
+    for (int v = 0; v < INTERRUPTER_MAX_VOICES; v++) {
+        if (voices[v].freq == 0) continue;
+
+        int match = -1;
+        for (int n = 0; n < count; n++) {
+            if (taken[n] || freqs[n] <= 0) continue;
+            float ratio = freqs[n] / voices[v].freq;
+            if (ratio > SAME_NOTE_LOW && ratio < SAME_NOTE_HIGH) {
+                match = n;
+                break;
+            }
+        }
+
+        if (match >= 0) {
+            taken[match] = 1;
+            if (freqs[match] != voices[v].freq) {
+                voiceSetFreq(&voices[v], freqs[match]);
+            }
+        } else {
+            voiceRelease(&voices[v]);
+        }
+    }
+
+    for (int n = 0; n < count; n++) {
+        if (taken[n] || freqs[n] <= 0) continue;
+        for (int v = 0; v < INTERRUPTER_MAX_VOICES; v++) {
+            if (voices[v].freq == 0) {
+                voiceSetFreq(&voices[v], freqs[n]);
+                taken[n] = 1;
+                break;
+            }
+        }
+    }
+
+    stats.lastCycles = DWT_CYCLES() - start;
+    if (stats.lastCycles > stats.maxCycles) stats.maxCycles = stats.lastCycles;
+    stats.updates++;
+}
+
+void interrupterAllOff(void) {
+    for (int v = 0; v < INTERRUPTER_MAX_VOICES; v++) {
+        voiceRelease(&voices[v]);
+    }
+}
+
+void interrupterSetLimits(uint32_t maxOnTimeUs, uint32_t maxDutyPermille) {
+    setPulseLimits(maxOnTimeUs, maxDutyPermille);
+
+    // re-apply to the playing voices so the new limit holds from the next
+    // period on
+    for (int v = 0; v < INTERRUPTER_MAX_VOICES; v++) {
+        if (voices[v].freq != 0) voiceSetFreq(&voices[v], voices[v].freq);
+    }
+}
+
+const Voice* interrupterVoice(int index) {
+    if (index < 0 || index >= INTERRUPTER_MAX_VOICES) return 0;
+    return &voices[index];
+}
+
+const InterrupterStats* interrupterStats(void) {
+    return &stats;
+}
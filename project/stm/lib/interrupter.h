@@ -0,0 +1,71 @@
+// interrupter.h
+// Polyphonic Tesla coil interrupter built from hardware timers
+
+#ifndef INTERRUPTER_H
+#define INTERRUPTER_H
+
+#include <stdint.h>
+#include "STM32L432KC_TIM.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Definitions
+///////////////////////////////////////////////////////////////////////////////
+
+// Every voice is one timer in PWM mode 1 making a short fixed width pulse at
+// the note frequency. The pulse trains come out on separate pins and are
+// OR'ed together in front of the gate driver / fiber transmitter (diode OR or
+// a 74HC32), so every pulse edge comes straight from a timer compare and no
+// ISR sits in the pulse path.
+//
+//   voice 0: TIM2  CH1  PA5  AF1   (32 bit, PSC = 0)
+//   voice 1: TIM1  CH1  PA8  AF1
+//   voice 2: TIM15 CH2  PA3  AF14
+//   voice 3: TIM16 CH1  PA6  AF14  (only if INTERRUPTER_USE_TIM16, PA6 is the
+//                                   ADC input in src/main.c)
+
+#ifndef INTERRUPTER_USE_TIM16
+  #define INTERRUPTER_USE_TIM16 0
+#endif
+
+#define INTERRUPTER_MAX_VOICES  (3 + INTERRUPTER_USE_TIM16)
+
+// Width of every interrupter pulse (the max on-time)
+#ifndef INTERRUPTER_PULSE_US
+  #define INTERRUPTER_PULSE_US  50
+#endif
+
+// Cap on the fraction of time the coil is on per voice, 50 = 5%. High notes
+// hit this before the on-time limit: at 2 kHz a 50 us pulse would be 10%.
+#ifndef INTERRUPTER_MAX_DUTY_PERMILLE
+  #define INTERRUPTER_MAX_DUTY_PERMILLE  50
+#endif
+
+typedef struct {
+    TIM_TypeDef* tim;
+    uint8_t channel;        // compare channel, 1 or 2
+    uint8_t pin;            // GPIOA pin
+    uint8_t af;             // alternate function number for the pin
+    uint8_t advanced;       // TIM1/15/16 need BDTR.MOE for the output
+    uint32_t maxTicks;      // counter range, 0x10000 or 0xFFFFFFFF
+    float freq;             // note currently playing, 0 = idle
+} Voice;
+
+// Cycle counts of interrupterSetNotes(), measured with the DWT counter
+typedef struct {
+    uint32_t updates;
+    uint32_t lastCycles;
+    uint32_t maxCycles;
+} InterrupterStats;
+
+///////////////////////////////////////////////////////////////////////////////
+// Function prototypes
+///////////////////////////////////////////////////////////////////////////////
+
+void initInterrupter(void);
+void interrupterSetNotes(const float* freqs, int count);
+void interrupterAllOff(void);
+void interrupterSetLimits(uint32_t maxOnTimeUs, uint32_t maxDutyPermille);
+const Voice* interrupterVoice(int index);
+const InterrupterStats* interrupterStats(void);
+
+#endif
@@ -0,0 +1,157 @@
+// latency.c
+// Audio onset to output latency, timed with the DWT cycle counter
+
+#include "latency.h"
+#include "STM32L432KC_DWT.h"
+#include <stdio.h>
+
+static LatencyOutput outputs[LATENCY_MAX_OUTPUTS];
+static int outputCount;
+
+static uint32_t samplePeriodCycles;
+static uint16_t onsetThreshold;
+
+// Written by the DMA interrupt only. onsetCycles is stored before onsets is
+// bumped, and latencyOutput() re-reads the pair until onsets is unchanged
+// around it, so it never pairs a count with another onset's time.
+static volatile uint32_t onsets;
+static volatile uint32_t onsetCycles;
+static uint32_t quietBlocks;
+
+///////////////////////////////////////////////////////////////////////////////
+// Function definitions
+///////////////////////////////////////////////////////////////////////////////
+
+void initLatency(const char* const* names, int count, uint32_t sampleRateHz,
+                 uint16_t threshold) {
+    initDWT();
+
+    if (count > LATENCY_MAX_OUTPUTS) count = LATENCY_MAX_OUTPUTS;
+    outputCount = count;
+    for (int i = 0; i < LATENCY_MAX_OUTPUTS; i++) {
+        outputs[i].name = (i < count) ? names[i] : 0;
+    }
+
+    // e.g. 8 kHz = 10,000 cycles per sample at 80 MHz
+    samplePeriodCycles = DWT_CPU_HZ / sampleRateHz;
+    onsetThreshold = threshold;
+    latencyReset();
+}
+
+void latencyReset(void) {
+    for (int i = 0; i < LATENCY_MAX_OUTPUTS; i++) {
+        LatencyOutput* o = &outputs[i];
+        o->handledOnset = onsets;
+        o->active = 0;
+        o->count = 0;
+        o->missed = 0;
+        o->minCycles = 0xFFFFFFFF;
+        o->maxCycles = 0;
+        o->totalCycles = 0;
+        for (int b = 0; b < LATENCY_HIST_BUCKETS; b++) o->hist[b] = 0;
+    }
+}
+
+void latencyScan(const uint16_t* block, int n) {
+    uint32_t now = DWT_CYCLES();
+
+    int first = -1;
+    for (int i = 0; i < n; i++) {
+        int x = (int)block[i] - 2048;
+        if (x > onsetThreshold || x < -(int)onsetThreshold) {
+            first = i;
+            break;
+        }
+    }
+
+    if (first < 0) {
+        if (quietBlocks < LATENCY_QUIET_BLOCKS) quietBlocks++;
+        return;
+    }
+    if (quietBlocks < LATENCY_QUIET_BLOCKS) {
+        quietBlocks = 0;            // still the same sound
+        return;
+    }
+    quietBlocks = 0;
+
+    // Outputs that never reacted to the last onset
+    for (int i = 0; i < outputCount; i++) {
+        if (outputs[i].handledOnset != onsets) {
+            outputs[i].missed++;
+            outputs[i].handledOnset = onsets;
+        }
+    }
+
+    // The last sample of the block was converted just before this interrupt
+    onsetCycles = now - (uint32_t)(n - 1 - first) * samplePeriodCycles;
+    onsets = onsets + 1;
+}
+
+void latencyOutput(int output, int active) {
+    LatencyOutput* o = &outputs[output];
+    uint32_t n, at;
+    do {
+        n = onsets;
+        at = onsetCycles;
+    } while (onsets != n);
+
+    // After the snapshot, so an onset taken during it is not in the future
+    uint32_t now = DWT_CYCLES();
+
+    // Only an off -> on change counts, an output still on from the last
+    // sound has not reacted to this one
+    int rising = active && !o->active;
+    o->active = (uint8_t)active;
+    if (!rising || o->handledOnset == n) return;
+    o->handledOnset = n;
+
+    uint32_t cycles = now - at;
+    o->count++;
+    o->totalCycles += cycles;
+    if (cycles < o->minCycles) o->minCycles = cycles;
+    if (cycles > o->maxCycles) o->maxCycles = cycles;
+
+    uint32_t bucket = cyclesToMicros(cycles) / LATENCY_BUCKET_US;
+    if (bucket > LATENCY_HIST_BUCKETS - 1) bucket = LATENCY_HIST_BUCKETS - 1;
+    o->hist[bucket]++;
+}
+
+uint32_t latencyOnsets(void) {
+    return onsets;
+}
+
+const LatencyOutput* latencyStats(int output) {
+    return &outputs[output];
+}
+
+static void printMs(uint32_t cycles) {
+    uint32_t us = cyclesToMicros(cycles);
+    printf(" %5lu.%lu", (unsigned long)(us / 1000), (unsigned long)(us % 1000 / 100));
+}
+
+void latencyPrint(void) {
+    printf("LAT onsets %lu  threshold %u LSB\n", (unsigned long)onsets, (unsigned)onsetThreshold);
+    printf("LAT output   count missed  min ms mean ms  max ms  histogram (<ms: count)\n");
+    for (int i = 0; i < outputCount; i++) {
+        const LatencyOutput* o = &outputs[i];
+        printf("LAT %-8s %6lu %6lu", o->name, (unsigned long)o->count, (unsigned long)o->missed);
+        if (o->count == 0) {
+            printf("\n");
+            continue;
+        }
+        printMs(o->minCycles);
+        printMs((uint32_t)(o->totalCycles / o->count));
+        printMs(o->maxCycles);
+        printf(" ");
+
+        for (int b = 0; b < LATENCY_HIST_BUCKETS; b++) {
+            if (o->hist[b] == 0) continue;
+            if (b == LATENCY_HIST_BUCKETS - 1) {
+                printf(" >%d:%lu", b * LATENCY_BUCKET_US / 1000, (unsigned long)o->hist[b]);
+            } else {
+                printf(" <%d:%lu", (b + 1) * LATENCY_BUCKET_US / 1000, (unsigned long)o->hist[b]);
+            }
+        }
+        printf("\n");
+    }
+}
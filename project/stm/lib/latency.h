@@ -0,0 +1,62 @@
+// latency.h
+// Audio onset to output latency, timed with the DWT cycle counter
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Definitions
+///////////////////////////////////////////////////////////////////////////////
+
+// The DMA interrupt hands every finished half buffer to latencyScan(). After
+// LATENCY_QUIET_BLOCKS blocks that stay within the threshold of mid scale,
+// the first sample outside it is an onset. Its time is back-dated from the
+// interrupt by one sample period per sample that came after it. Each output
+// (LED, FPGA frame, ...) then records onset -> its first off -> on change
+// reported through latencyOutput(). An output that has not changed by the
+// next onset counts as missed.
+#define LATENCY_MAX_OUTPUTS     4
+#define LATENCY_QUIET_BLOCKS    4
+
+// Linear histogram: bucket b holds latencies below (b + 1) * LATENCY_BUCKET_US,
+// the last one everything above
+#define LATENCY_HIST_BUCKETS    16
+#define LATENCY_BUCKET_US       4000
+
+typedef struct {
+    const char* name;
+    uint32_t handledOnset;          // onset number this output last recorded
+    uint8_t active;                 // state at the last latencyOutput()
+    uint32_t count;
+    uint32_t missed;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+    uint32_t hist[LATENCY_HIST_BUCKETS];
+} LatencyOutput;
+
+///////////////////////////////////////////////////////////////////////////////
+// Function prototypes
+///////////////////////////////////////////////////////////////////////////////
+
+// Outputs are 0..count-1. threshold is in ADC codes from mid scale (2048).
+// Starts the DWT.
+void initLatency(const char* const* names, int count, uint32_t sampleRateHz,
+                 uint16_t threshold);
+void latencyReset(void);
+
+// From the DMA interrupt, with the half of the buffer that just filled
+void latencyScan(const uint16_t* block, int n);
+
+// From the main loop, right after the output is updated
+void latencyOutput(int output, int active);
+
+uint32_t latencyOnsets(void);
+const LatencyOutput* latencyStats(int output);
+
+// count / missed / min / mean / max in ms, then the non-empty buckets
+void latencyPrint(void);
+
+#endif
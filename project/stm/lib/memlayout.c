@@ -0,0 +1,69 @@
+// memlayout.c
+// Code and data sizes from the linker script, startup copies for GCC
+
+#include "memlayout.h"
+#include "placement.h"
+#include <stdio.h>
+#include <string.h>
+
+// Both linker scripts define these: blocks in STM32L4xx_Flash.icf (the
+// SEGGER linker names their ends __<block>_start__ / __<block>_end__),
+// plain symbols in STM32L432KCUx_FLASH.ld
+extern char __app_code_start__[], __app_code_end__[];
+extern char __app_const_start__[], __app_const_end__[];
+extern char __app_data_start__[], __app_data_end__[];
+extern char __app_bss_start__[], __app_bss_end__[];
+extern char __ramfunc_start__[], __ramfunc_end__[];
+extern char __dma_ram_start__[], __dma_ram_end__[];
+extern char __heap_start__[], __heap_end__[];
+extern char __stack_start__[], __stack_end__[];
+
+// Only in the GCC script: where the .ramfunc image sits in flash. Undefined
+// (0) with the SEGGER linker.
+extern char __ramfunc_load_start__[] __attribute__((weak));
+
+///////////////////////////////////////////////////////////////////////////////
+// Function definitions
+///////////////////////////////////////////////////////////////////////////////
+
+void memlayoutInit(void) {
+    if (__ramfunc_load_start__ == 0) return;
+
+    memcpy(__ramfunc_start__, __ramfunc_load_start__,
+           (size_t)(__ramfunc_end__ - __ramfunc_start__));
+    memset(__dma_ram_start__, 0, (size_t)(__dma_ram_end__ - __dma_ram_start__));
+}
+
+static uint32_t printRegion(const char* name, const char* start, const char* end,
+                            const char* where) {
+    uint32_t bytes = (uint32_t)(end - start);
+    printf("MEM %-8s 0x%08lx 0x%08lx %7lu  %s\n", name, (unsigned long)(uintptr_t)start,
+           (unsigned long)(uintptr_t)end, (unsigned long)bytes, where);
+    return bytes;
+}
+
+static void printUse(const char* name, uint32_t used, uint32_t total) {
+    printf("MEM %-8s %7lu of %7lu bytes (%lu%%)\n", name, (unsigned long)used,
+           (unsigned long)total, (unsigned long)(100UL * used / total));
+}
+
+void memlayoutPrint(void) {
+    printf("MEM region   start      end          bytes  memory\n");
+    uint32_t code = printRegion("code", __app_code_start__, __app_code_end__, "flash");
+    uint32_t rodata = printRegion("const", __app_const_start__, __app_const_end__, "flash");
+    uint32_t data = printRegion("data", __app_data_start__, __app_data_end__,
+                                "SRAM1, image in flash");
+    uint32_t bss = printRegion("bss", __app_bss_start__, __app_bss_end__, "SRAM1");
+    uint32_t ramfunc = printRegion("ramfunc", __ramfunc_start__, __ramfunc_end__,
+                                   "SRAM2 I-Code, image in flash");
+    uint32_t dma = printRegion("dma", __dma_ram_start__, __dma_ram_end__, "SRAM2 system bus");
+    uint32_t heap = printRegion("heap", __heap_start__, __heap_end__, "SRAM1");
+    uint32_t stack = printRegion("stack", __stack_start__, __stack_end__, "SRAM1");
+
+    // Load images are counted at their run size, the SEGGER linker may pack
+    // the .data one smaller
+    printUse("flash", code + rodata + data + ramfunc, MEMLAYOUT_FLASH_BYTES);
+    printUse("SRAM1", data + bss + heap + stack, MEMLAYOUT_SRAM1_BYTES);
+    printUse("SRAM2", ramfunc + dma, MEMLAYOUT_SRAM2_BYTES);
+    printf("MEM RAMFUNC_ENABLE %d\n", RAMFUNC_ENABLE);
+}
@@ -0,0 +1,32 @@
+// memlayout.h
+// Code and data sizes from the linker script, startup copies for GCC
+
+#ifndef MEMLAYOUT_H
+#define MEMLAYOUT_H
+
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Definitions
+///////////////////////////////////////////////////////////////////////////////
+
+// Sizes of the STM32L432KC memories, for the used / free figures
+#define MEMLAYOUT_FLASH_BYTES   (256 * 1024)
+#define MEMLAYOUT_SRAM1_BYTES   (48 * 1024)
+#define MEMLAYOUT_SRAM2_BYTES   (16 * 1024)
+
+///////////////////////////////////////////////////////////////////////////////
+// Function prototypes
+///////////////////////////////////////////////////////////////////////////////
+
+/* First thing in main(). With STM32L432KCUx_FLASH.ld (GCC) it copies .ramfunc
+ * to SRAM2 and zeroes the DMA buffers, which ST's startup does not know
+ * about. With the SEGGER linker its init table has already done both, and
+ * this returns at once. */
+void memlayoutInit(void);
+
+/* Start, end and size of code, constants, data, bss, .ramfunc, the DMA
+ * buffers, heap and stack, then the flash / SRAM1 / SRAM2 totals */
+void memlayoutPrint(void);
+
+#endif
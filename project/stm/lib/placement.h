@@ -0,0 +1,39 @@
+// placement.h
+// Section attributes for the code and buffers the linker scripts place
+// (STM32L4xx_Flash.icf for SEGGER, STM32L432KCUx_FLASH.ld for GCC)
+
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+///////////////////////////////////////////////////////////////////////////////
+// Definitions
+///////////////////////////////////////////////////////////////////////////////
+
+// RAMFUNC: hot DSP code runs from the lower 8 KB of SRAM2, at 0x10000000
+// on the I-Code bus. The startup copies it there from flash. The fetch has
+// no flash wait states and does not compete with the data loads to SRAM1.
+// RAMFUNC_ENABLE 0 leaves it in flash behind the ART, for the before/after
+// cycle counts (PROF zones, host/golden -t). Calls between flash and
+// 0x10000000 are out of BL range, so both linkers put veneers in.
+#ifndef RAMFUNC_ENABLE
+  #define RAMFUNC_ENABLE 1
+#endif
+
+// DMA_BUFFER: buffers a DMA channel reads or writes go in the upper 8 KB of
+// SRAM2, through its system bus alias at 0x2000E000. The CPU's stack and
+// data stay in SRAM1. Zeroed at startup like .bss.
+//
+// The host builds (host/) link normally: the attributes are only for ARM.
+#if defined(__arm__) && RAMFUNC_ENABLE
+  #define RAMFUNC     __attribute__((section(".ramfunc"), noinline))
+#else
+  #define RAMFUNC
+#endif
+
+#if defined(__arm__)
+  #define DMA_BUFFER  __attribute__((section(".bss.dma"), aligned(4)))
+#else
+  #define DMA_BUFFER
+#endif
+
+#endif
@@ -0,0 +1,93 @@
+// profile.c
+// Cycle counting profile zones on the DWT cycle counter
+
+#include "profile.h"
+
+#if PROFILE_ENABLE
+
+#include <stdio.h>
+
+ProfileZone profileZones[PROFILE_MAX_ZONES];
+static int zoneCount;
+
+///////////////////////////////////////////////////////////////////////////////
+// Function definitions
+///////////////////////////////////////////////////////////////////////////////
+
+void profileInit(const char* const* names, int count) {
+    initDWT();
+
+    if (count > PROFILE_MAX_ZONES) count = PROFILE_MAX_ZONES;
+    zoneCount = count;
+    for (int i = 0; i < PROFILE_MAX_ZONES; i++) {
+        profileZones[i].name = (i < count) ? names[i] : 0;
+    }
+    profileReset();
+}
+
+void profileReset(void) {
+    for (int i = 0; i < PROFILE_MAX_ZONES; i++) {
+        ProfileZone* z = &profileZones[i];
+        z->running = 0;
+        z->count = 0;
+        z->minCycles = 0xFFFFFFFF;
+        z->maxCycles = 0;
+        z->totalCycles = 0;
+        for (int b = 0; b < PROFILE_HIST_BUCKETS; b++) z->hist[b] = 0;
+    }
+}
+
+void profileRecord(int zone, uint32_t cycles) {
+    ProfileZone* z = &profileZones[zone];
+
+    z->count++;
+    z->totalCycles += cycles;
+    if (cycles < z->minCycles) z->minCycles = cycles;
+    if (cycles > z->maxCycles) z->maxCycles = cycles;
+
+    // Bucket from the top set bit: 2^(FIRST_BIT + b - 1) <= cycles < 2^(FIRST_BIT + b)
+    int bucket = 0;
+    if (cycles >> PROFILE_HIST_FIRST_BIT) {
+        bucket = 32 - __builtin_clz(cycles) - PROFILE_HIST_FIRST_BIT;
+        if (bucket > PROFILE_HIST_BUCKETS - 1) bucket = PROFILE_HIST_BUCKETS - 1;
+    }
+    z->hist[bucket]++;
+}
+
+const ProfileZone* profileZone(int zone) {
+    return &profileZones[zone];
+}
+
+void profilePrint(void) {
+    printf("PROF zone          count   min us  mean us   max us  histogram (<us: count)\n");
+    for (int i = 0; i < zoneCount; i++) {
+        const ProfileZone* z = &profileZones[i];
+        if (z->count == 0) {
+            printf("PROF %-12s %7s\n", z->name, "-");
+            continue;
+        }
+        printf("PROF %-12s %7lu %8lu %8lu %8lu ",
+               z->name,
+               (unsigned long)z->count,
+               (unsigned long)cyclesToMicros(z->minCycles),
+               (unsigned long)cyclesToMicros((uint32_t)(z->totalCycles / z->count)),
+               (unsigned long)cyclesToMicros(z->maxCycles));
+
+        // Bucket b holds times below its upper edge 2^(FIRST_BIT + b) cycles
+        for (int b = 0; b < PROFILE_HIST_BUCKETS; b++) {
+            if (z->hist[b] == 0) continue;
+            if (b == PROFILE_HIST_BUCKETS - 1) {
+                printf(" >%lu:%lu",
+                       (unsigned long)cyclesToMicros(1UL << (PROFILE_HIST_FIRST_BIT + b - 1)),
+                       (unsigned long)z->hist[b]);
+            } else {
+                printf(" <%lu:%lu",
+                       (unsigned long)cyclesToMicros(1UL << (PROFILE_HIST_FIRST_BIT + b)),
+                       (unsigned long)z->hist[b]);
+            }
+        }
+        printf("\n");
+    }
+}
+
+#endif
@@ -0,0 +1,97 @@
+// profile.h
+// Cycle counting profile zones on the DWT cycle counter
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include "STM32L432KC_DWT.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Definitions
+///////////////////////////////////////////////////////////////////////////////
+
+// PROFILE_ENABLE 0 turns every PROFILE_* macro into nothing and drops the
+// counters, so the zones can stay in release builds. Default: on unless
+// NDEBUG (the Release configuration of FFT.emProject).
+#ifndef PROFILE_ENABLE
+  #ifdef NDEBUG
+    #define PROFILE_ENABLE 0
+  #else
+    #define PROFILE_ENABLE 1
+  #endif
+#endif
+
+#define PROFILE_MAX_ZONES   8
+
+// Histogram buckets are powers of two of cycles: bucket 0 is everything
+// below 2^PROFILE_HIST_FIRST_BIT (256 cycles = 3.2 us), the last one
+// everything from 2^(PROFILE_HIST_FIRST_BIT + PROFILE_HIST_BUCKETS - 2) up
+// (4M cycles = 52 ms, longer than a frame)
+#define PROFILE_HIST_BUCKETS    16
+#define PROFILE_HIST_FIRST_BIT  8
+
+// Time source, the host build can point this somewhere else
+#ifndef PROFILE_CYCLES
+  #define PROFILE_CYCLES() DWT_CYCLES()
+#endif
+
+typedef struct {
+    const char* name;
+    uint32_t start;                 // cycle count at PROFILE_BEGIN
+    uint8_t running;                // begun and not ended yet
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+    uint32_t hist[PROFILE_HIST_BUCKETS];
+} ProfileZone;
+
+///////////////////////////////////////////////////////////////////////////////
+// Function prototypes
+///////////////////////////////////////////////////////////////////////////////
+
+#if PROFILE_ENABLE
+
+extern ProfileZone profileZones[PROFILE_MAX_ZONES];
+
+// Zones are 0..count-1, names[i] is printed for zone i. Starts the DWT.
+void profileInit(const char* const* names, int count);
+void profileReset(void);
+void profileRecord(int zone, uint32_t cycles);
+const ProfileZone* profileZone(int zone);
+
+// count / min / mean / max in us, then the non-empty histogram buckets
+void profilePrint(void);
+
+static inline void profileBegin(int zone) {
+    profileZones[zone].start = PROFILE_CYCLES();
+    profileZones[zone].running = 1;
+}
+
+// An end without a begin (e.g. the first pass of a loop) is ignored
+static inline void profileEnd(int zone) {
+    uint32_t now = PROFILE_CYCLES();
+    if (profileZones[zone].running) {
+        profileZones[zone].running = 0;
+        profileRecord(zone, now - profileZones[zone].start);
+    }
+}
+
+#define PROFILE_INIT(names, count)  profileInit((names), (count))
+#define PROFILE_BEGIN(zone)         profileBegin(zone)
+#define PROFILE_END(zone)           profileEnd(zone)
+#define PROFILE_RESET()             profileReset()
+#define PROFILE_PRINT()             profilePrint()
+
+#else
+
+#define PROFILE_INIT(names, count)  ((void)0)
+#define PROFILE_BEGIN(zone)         ((void)0)
+#define PROFILE_END(zone)           ((void)0)
+#define PROFILE_RESET()             ((void)0)
+#define PROFILE_PRINT()             ((void)0)
+
+#endif
+
+#endif
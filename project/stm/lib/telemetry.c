@@ -0,0 +1,177 @@
+// telemetry.c
+// Binary spectrum frames for the USART2 stream to a host viewer
+
+#include "telemetry.h"
+
+// CRC-16/CCITT-FALSE a nibble at a time, 16 entries instead of 256
+static const uint16_t crcNibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Function definitions
+///////////////////////////////////////////////////////////////////////////////
+
+uint16_t telemetryCrc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc = (uint16_t)((crc << 4) ^ crcNibble[(crc >> 12) ^ (data[i] >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ crcNibble[(crc >> 12) ^ (data[i] & 0x0F)]);
+    }
+    return crc;
+}
+
+static uint8_t* put16(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint16_t get16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// value * scale rounded, clipped to 0..65535
+static uint16_t toFixed(float value, float scale) {
+    float v = value * scale + 0.5f;
+    if (!(v > 0.0f)) return 0;
+    if (v >= 65535.0f) return 65535;
+    return (uint16_t)v;
+}
+
+// Sync, type, length, seq, timestamp. Returns where the payload goes.
+static uint8_t* putHeader(uint8_t* out, uint8_t type, int payload, uint16_t seq,
+                          uint32_t timestamp) {
+    uint8_t* p = out;
+    *p++ = TELEMETRY_SYNC0;
+    *p++ = TELEMETRY_SYNC1;
+    *p++ = type;
+    p = put16(p, (uint32_t)payload);
+    p = put16(p, seq);
+    p = put16(p, timestamp);
+    p = put16(p, timestamp >> 16);
+    return p;
+}
+
+// CRC over everything after the sync bytes, returns the frame length
+static int putCrc(uint8_t* out, uint8_t* p) {
+    p = put16(p, telemetryCrc16(&out[2], (size_t)(p - &out[2])));
+    return (int)(p - out);
+}
+
+static int packSpectrum(uint8_t* out, uint8_t type, uint16_t seq, uint32_t timestamp,
+                        uint8_t flags, const float* peakFreqs, const float* peakMags,
+                        int peaks, const float* mags, int bins, const uint8_t* bands,
+                        int numBands) {
+    uint8_t* p = putHeader(out, type, 5 + 4 * peaks + 2 * bins + numBands, seq, timestamp);
+
+    *p++ = flags;
+    *p++ = (uint8_t)peaks;
+    p = put16(p, (uint32_t)bins);
+    *p++ = (uint8_t)numBands;
+    for (int i = 0; i < peaks; i++) {
+        p = put16(p, toFixed(peakFreqs[i], 16.0f));
+        p = put16(p, toFixed(peakMags[i], 256.0f));
+    }
+    for (int i = 0; i < bins; i++) {
+        p = put16(p, toFixed(mags[i], 256.0f));
+    }
+    for (int i = 0; i < numBands; i++) {
+        *p++ = bands[i];
+    }
+    return putCrc(out, p);
+}
+
+int telemetryPackSpectrum(uint8_t* out, uint16_t seq, uint32_t timestamp, uint8_t flags,
+                          const float* peakFreqs, const float* peakMags, int peaks,
+                          const float* mags, int bins, const uint8_t* bands, int numBands) {
+    return packSpectrum(out, TELEMETRY_SPECTRUM, seq, timestamp, flags, peakFreqs, peakMags,
+                        peaks, mags, bins, bands, numBands);
+}
+
+int telemetryPackResult(uint8_t* out, uint16_t seq, uint32_t cycles, uint8_t flags,
+                        const float* peakFreqs, const float* peakMags, int peaks,
+                        const float* mags, int bins) {
+    return packSpectrum(out, TELEMETRY_RESULT, seq, cycles, flags, peakFreqs, peakMags,
+                        peaks, mags, bins, NULL, 0);
+}
+
+int telemetryPackVector(uint8_t* out, uint16_t seq, const uint16_t* adc, int n) {
+    uint8_t* p = putHeader(out, TELEMETRY_VECTOR, 2 * n, seq, 0);
+    for (int i = 0; i < n; i++) {
+        p = put16(p, adc[i]);
+    }
+    return putCrc(out, p);
+}
+
+int telemetryVector(const TelemetryFrame* frame, uint16_t* adc, int max) {
+    if (frame->type != TELEMETRY_VECTOR) return -1;
+    int n = frame->length / 2;
+    if (n > max) n = max;
+    for (int i = 0; i < n; i++) {
+        adc[i] = get16(&frame->payload[2 * i]);
+    }
+    return n;
+}
+
+int telemetryFind(const uint8_t* buf, size_t len, TelemetryFrame* frame, size_t* used) {
+    size_t i = 0;
+    while (i + 1 < len && !(buf[i] == TELEMETRY_SYNC0 && buf[i + 1] == TELEMETRY_SYNC1)) i++;
+    *used = i;
+
+    if (i + TELEMETRY_HEADER_BYTES > len) return 0;
+    const uint8_t* h = &buf[i];
+    uint16_t length = get16(&h[3]);
+    if (length > TELEMETRY_MAX_PAYLOAD) {
+        *used = i + 2;              // not a real header
+        return -1;
+    }
+    size_t total = TELEMETRY_HEADER_BYTES + length + TELEMETRY_CRC_BYTES;
+    if (i + total > len) return 0;
+
+    uint16_t crc = get16(&h[TELEMETRY_HEADER_BYTES + length]);
+    if (telemetryCrc16(&h[2], TELEMETRY_HEADER_BYTES - 2 + length) != crc) {
+        *used = i + 2;
+        return -1;
+    }
+
+    frame->type = h[2];
+    frame->length = length;
+    frame->seq = get16(&h[5]);
+    frame->timestamp = get16(&h[7]) | ((uint32_t)get16(&h[9]) << 16);
+    frame->payload = &h[TELEMETRY_HEADER_BYTES];
+    *used = i + total;
+    return 1;
+}
+
+int telemetrySpectrum(const TelemetryFrame* frame, TelemetrySpectrum* out) {
+    const uint8_t* p = frame->payload;
+    if ((frame->type != TELEMETRY_SPECTRUM && frame->type != TELEMETRY_RESULT) ||
+        frame->length < 5) {
+        return -1;
+    }
+
+    out->flags = p[0];
+    out->peakCount = p[1];
+    out->binCount = get16(&p[2]);
+    out->bandCount = p[4];
+    if (out->peakCount > TELEMETRY_MAX_PEAKS || out->binCount > TELEMETRY_MAX_BINS ||
+        out->bandCount > TELEMETRY_MAX_BANDS ||
+        frame->length != 5 + 4 * out->peakCount + 2 * out->binCount + out->bandCount) {
+        return -1;
+    }
+    p += 5;
+
+    for (int i = 0; i < out->peakCount; i++, p += 4) {
+        out->peakFreqs[i] = get16(p) / 16.0f;
+        out->peakMags[i] = get16(p + 2) / 256.0f;
+    }
+    for (int i = 0; i < out->binCount; i++, p += 2) {
+        out->mags[i] = get16(p) / 256.0f;
+    }
+    for (int i = 0; i < out->bandCount; i++) {
+        out->bands[i] = *p++;
+    }
+    return 0;
+}
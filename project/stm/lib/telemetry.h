@@ -0,0 +1,123 @@
+// telemetry.h
+// Binary spectrum frames for the USART2 stream to a host viewer
+//
+// No register access in here, so the same file builds for the STM32 and the
+// host decoder (host/telem_decode.c).
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Definitions
+///////////////////////////////////////////////////////////////////////////////
+
+// Every frame, multi-byte fields little-endian (both ends are):
+//
+//   byte 0-1    sync A5 C3
+//   byte 2      frame type
+//   byte 3-4    payload length n
+//   byte 5-6    sequence number, the DSP frame count (gaps = frames not sent)
+//   byte 7-10   timestamp, DWT cycles at the start of the frame (wraps ~53 s)
+//   byte 11..   payload
+//   last 2      CRC-16/CCITT-FALSE of bytes 2 .. 10 + n
+//
+// The decoder resyncs on A5 C3 and drops anything whose CRC is wrong, so a
+// lost byte costs one frame.
+
+#define TELEMETRY_SYNC0         0xA5
+#define TELEMETRY_SYNC1         0xC3
+#define TELEMETRY_HEADER_BYTES  11
+#define TELEMETRY_CRC_BYTES     2
+
+// Spectrum payload:
+//
+//   byte 0      flags, bit 0 = detection (LED on)
+//   byte 1      peak count p
+//   byte 2-3    bin count b
+//   byte 4      band count c
+//   4p bytes    peaks, loudest first: frequency in 1/16 Hz, magnitude x 256
+//   2b bytes    bin magnitudes x 256 (saturated)
+//   c bytes     band levels 0-255, as sent to the FPGA
+#define TELEMETRY_SPECTRUM      0x01
+
+// Golden vector runs (host/golden.c -t, GOLDEN_TARGET in main.c). The host
+// sends VECTOR frames, payload = FFT_SIZE ADC codes as u16, and the target
+// answers each with a RESULT frame. RESULT has the spectrum payload, and its
+// header timestamp is the cycles the DSP chain took on that frame.
+#define TELEMETRY_VECTOR        0x02
+#define TELEMETRY_RESULT        0x03
+
+#define TELEMETRY_FLAG_DETECTED 0x01
+
+#define TELEMETRY_SPECTRUM_BYTES(peaks, bins, bands) \
+    (TELEMETRY_HEADER_BYTES + 5 + 4 * (peaks) + 2 * (bins) + (bands) + TELEMETRY_CRC_BYTES)
+#define TELEMETRY_VECTOR_BYTES(samples) \
+    (TELEMETRY_HEADER_BYTES + 2 * (samples) + TELEMETRY_CRC_BYTES)
+
+// Decoder limits
+#define TELEMETRY_MAX_PEAKS     16
+#define TELEMETRY_MAX_BINS      2048
+#define TELEMETRY_MAX_BANDS     64
+#define TELEMETRY_MAX_PAYLOAD   (5 + 4 * TELEMETRY_MAX_PEAKS + 2 * TELEMETRY_MAX_BINS + TELEMETRY_MAX_BANDS)
+
+typedef struct {
+    uint8_t type;
+    uint16_t seq;
+    uint32_t timestamp;
+    uint16_t length;
+    const uint8_t* payload;     // points into the buffer given to telemetryFind
+} TelemetryFrame;
+
+typedef struct {
+    uint8_t flags;
+    int peakCount;
+    int binCount;
+    int bandCount;
+    float peakFreqs[TELEMETRY_MAX_PEAKS];
+    float peakMags[TELEMETRY_MAX_PEAKS];
+    float mags[TELEMETRY_MAX_BINS];
+    uint8_t bands[TELEMETRY_MAX_BANDS];
+} TelemetrySpectrum;
+
+///////////////////////////////////////////////////////////////////////////////
+// Function prototypes
+///////////////////////////////////////////////////////////////////////////////
+
+/* CRC-16/CCITT-FALSE: poly 0x1021, init 0xFFFF, no reflection */
+uint16_t telemetryCrc16(const uint8_t* data, size_t len);
+
+/* Builds a spectrum frame in out (TELEMETRY_SPECTRUM_BYTES(peaks, bins,
+ * bands) long) and returns its length.
+ *    -- mags: magnitude of bins 0..bins-1
+ *    -- peakFreqs / peakMags: the notes, loudest first
+ *    -- bands: band levels, 0-255 */
+int telemetryPackSpectrum(uint8_t* out, uint16_t seq, uint32_t timestamp, uint8_t flags,
+                          const float* peakFreqs, const float* peakMags, int peaks,
+                          const float* mags, int bins, const uint8_t* bands, int numBands);
+
+/* Same frame with type TELEMETRY_RESULT, timestamp = cycles taken */
+int telemetryPackResult(uint8_t* out, uint16_t seq, uint32_t cycles, uint8_t flags,
+                        const float* peakFreqs, const float* peakMags, int peaks,
+                        const float* mags, int bins);
+
+/* Builds a TELEMETRY_VECTOR frame of n ADC codes, returns its length */
+int telemetryPackVector(uint8_t* out, uint16_t seq, const uint16_t* adc, int n);
+
+/* ADC codes of a TELEMETRY_VECTOR frame into adc (at most max). Returns the
+ * count, -1 if the frame is not a vector. */
+int telemetryVector(const TelemetryFrame* frame, uint16_t* adc, int max);
+
+/* Looks for the first frame in buf.
+ *    -- used: bytes of buf that are done with (frame, or junk in front of it)
+ *    -- return: 1 frame found, 0 need more data, -1 CRC error (the sync
+ *       bytes are skipped, call again) */
+int telemetryFind(const uint8_t* buf, size_t len, TelemetryFrame* frame, size_t* used);
+
+/* Unpacks a TELEMETRY_SPECTRUM or TELEMETRY_RESULT frame. Returns 0, -1 if the payload does not
+ * match its counts or exceeds the decoder limits. */
+int telemetrySpectrum(const TelemetryFrame* frame, TelemetrySpectrum* out);
+
+#endif
@@ -0,0 +1,435 @@
+// AudioADC.cs
+// ADC1 (and the ADC common block) of the STM32L432 with a scripted audio input
+//
+// Enough of RM0394 chapter 16 for lib/STM32L432KC_ADC.c and main.c:
+// ADVREGEN/DEEPPWD, ADCAL (done at once), ADEN -> ADRDY, ADDIS, ADSTART,
+// ADSTP, W1C ISR flags, EOC cleared by reading DR and OVR when a conversion
+// finds EOC still set. Each conversion also pulses DMARequest if
+// CFGR.DMAEN is set.
+//
+// A conversion starts on a trigger edge on GPIO input 0 (TIM6 TRGO) when
+// CFGR.EXTEN != 0. With EXTEN = 0 and CONT = 1 it converts at
+// ContinuousRate on its own clock. The channel is not checked: every
+// conversion samples the input below.
+//
+// Input: mid scale (2048) plus Noise LSB rms until Onset seconds of virtual
+// time, then the sum of the AddTone() sines and/or the LoadWav() file
+// (mono mix, linear interpolation, 8/16/24/32 bit PCM or float), times Gain.
+// 1.0 is full scale. With BurstOn and BurstOff > 0 the input after Onset is
+// bursts: BurstOn seconds of it (from its start again) then BurstOff seconds
+// of mid scale, repeated, for the firmware's latency test.
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Logging;
+using Antmicro.Renode.Peripherals.Bus;
+using Antmicro.Renode.Peripherals.Timers;
+using Antmicro.Renode.Time;
+
+namespace Antmicro.Renode.Peripherals.Analyzer
+{
+    [AllowedTranslations(AllowedTranslation.ByteToDoubleWord | AllowedTranslation.WordToDoubleWord)]
+    public class AudioADC : IDoubleWordPeripheral, IKnownSize, IGPIOReceiver
+    {
+        public AudioADC(IMachine machine, long frequency = 80000000)
+        {
+            this.machine = machine;
+            IRQ = new GPIO();
+            DMARequest = new GPIO();
+            continuous = new LimitTimer(machine.ClockSource, frequency, this, "cont", limit: (ulong)(frequency / 8000),
+                                        direction: Direction.Ascending, eventEnabled: true, autoUpdate: true);
+            continuous.LimitReached += Convert;
+            this.frequency = frequency;
+            tones = new List<Tuple<double, double>>();
+            random = new Random(1);
+            Gain = 1.0;
+            Onset = 0.0;
+            Noise = 0.0;
+            Reset();
+        }
+
+        public void Reset()
+        {
+            isr = 0;
+            ier = 0;
+            cr = CR_DEEPPWD;
+            cfgr = 0x80000000;
+            cfgr2 = 0;
+            smpr1 = 0;
+            smpr2 = 0;
+            sqr1 = 0;
+            dr = 0;
+            ccr = 0;
+            conversions = 0;
+            onsetLogged = false;
+            continuous.Enabled = false;
+            IRQ.Unset();
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            switch(offset)
+            {
+            case ISR: return isr;
+            case IER: return ier;
+            case CR: return cr;
+            case CFGR: return cfgr;
+            case CFGR2: return cfgr2;
+            case SMPR1: return smpr1;
+            case SMPR2: return smpr2;
+            case SQR1: return sqr1;
+            case DR:
+                isr &= ~ISR_EOC;
+                UpdateIRQ();
+                return dr;
+            case COMMON_CSR: return isr & 0x7FF;
+            case COMMON_CCR: return ccr;
+            case COMMON_CDR: return 0;
+            default:
+                this.Log(LogLevel.Noisy, "Read of unmodelled register 0x{0:X}", offset);
+                return 0;
+            }
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+            switch(offset)
+            {
+            case ISR:
+                isr &= ~value;  // rc_w1
+                UpdateIRQ();
+                break;
+            case IER:
+                ier = value & 0x7FF;
+                UpdateIRQ();
+                break;
+            case CR:
+                WriteCR(value);
+                break;
+            case CFGR:
+                if((cr & CR_ADSTART) != 0 && ((cfgr ^ value) & 0x3FFF) != 0)
+                {
+                    this.Log(LogLevel.Warning, "CFGR changed while ADSTART = 1 (0x{0:X8} -> 0x{1:X8})", cfgr, value);
+                }
+                cfgr = value;
+                break;
+            case CFGR2: cfgr2 = value; break;
+            case SMPR1: smpr1 = value; break;
+            case SMPR2: smpr2 = value; break;
+            case SQR1: sqr1 = value; break;
+            case COMMON_CCR: ccr = value; break;
+            default:
+                this.Log(LogLevel.Noisy, "Write of 0x{0:X} to unmodelled register 0x{1:X}", value, offset);
+                break;
+            }
+        }
+
+        // TIM6 TRGO on input 0
+        public void OnGPIO(int number, bool value)
+        {
+            if(number == 0 && value && (cr & CR_ADSTART) != 0 && ((cfgr >> 10) & 3) != 0)
+            {
+                Convert();
+            }
+        }
+
+        public void AddTone(double hz, double amplitude)
+        {
+            if(hz > 0)
+            {
+                tones.Add(Tuple.Create(hz, amplitude));
+            }
+        }
+
+        public void ClearTones()
+        {
+            tones.Clear();
+        }
+
+        public void LoadWav(string path)
+        {
+            wav = null;
+            if(string.IsNullOrEmpty(path))
+            {
+                return;
+            }
+            wav = ReadWav(path, out wavRate);
+            this.Log(LogLevel.Info, "{0}: {1} samples at {2} Hz", path, wav.Length, wavRate);
+        }
+
+        public double Onset { get; set; }
+        public double Gain { get; set; }
+        public double Noise { get; set; }
+        public double BurstOn { get; set; }
+        public double BurstOff { get; set; }
+
+        // Sample rate with EXTEN = 0, CONT = 1 (the host mock uses the same default)
+        public long ContinuousRate
+        {
+            get { return frequency / (long)continuous.Limit; }
+            set { continuous.Limit = (ulong)(frequency / value); }
+        }
+
+        public ulong Conversions => conversions;
+
+        public GPIO IRQ { get; }
+        public GPIO DMARequest { get; }
+
+        public long Size => 0x400;
+
+        private void WriteCR(uint value)
+        {
+            if((value & CR_ADCAL) != 0 && (cr & CR_ADEN) != 0)
+            {
+                this.Log(LogLevel.Warning, "ADCAL with ADEN = 1 is ignored");
+                value &= ~CR_ADCAL;
+            }
+            if((value & CR_ADVREGEN) != 0 && (value & CR_DEEPPWD) != 0)
+            {
+                this.Log(LogLevel.Warning, "ADVREGEN set while still in deep power down");
+            }
+
+            // Calibration finishes at once, ADCAL reads back 0
+            cr = value & ~(CR_ADCAL | CR_ADDIS | CR_ADSTP);
+
+            if((value & CR_ADDIS) != 0)
+            {
+                cr &= ~(CR_ADEN | CR_ADSTART);
+                isr &= ~ISR_ADRDY;
+            }
+            else if((value & CR_ADEN) != 0)
+            {
+                isr |= ISR_ADRDY;
+            }
+            if((value & CR_ADSTP) != 0)
+            {
+                cr &= ~CR_ADSTART;
+            }
+            if((cr & CR_ADEN) == 0)
+            {
+                cr &= ~CR_ADSTART;
+            }
+
+            bool software = ((cfgr >> 10) & 3) == 0;
+            bool running = (cr & CR_ADSTART) != 0;
+            continuous.Enabled = running && software && (cfgr & CFGR_CONT) != 0;
+            if(running && software && (cfgr & CFGR_CONT) == 0)
+            {
+                Convert();
+                cr &= ~CR_ADSTART;      // single conversion, ADSTART clears itself
+            }
+            UpdateIRQ();
+        }
+
+        private void Convert()
+        {
+            if((isr & ISR_EOC) != 0)
+            {
+                isr |= ISR_OVR;
+                if((cfgr & CFGR_OVRMOD) == 0)
+                {
+                    UpdateIRQ();
+                    return;             // DR keeps the old value
+                }
+            }
+            dr = Sample();
+            conversions++;
+            isr |= ISR_EOC | ISR_EOS;
+            UpdateIRQ();
+            if((cfgr & CFGR_DMAEN) != 0)
+            {
+                DMARequest.Blink();
+            }
+        }
+
+        private uint Sample()
+        {
+            double t = machine.LocalTimeSource.ElapsedVirtualTime.TotalSeconds;
+            double x = 0;
+            double ts = InputTime(t);
+            if(ts >= 0)
+            {
+                if(!onsetLogged)
+                {
+                    this.Log(LogLevel.Info, "Input onset at {0:F6} s", t);
+                    onsetLogged = true;
+                }
+                foreach(var tone in tones)
+                {
+                    x += tone.Item2 * Math.Sin(2 * Math.PI * tone.Item1 * ts);
+                }
+                if(wav != null)
+                {
+                    double pos = ts * wavRate;
+                    long i = (long)pos;
+                    if(i + 1 < wav.Length)
+                    {
+                        double frac = pos - i;
+                        x += wav[i] * (1 - frac) + wav[i + 1] * frac;
+                    }
+                }
+                x *= Gain;
+            }
+            double code = 2048 + x * 2047;
+            if(Noise > 0)
+            {
+                // Box-Muller, seeded so runs repeat
+                double u1 = 1.0 - random.NextDouble();
+                double u2 = random.NextDouble();
+                code += Noise * Math.Sqrt(-2 * Math.Log(u1)) * Math.Cos(2 * Math.PI * u2);
+            }
+            if(code < 0) code = 0;
+            if(code > 4095) code = 4095;
+            return (uint)Math.Round(code);
+        }
+
+        // Time into the input (the tones / WAV) at virtual time t, -1 while silent
+        private double InputTime(double t)
+        {
+            double ts = t - Onset;
+            if(ts < 0)
+            {
+                return -1;
+            }
+            if(BurstOn > 0 && BurstOff > 0)
+            {
+                ts %= BurstOn + BurstOff;
+                if(ts >= BurstOn)
+                {
+                    return -1;
+                }
+            }
+            return ts;
+        }
+
+        private void UpdateIRQ()
+        {
+            IRQ.Set((isr & ier & 0x7FF) != 0);
+        }
+
+        private static float[] ReadWav(string path, out int rate)
+        {
+            using(var reader = new BinaryReader(File.OpenRead(path)))
+            {
+                if(new string(reader.ReadChars(4)) != "RIFF")
+                {
+                    throw new IOException(path + ": not a RIFF file");
+                }
+                reader.ReadUInt32();
+                if(new string(reader.ReadChars(4)) != "WAVE")
+                {
+                    throw new IOException(path + ": not a WAVE file");
+                }
+
+                int format = 0, channels = 0, bits = 0;
+                rate = 0;
+                while(reader.BaseStream.Position + 8 <= reader.BaseStream.Length)
+                {
+                    string id = new string(reader.ReadChars(4));
+                    uint size = reader.ReadUInt32();
+                    long next = reader.BaseStream.Position + size + (size & 1);
+                    if(id == "fmt ")
+                    {
+                        format = reader.ReadUInt16();
+                        channels = reader.ReadUInt16();
+                        rate = (int)reader.ReadUInt32();
+                        reader.ReadUInt32();
+                        reader.ReadUInt16();
+                        bits = reader.ReadUInt16();
+                        if(format == 0xFFFE && size >= 26)
+                        {
+                            reader.ReadUInt16();
+                            reader.ReadUInt16();
+                            reader.ReadUInt32();
+                            format = reader.ReadUInt16();   // sub format GUID, first 2 bytes
+                        }
+                    }
+                    else if(id == "data")
+                    {
+                        if(channels == 0 || (format != 1 && format != 3))
+                        {
+                            throw new IOException(path + ": only PCM and float WAV files are supported");
+                        }
+                        int bytes = bits / 8;
+                        long frames = size / (bytes * channels);
+                        var samples = new float[frames];
+                        for(long f = 0; f < frames; f++)
+                        {
+                            double sum = 0;
+                            for(int c = 0; c < channels; c++)
+                            {
+                                sum += ReadSample(reader, format, bits);
+                            }
+                            samples[f] = (float)(sum / channels);
+                        }
+                        return samples;
+                    }
+                    reader.BaseStream.Position = next;
+                }
+                throw new IOException(path + ": no data chunk");
+            }
+        }
+
+        private static double ReadSample(BinaryReader reader, int format, int bits)
+        {
+            if(format == 3)
+            {
+                return bits == 64 ? reader.ReadDouble() : reader.ReadSingle();
+            }
+            switch(bits)
+            {
+            case 8: return (reader.ReadByte() - 128) / 128.0;
+            case 16: return reader.ReadInt16() / 32768.0;
+            case 24:
+                int v = reader.ReadByte() | (reader.ReadByte() << 8) | (reader.ReadSByte() << 16);
+                return v / 8388608.0;
+            case 32: return reader.ReadInt32() / 2147483648.0;
+            default: throw new IOException("unsupported sample size " + bits);
+            }
+        }
+
+        private readonly IMachine machine;
+        private readonly LimitTimer continuous;
+        private readonly long frequency;
+        private readonly List<Tuple<double, double>> tones;
+        private readonly Random random;
+        private float[] wav;
+        private int wavRate;
+        private bool onsetLogged;
+        private ulong conversions;
+
+        private uint isr, ier, cr, cfgr, cfgr2, smpr1, smpr2, sqr1, dr, ccr;
+
+        private const long ISR = 0x00;
+        private const long IER = 0x04;
+        private const long CR = 0x08;
+        private const long CFGR = 0x0C;
+        private const long CFGR2 = 0x10;
+        private const long SMPR1 = 0x14;
+        private const long SMPR2 = 0x18;
+        private const long SQR1 = 0x30;
+        private const long DR = 0x40;
+        private const long COMMON_CSR = 0x300;
+        private const long COMMON_CCR = 0x308;
+        private const long COMMON_CDR = 0x30C;
+
+        private const uint ISR_ADRDY = 1u << 0;
+        private const uint ISR_EOC = 1u << 2;
+        private const uint ISR_EOS = 1u << 3;
+        private const uint ISR_OVR = 1u << 4;
+
+        private const uint CR_ADEN = 1u << 0;
+        private const uint CR_ADDIS = 1u << 1;
+        private const uint CR_ADSTART = 1u << 2;
+        private const uint CR_ADSTP = 1u << 4;
+        private const uint CR_ADVREGEN = 1u << 28;
+        private const uint CR_DEEPPWD = 1u << 29;
+        private const uint CR_ADCAL = 1u << 31;
+
+        private const uint CFGR_DMAEN = 1u << 0;
+        private const uint CFGR_OVRMOD = 1u << 12;
+        private const uint CFGR_CONT = 1u << 13;
+    }
+}
@@ -0,0 +1,155 @@
+// BasicTimer.cs
+// TIM6/TIM7 basic timer of the STM32L432, the ADC sample clock in main.c
+//
+// CR1 (CEN, UDIS, OPM), CR2 MMS, DIER (UIE, UDE), SR UIF (rc_w0), EGR UG,
+// CNT, PSC, ARR. The counter runs at frequency / (PSC + 1) and wraps after
+// ARR + 1 counts. Every update event sets UIF and, with MMS = 010, pulses
+// TRGO (wired to the ADC trigger input). PSC and ARR take effect on the
+// next update, as with ARPE = 1; the firmware only writes them before CEN.
+
+using System;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Logging;
+using Antmicro.Renode.Peripherals.Bus;
+using Antmicro.Renode.Peripherals.Timers;
+using Antmicro.Renode.Time;
+
+namespace Antmicro.Renode.Peripherals.Analyzer
+{
+    [AllowedTranslations(AllowedTranslation.WordToDoubleWord)]
+    public class BasicTimer : IDoubleWordPeripheral, IKnownSize
+    {
+        public BasicTimer(IMachine machine, long frequency = 80000000)
+        {
+            IRQ = new GPIO();
+            TRGO = new GPIO();
+            timer = new LimitTimer(machine.ClockSource, frequency, this, "counter", limit: 0x10000,
+                                   direction: Direction.Ascending, eventEnabled: true, autoUpdate: true);
+            timer.LimitReached += Update;
+            Reset();
+        }
+
+        public void Reset()
+        {
+            cr1 = 0;
+            cr2 = 0;
+            dier = 0;
+            sr = 0;
+            psc = 0;
+            arr = 0xFFFF;
+            timer.Enabled = false;
+            timer.Divider = 1;
+            timer.Limit = 0x10000;
+            timer.Value = 0;
+            IRQ.Unset();
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            switch(offset)
+            {
+            case CR1: return cr1;
+            case CR2: return cr2;
+            case DIER: return dier;
+            case SR: return sr;
+            case CNT: return (uint)timer.Value;
+            case PSC: return psc;
+            case ARR: return arr;
+            default: return 0;
+            }
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+            switch(offset)
+            {
+            case CR1:
+                cr1 = value & 0x8F;
+                timer.Enabled = (cr1 & 1) != 0;
+                break;
+            case CR2:
+                cr2 = value & 0x70;
+                break;
+            case DIER:
+                dier = value & 0x101;
+                IRQ.Set((sr & dier & 1) != 0);
+                break;
+            case SR:
+                sr &= value;
+                IRQ.Set((sr & dier & 1) != 0);
+                break;
+            case EGR:
+                if((value & 1) != 0)
+                {
+                    timer.Value = 0;
+                    Load();
+                    if((cr1 & CR1_UDIS) == 0)
+                    {
+                        Update();
+                    }
+                }
+                break;
+            case CNT:
+                timer.Value = value & 0xFFFF;
+                break;
+            case PSC:
+                psc = value & 0xFFFF;
+                if(!timer.Enabled) Load();
+                break;
+            case ARR:
+                arr = value & 0xFFFF;
+                if(!timer.Enabled) Load();
+                break;
+            default:
+                this.Log(LogLevel.Noisy, "Write of 0x{0:X} to unmodelled register 0x{1:X}", value, offset);
+                break;
+            }
+        }
+
+        public GPIO IRQ { get; }
+        public GPIO TRGO { get; }
+
+        public long Size => 0x400;
+
+        private void Load()
+        {
+            timer.Divider = (int)psc + 1;
+            timer.Limit = (ulong)arr + 1;
+        }
+
+        private void Update()
+        {
+            Load();
+            if((cr1 & CR1_UDIS) != 0)
+            {
+                return;
+            }
+            sr |= 1;
+            IRQ.Set((dier & 1) != 0);
+            if(((cr2 >> 4) & 7) == 2)
+            {
+                TRGO.Blink();
+            }
+            if((cr1 & CR1_OPM) != 0)
+            {
+                cr1 &= ~1u;
+                timer.Enabled = false;
+            }
+        }
+
+        private readonly LimitTimer timer;
+        private uint cr1, cr2, dier, sr, psc, arr;
+
+        private const long CR1 = 0x00;
+        private const long CR2 = 0x04;
+        private const long DIER = 0x0C;
+        private const long SR = 0x10;
+        private const long EGR = 0x14;
+        private const long CNT = 0x24;
+        private const long PSC = 0x28;
+        private const long ARR = 0x2C;
+
+        private const uint CR1_UDIS = 1u << 1;
+        private const uint CR1_OPM = 1u << 3;
+    }
+}
@@ -0,0 +1,79 @@
+// CycleCounter.cs
+// DWT CTRL/CYCCNT of the Cortex-M4 (0xE0001000), for lib/STM32L432KC_DWT.c
+//
+// CYCCNT counts frequency ticks of virtual time while CYCCNTENA is set. With
+// the CPU at PerformanceInMips 80 (fft_analyzer.resc) one tick is one
+// instruction, so acq_health.c reads instruction counts: no flash wait
+// states, no FPU or divide latency. Compare builds with it, do not read it
+// as the load on a real board.
+
+using System;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Peripherals.Bus;
+
+namespace Antmicro.Renode.Peripherals.Analyzer
+{
+    public class CycleCounter : IDoubleWordPeripheral, IKnownSize
+    {
+        public CycleCounter(IMachine machine, long frequency = 80000000)
+        {
+            this.machine = machine;
+            this.frequency = frequency;
+            Reset();
+        }
+
+        public void Reset()
+        {
+            ctrl = 0x40000000;      // NUMCOMP = 4
+            held = 0;
+            start = Now();
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            switch(offset)
+            {
+            case CTRL: return ctrl;
+            case CYCCNT: return (uint)Count();
+            default: return 0;
+            }
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+            switch(offset)
+            {
+            case CTRL:
+                held = Count();
+                start = Now();
+                ctrl = (ctrl & 0xFFFF0000) | (value & 0xFFFF);
+                break;
+            case CYCCNT:
+                held = value;
+                start = Now();
+                break;
+            }
+        }
+
+        public long Size => 0x1000;
+
+        private ulong Count()
+        {
+            return (ctrl & 1) != 0 ? held + (Now() - start) : held;
+        }
+
+        private ulong Now()
+        {
+            return (ulong)(machine.LocalTimeSource.ElapsedVirtualTime.TotalSeconds * frequency);
+        }
+
+        private readonly IMachine machine;
+        private readonly long frequency;
+        private uint ctrl;
+        private ulong held;
+        private ulong start;
+
+        private const long CTRL = 0x00;
+        private const long CYCCNT = 0x04;
+    }
+}
@@ -0,0 +1,286 @@
+// DMA1.cs
+// DMA1 of the STM32L432: 7 channels, ISR/IFCR, CSELR
+//
+// A pulse on GPIO input n (0-6) is one request for channel n + 1. The
+// request lines are wired in stm32l432.repl (ADC1 -> 0, SPI1_TX -> 2), so
+// CSELR is stored but does not reroute anything. A request on an enabled
+// channel moves one item between CPAR and CMAR in the CCR direction, with
+// MINC/PINC, counts CNDTR down, sets HTIF/TCIF (+ GIF) and reloads in
+// circular mode. Output n is the channel n + 1 interrupt line (TCIE, HTIE,
+// TEIE). A transfer to or from an unmapped address sets TEIF and disables
+// the channel, as on the chip. Memory to memory mode is not modelled.
+//
+// The peripheral side is always accessed as a 32 bit word and cut to PSIZE,
+// the memory side with the MSIZE access.
+
+using System;
+using System.Collections.Generic;
+using System.Collections.ObjectModel;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Logging;
+using Antmicro.Renode.Peripherals.Bus;
+
+namespace Antmicro.Renode.Peripherals.Analyzer
+{
+    public class DMA1 : IDoubleWordPeripheral, IKnownSize, IGPIOReceiver, INumberedGPIOOutput
+    {
+        public DMA1(IMachine machine)
+        {
+            this.machine = machine;
+            var irqs = new Dictionary<int, IGPIO>();
+            for(int i = 0; i < Channels; i++)
+            {
+                irqs[i] = new GPIO();
+            }
+            Connections = new ReadOnlyDictionary<int, IGPIO>(irqs);
+            Reset();
+        }
+
+        public void Reset()
+        {
+            isr = 0;
+            cselr = 0;
+            for(int i = 0; i < Channels; i++)
+            {
+                ccr[i] = 0;
+                cndtr[i] = 0;
+                reload[i] = 0;
+                cpar[i] = 0;
+                cmar[i] = 0;
+                done[i] = 0;
+                Connections[i].Unset();
+            }
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            if(offset == ISR)
+            {
+                return isr;
+            }
+            if(offset == CSELR)
+            {
+                return cselr;
+            }
+            int ch;
+            long reg;
+            if(!Channel(offset, out ch, out reg))
+            {
+                return 0;
+            }
+            switch(reg)
+            {
+            case CCR: return ccr[ch];
+            case CNDTR: return cndtr[ch];
+            case CPAR: return cpar[ch];
+            case CMAR: return cmar[ch];
+            default: return 0;
+            }
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+            if(offset == IFCR)
+            {
+                for(int i = 0; i < Channels; i++)
+                {
+                    uint clear = (value >> (4 * i)) & 0xF;
+                    if((clear & 1) != 0)
+                    {
+                        clear = 0xF;    // CGIF clears all four
+                    }
+                    isr &= ~(clear << (4 * i));
+                }
+                UpdateIRQs();
+                return;
+            }
+            if(offset == CSELR)
+            {
+                cselr = value & 0x0FFFFFFF;
+                return;
+            }
+            int ch;
+            long reg;
+            if(!Channel(offset, out ch, out reg))
+            {
+                return;
+            }
+
+            bool enabled = (ccr[ch] & CCR_EN) != 0;
+            switch(reg)
+            {
+            case CCR:
+                if(enabled && (value & CCR_EN) != 0 && ((ccr[ch] ^ value) & 0x7FFE) != 0)
+                {
+                    this.Log(LogLevel.Warning, "Channel {0}: CCR changed while enabled", ch + 1);
+                }
+                ccr[ch] = value & 0x7FFF;
+                if(!enabled && (value & CCR_EN) != 0)
+                {
+                    done[ch] = 0;
+                    reload[ch] = cndtr[ch];
+                }
+                UpdateIRQs();
+                break;
+            case CNDTR:
+            case CPAR:
+            case CMAR:
+                if(enabled)
+                {
+                    this.Log(LogLevel.Warning, "Channel {0}: register 0x{1:X} written while enabled, ignored", ch + 1, reg);
+                    break;
+                }
+                if(reg == CNDTR) cndtr[ch] = value & 0xFFFF;
+                if(reg == CPAR) cpar[ch] = value;
+                if(reg == CMAR) cmar[ch] = value;
+                break;
+            }
+        }
+
+        // One request from the peripheral wired to input n
+        public void OnGPIO(int number, bool value)
+        {
+            if(!value || number < 0 || number >= Channels)
+            {
+                return;
+            }
+            int ch = number;
+            if((ccr[ch] & CCR_EN) == 0 || cndtr[ch] == 0)
+            {
+                return;
+            }
+
+            uint c = ccr[ch];
+            int psize = 1 << (int)((c >> 8) & 3);
+            int msize = 1 << (int)((c >> 10) & 3);
+            ulong paddr = cpar[ch] + (((c & CCR_PINC) != 0) ? done[ch] * (uint)psize : 0);
+            ulong maddr = cmar[ch] + (((c & CCR_MINC) != 0) ? done[ch] * (uint)msize : 0);
+            var bus = machine.SystemBus;
+
+            if(bus.WhatIsAt(paddr) == null || bus.WhatIsAt(maddr) == null)
+            {
+                this.Log(LogLevel.Warning, "Channel {0}: transfer error at 0x{1:X8} / 0x{2:X8}", ch + 1, paddr, maddr);
+                ccr[ch] &= ~CCR_EN;
+                SetFlags(ch, ISR_TEIF);
+                return;
+            }
+
+            if((c & CCR_DIR) != 0)
+            {
+                uint data = ReadMemory(maddr, msize);
+                bus.WriteDoubleWord(paddr, Cut(data, psize));
+            }
+            else
+            {
+                uint data = Cut(bus.ReadDoubleWord(paddr), psize);
+                WriteMemory(maddr, msize, data);
+            }
+
+            done[ch]++;
+            cndtr[ch]--;
+            uint flags = 0;
+            if(done[ch] == (reload[ch] + 1) / 2)
+            {
+                flags |= ISR_HTIF;
+            }
+            if(cndtr[ch] == 0)
+            {
+                flags |= ISR_TCIF;
+                if((c & CCR_CIRC) != 0)
+                {
+                    cndtr[ch] = reload[ch];
+                    done[ch] = 0;
+                }
+            }
+            if(flags != 0)
+            {
+                SetFlags(ch, flags);
+            }
+        }
+
+        public IReadOnlyDictionary<int, IGPIO> Connections { get; }
+
+        public long Size => 0x400;
+
+        private bool Channel(long offset, out int ch, out long reg)
+        {
+            ch = (int)((offset - 0x08) / 0x14);
+            reg = (offset - 0x08) % 0x14;
+            return offset >= 0x08 && ch < Channels;
+        }
+
+        private void SetFlags(int ch, uint flags)
+        {
+            isr |= (flags | ISR_GIF) << (4 * ch);
+            UpdateIRQs();
+        }
+
+        private void UpdateIRQs()
+        {
+            for(int i = 0; i < Channels; i++)
+            {
+                uint flags = (isr >> (4 * i)) & 0xE;
+                uint enables = ccr[i] & 0xE;   // TCIE, HTIE, TEIE line up with TCIF, HTIF, TEIF
+                Connections[i].Set((flags & enables) != 0);
+            }
+        }
+
+        private uint ReadMemory(ulong address, int size)
+        {
+            var bus = machine.SystemBus;
+            switch(size)
+            {
+            case 1: return bus.ReadByte(address);
+            case 2: return bus.ReadWord(address);
+            default: return bus.ReadDoubleWord(address);
+            }
+        }
+
+        private void WriteMemory(ulong address, int size, uint data)
+        {
+            var bus = machine.SystemBus;
+            switch(size)
+            {
+            case 1: bus.WriteByte(address, (byte)data); break;
+            case 2: bus.WriteWord(address, (ushort)data); break;
+            default: bus.WriteDoubleWord(address, data); break;
+            }
+        }
+
+        private static uint Cut(uint data, int size)
+        {
+            return size == 4 ? data : data & ((1u << (8 * size)) - 1);
+        }
+
+        private readonly IMachine machine;
+        private uint isr;
+        private uint cselr;
+        private readonly uint[] ccr = new uint[Channels];
+        private readonly uint[] cndtr = new uint[Channels];
+        private readonly uint[] reload = new uint[Channels];
+        private readonly uint[] cpar = new uint[Channels];
+        private readonly uint[] cmar = new uint[Channels];
+        private readonly uint[] done = new uint[Channels];
+
+        private const int Channels = 7;
+
+        private const long ISR = 0x00;
+        private const long IFCR = 0x04;
+        private const long CCR = 0x00;      // channel registers, relative to 0x08 + 0x14 * n
+        private const long CNDTR = 0x04;
+        private const long CPAR = 0x08;
+        private const long CMAR = 0x0C;
+        private const long CSELR = 0xA8;
+
+        private const uint ISR_GIF = 1u << 0;
+        private const uint ISR_TCIF = 1u << 1;
+        private const uint ISR_HTIF = 1u << 2;
+        private const uint ISR_TEIF = 1u << 3;
+
+        private const uint CCR_EN = 1u << 0;
+        private const uint CCR_DIR = 1u << 4;
+        private const uint CCR_CIRC = 1u << 5;
+        private const uint CCR_PINC = 1u << 6;
+        private const uint CCR_MINC = 1u << 7;
+    }
+}
@@ -0,0 +1,157 @@
+// OutputProbe.cs
+// Edge log for the firmware's GPIO outputs, and the latency / load report
+//
+// GPIO input n is port A pin n (stm32l432.repl wires PA9, the detection
+// LED). Every edge is logged at Info with its virtual time. Report() gives,
+// for each pin, the first rising edge after Onset (the time AudioADC starts
+// the input) and so the input to output latency. With BurstOn / BurstOff set
+// as on AudioADC it takes the first rise after the start of every burst and
+// reports the latency distribution over the bursts. It also reads the
+// acq_health.c counters from HealthAddress: frames produced / processed /
+// dropped and processing cycles against the frame period (see
+// CycleCounter.cs for what a cycle is here).
+
+using System;
+using System.Collections.Generic;
+using System.Text;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Logging;
+
+namespace Antmicro.Renode.Peripherals.Analyzer
+{
+    public class OutputProbe : IPeripheral, IGPIOReceiver
+    {
+        public OutputProbe(IMachine machine)
+        {
+            this.machine = machine;
+            pins = new SortedDictionary<int, Pin>();
+            Reset();
+        }
+
+        public void Reset()
+        {
+            pins.Clear();
+        }
+
+        public void OnGPIO(int number, bool value)
+        {
+            Pin pin;
+            if(!pins.TryGetValue(number, out pin))
+            {
+                pin = new Pin { FirstRise = -1, LastBurst = -1, Latencies = new List<double>() };
+                pins[number] = pin;
+            }
+            if(value == pin.Level)
+            {
+                return;
+            }
+            double t = Now();
+            pin.Level = value;
+            if(value)
+            {
+                pin.Rises++;
+                if(pin.FirstRise < 0 && t >= Onset)
+                {
+                    pin.FirstRise = t;
+                }
+                if(t >= Onset && BurstOn > 0 && BurstOff > 0)
+                {
+                    long burst = (long)((t - Onset) / (BurstOn + BurstOff));
+                    if(burst != pin.LastBurst)
+                    {
+                        pin.LastBurst = burst;
+                        pin.Latencies.Add(t - Onset - burst * (BurstOn + BurstOff));
+                    }
+                }
+            }
+            else
+            {
+                pin.Falls++;
+            }
+            this.Log(LogLevel.Info, "PA{0} -> {1} at {2:F6} s", number, value ? 1 : 0, t);
+        }
+
+        public string Report()
+        {
+            var s = new StringBuilder();
+            s.AppendFormat("Virtual time      {0:F3} s, input onset {1:F3} s\n", Now(), Onset);
+            foreach(var entry in pins)
+            {
+                var pin = entry.Value;
+                s.AppendFormat("PA{0,-2}              {1} rises, {2} falls", entry.Key, pin.Rises, pin.Falls);
+                if(pin.FirstRise >= 0)
+                {
+                    s.AppendFormat(", first rise {0:F6} s, latency {1:F2} ms", pin.FirstRise, (pin.FirstRise - Onset) * 1000);
+                }
+                else
+                {
+                    s.Append(", no rise after the onset");
+                }
+                s.Append("\n");
+                if(pin.Latencies.Count > 0)
+                {
+                    var sorted = new List<double>(pin.Latencies);
+                    sorted.Sort();
+                    double sum = 0;
+                    foreach(var l in sorted)
+                    {
+                        sum += l;
+                    }
+                    s.AppendFormat("PA{0,-2} bursts       {1} of {2} answered, latency min {3:F2} median {4:F2} mean {5:F2} max {6:F2} ms\n",
+                                   entry.Key, sorted.Count, Bursts(), sorted[0] * 1000, sorted[sorted.Count / 2] * 1000,
+                                   sum / sorted.Count * 1000, sorted[sorted.Count - 1] * 1000);
+                }
+            }
+
+            if(HealthAddress != 0)
+            {
+                var bus = machine.SystemBus;
+                Func<int, uint> field = i => bus.ReadDoubleWord(HealthAddress + 4 * (ulong)i);
+                uint period = field(9);
+                s.AppendFormat("Frames            {0} produced, {1} processed, {2} dropped\n", field(4), field(5), field(6));
+                s.AppendFormat("Interrupts        {0} TC, {1} HT, {2} TE, {3} ADC overruns\n", field(3), field(2), field(1), field(0));
+                if(period != 0)
+                {
+                    s.AppendFormat("Processing        last {0} max {1} of {2} cycles per frame ({3:F1}% / {4:F1}%)\n",
+                                   field(7), field(8), period, 100.0 * field(7) / period, 100.0 * field(8) / period);
+                }
+            }
+            return s.ToString();
+        }
+
+        // Time the input starts, same value as AudioADC.Onset
+        public double Onset { get; set; }
+
+        // Burst timing, same values as AudioADC.BurstOn / BurstOff (0: one onset)
+        public double BurstOn { get; set; }
+        public double BurstOff { get; set; }
+
+        // Address of the AcqHealth struct in acq_health.c (0: not reported)
+        public ulong HealthAddress { get; set; }
+
+        private double Now()
+        {
+            return machine.LocalTimeSource.ElapsedVirtualTime.TotalSeconds;
+        }
+
+        // Bursts started so far
+        private long Bursts()
+        {
+            double t = Now() - Onset;
+            return t < 0 ? 0 : (long)(t / (BurstOn + BurstOff)) + 1;
+        }
+
+        private class Pin
+        {
+            public bool Level;
+            public ulong Rises;
+            public ulong Falls;
+            public double FirstRise;
+            public long LastBurst;
+            public List<double> Latencies;
+        }
+
+        private readonly IMachine machine;
+        private readonly SortedDictionary<int, Pin> pins;
+    }
+}
@@ -0,0 +1,171 @@
+// SPI1Frames.cs
+// SPI1 master of the STM32L432 as used by lib/STM32L432KC_SPI.c and fpga_link.c
+//
+// Bytes leave at frequency / 2^(BR+1) / 8. TXE is set again one byte time
+// after a DR write, and BSY/FTLVL stay set until then. With CR2.TXDMAEN each
+// free byte slot pulses DMARequest (wired to DMA1 channel 3). RXNE is never
+// set: nothing is connected to MISO.
+//
+// GPIO input 0 is CS (PA11). The bytes between CS low and CS high are one
+// frame. Frames are logged at Info level as "frame type 0xNN, N bytes: ...",
+// e.g. the band levels frame 01 ss l0 .. l11 that the FPGA gets.
+
+using System;
+using System.Collections.Generic;
+using System.Text;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Logging;
+using Antmicro.Renode.Peripherals.Bus;
+using Antmicro.Renode.Peripherals.Timers;
+using Antmicro.Renode.Time;
+
+namespace Antmicro.Renode.Peripherals.Analyzer
+{
+    [AllowedTranslations(AllowedTranslation.ByteToDoubleWord | AllowedTranslation.WordToDoubleWord)]
+    public class SPI1Frames : IDoubleWordPeripheral, IKnownSize, IGPIOReceiver
+    {
+        public SPI1Frames(IMachine machine, long frequency = 80000000)
+        {
+            IRQ = new GPIO();
+            DMARequest = new GPIO();
+            byteTimer = new LimitTimer(machine.ClockSource, frequency, this, "byte", limit: 16 * 8,
+                                       direction: Direction.Ascending, eventEnabled: true, autoUpdate: true);
+            byteTimer.LimitReached += ByteDone;
+            frame = new List<byte>();
+            Reset();
+        }
+
+        public void Reset()
+        {
+            cr1 = 0;
+            cr2 = 0x0700;
+            busy = false;
+            csLow = false;
+            frame.Clear();
+            Frames = 0;
+            byteTimer.Enabled = false;
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            switch(offset)
+            {
+            case CR1: return cr1;
+            case CR2: return cr2;
+            case SR: return busy ? (SR_BSY | SR_FTLVL) : SR_TXE;
+            case DR: return 0;
+            default: return 0;
+            }
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+            switch(offset)
+            {
+            case CR1:
+                cr1 = value & 0xFFFF;
+                break;
+            case CR2:
+                bool dmaWasOn = (cr2 & CR2_TXDMAEN) != 0;
+                cr2 = value & 0x7FFF;
+                if(!dmaWasOn && (cr2 & CR2_TXDMAEN) != 0 && !busy)
+                {
+                    DMARequest.Blink();
+                }
+                break;
+            case DR:
+                Send((byte)value);
+                break;
+            default:
+                break;
+            }
+        }
+
+        // CS on input 0
+        public void OnGPIO(int number, bool value)
+        {
+            if(number != 0)
+            {
+                return;
+            }
+            if(!value && !csLow)
+            {
+                frame.Clear();
+            }
+            else if(value && csLow && frame.Count > 0)
+            {
+                Frames++;
+                var hex = new StringBuilder();
+                foreach(var b in frame)
+                {
+                    hex.AppendFormat(" {0:X2}", b);
+                }
+                this.Log(LogLevel.Info, "frame type 0x{0:X2}, {1} bytes:{2}", frame[0], frame.Count, hex);
+            }
+            csLow = !value;
+        }
+
+        public ulong Frames { get; private set; }
+
+        public GPIO IRQ { get; }
+        public GPIO DMARequest { get; }
+
+        public long Size => 0x400;
+
+        private void Send(byte data)
+        {
+            if((cr1 & CR1_SPE) == 0)
+            {
+                this.Log(LogLevel.Warning, "DR written with SPE = 0");
+                return;
+            }
+            if(busy)
+            {
+                this.Log(LogLevel.Warning, "DR written while the last byte is still going, 0x{0:X2} lost", data);
+                return;
+            }
+            if(!csLow)
+            {
+                this.Log(LogLevel.Debug, "Byte 0x{0:X2} sent with CS high", data);
+            }
+            frame.Add(data);
+            busy = true;
+            byteTimer.Limit = (ulong)(8 << (int)(((cr1 >> 3) & 7) + 1));
+            if(!byteTimer.Enabled)
+            {
+                byteTimer.Value = 0;
+                byteTimer.Enabled = true;
+            }
+        }
+
+        private void ByteDone()
+        {
+            busy = false;
+            if((cr2 & CR2_TXDMAEN) != 0)
+            {
+                DMARequest.Blink();     // may Send() the next byte right away
+            }
+            if(!busy)
+            {
+                byteTimer.Enabled = false;
+            }
+        }
+
+        private readonly LimitTimer byteTimer;
+        private readonly List<byte> frame;
+        private uint cr1, cr2;
+        private bool busy;
+        private bool csLow;
+
+        private const long CR1 = 0x00;
+        private const long CR2 = 0x04;
+        private const long SR = 0x08;
+        private const long DR = 0x0C;
+
+        private const uint CR1_SPE = 1u << 6;
+        private const uint CR2_TXDMAEN = 1u << 1;
+        private const uint SR_TXE = 1u << 1;
+        private const uint SR_BSY = 1u << 7;
+        private const uint SR_FTLVL = 3u << 11;
+    }
+}
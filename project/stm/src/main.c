@@ -6,10 +6,16 @@
  *   1. Samples audio input via ADC (8 kHz sample rate)
  *   2. Performs Fast Fourier Transform (FFT) to identify dominant frequency
  *   3. Outputs LED indication when frequency > 100 Hz is detected
+ *   4. Plays the loudest notes on the coil, one hardware timer per voice
+ *   5. Sends 12 band levels to the FPGA LED display over SPI
  *
  * HARDWARE CONFIGURATION:
  *   - Input:  PA6 (Board Label: A5, ADC Channel 11)
  *   - Output: PA9 (Board Label: D1, LED indicator)
+ *   - Coil:   PA5/PA8/PA3 (TIM2/TIM1/TIM15 voices, OR'ed externally)
+ *   - FPGA:   SPI1 SCK PB3, MOSI PB5, CS PA11 (band level frames)
+ *   - Host:   USART2 TX PA2 / RX PA15 (ST-Link VCP, binary spectrum frames,
+ *             golden vectors)
  *   - Platform: STM32L432KC Nucleo-32
  *   - Reference Voltage: 3.3V
  *
@@ -38,23 +44,103 @@
 #include "../lib/STM32L432KC_TIM.h"
 #include "../lib/STM32L432KC_DMA.h"
 #include "../lib/STM32L432KC_FLASH.h"
+#include "../lib/STM32L432KC_PWR.h"
+#include "../lib/STM32L432KC_USART.h"
+#include "../lib/STM32L432KC_DWT.h"
+#include "../lib/interrupter.h"
+#include "../lib/acq_health.h"
+#include "../lib/fpga_link.h"
+#include "../lib/fft_processing.h"
+#include "../lib/profile.h"
+#include "../lib/latency.h"
+#include "../lib/telemetry.h"
+#include "../lib/placement.h"
+#include "../lib/memlayout.h"
 
 /*******************************************************************************
  * CONFIGURATION PARAMETERS
  ******************************************************************************/
 
+// System clock (HCLK). initSystem() sets the voltage range and the fewest
+// flash wait states for it, then switches to the PLL. DWT_CPU_HZ,
+// USART_CLK_HZ and TIM_KERNEL_CLK_HZ in the drivers assume the same value.
+#define HCLK_HZ         80000000UL
+
 // Pin Definitions
 #define LED_PIN         9       // PA9 (Board D1) - Output LED indicator
 #define AUDIO_INPUT_PIN 6       // PA6 (Board A5) - Analog audio input
 #define ADC_CHANNEL     11      // ADC1 Channel 11 (maps to PA6)
 
-// Signal Processing Parameters
-#define FFT_SIZE        256     // FFT window size (must be power of 2)
-#define SAMPLE_RATE     8000    // Sampling frequency in Hz
+// Signal processing parameters (FFT_SIZE, SAMPLE_RATE, detection
+// thresholds) are in fft_processing.h, shared with the host build
+
+// FPGA display source: 0 = band levels from this FFT, 1 = raw samples for
+// the Goertzel bank on the FPGA (no spectral work here for the display)
+#define FPGA_SEND_SAMPLES  0
+
+// WS2812 bar graph on the FPGA strip output: 1 = also send FPGA_NUM_BARS
+// levels from this FFT (with FPGA_SEND_SAMPLES the FPGA makes its own)
+#define FPGA_SEND_BARS     1
+
+// Post-mortem: the first time a frame is dropped, have the FPGA dump the
+// band history that led up to it on hist_tx
+#define FPGA_HISTORY_ON_DROP  1
+
+// Coil voices: 0 = STM32 timers (interrupter.c), 1 = DDS voices on the FPGA
+// (coil_out, 48 MHz resolution, polyphony limited by FPGA resources)
+#define COIL_ON_FPGA  0
+
+// Spectrum stream to the host (telemetry.h, host/telem_decode): every frame's
+// bins, notes and band levels over USART2 by DMA. A frame (~300 bytes) takes
+// 1.5 ms at 2 Mbaud, it is skipped if the last one is still going.
+#define TELEMETRY_ENABLE   1
+#define TELEMETRY_BAUD     2000000
+
+// Golden vector target (host/golden -t): 1 = no ADC, each block the host
+// sends over USART2 goes through the DSP chain and the notes, spectrum and
+// cycle count go back. Nothing else runs in this mode.
+#define GOLDEN_TARGET      0
+
+// Polyphonic output
+#if COIL_ON_FPGA
+#define MAX_NOTES       FPGA_NUM_VOICES         // One note per DDS voice
+#else
+#define MAX_NOTES       INTERRUPTER_MAX_VOICES  // One note per timer voice
+#endif
+
+// Profile zones (profile.h), printed with the health counters. PROFILE_ENABLE
+// 0 (default with NDEBUG) compiles them out.
+enum {
+    ZONE_WAIT,          // end of one frame to buffer_ready for the next
+    ZONE_NORMALIZE,     // fftNormalize
+    ZONE_FFT,           // fft_compute
+    ZONE_PEAKS,         // fftFindNotes
+    ZONE_OUTPUT,        // voices, FPGA frames, LED
+    NUM_ZONES
+};
+
+#if PROFILE_ENABLE
+static const char* const zoneNames[NUM_ZONES] = {
+    "wait", "normalize", "fft", "peaks", "output"
+};
+#endif
 
-// Detection Thresholds
-#define FREQ_THRESHOLD  100.0f  // Minimum frequency to trigger LED (Hz)
-#define MAG_THRESHOLD   10.0f   // Minimum magnitude to avoid noise
+// Latency test (latency.h): 1 = time every onset in the input to the LED
+// going on and to the first non-zero FPGA levels frame, printed with the
+// health counters. Drive it with tone bursts with at least 64 ms (four half
+// buffers) of silence between them.
+#define LATENCY_TEST       0
+#define LATENCY_THRESHOLD  64       // onset: ADC codes away from mid scale
+
+enum {
+    LAT_LED,            // PA9 on
+    LAT_FPGA,           // band levels frame handed to SPI DMA
+    NUM_LAT_OUTPUTS
+};
+
+#if LATENCY_TEST
+static const char* const latencyNames[NUM_LAT_OUTPUTS] = { "led", "fpga" };
+#endif
 
 /*******************************************************************************
  * HARDWARE REGISTER DEFINITIONS
@@ -107,27 +193,13 @@ typedef struct {
 #define TIM6_BASE  (0x40001000UL)
 #define TIM6       ((TIM_TypeDef *) TIM6_BASE)
 
-// Math Constant
-#ifndef M_PI
-#define M_PI 3.14159265358979323846f
-#endif
-
-/*******************************************************************************
- * DATA STRUCTURES
- ******************************************************************************/
-
-// Complex number for FFT computation
-typedef struct {
-    float real;     // Real component
-    float imag;     // Imaginary component
-} Complex;
-
 /*******************************************************************************
  * GLOBAL VARIABLES
  ******************************************************************************/
 
-// ADC buffer filled by DMA (raw 12-bit ADC values: 0-4095)
-uint16_t adc_buffer[FFT_SIZE];
+// ADC buffer filled by DMA (raw 12-bit ADC values: 0-4095), in the SRAM2
+// DMA region like every buffer a DMA channel touches (placement.h)
+DMA_BUFFER uint16_t adc_buffer[FFT_SIZE];
 
 // Flag set by DMA interrupt when buffer is full and ready for processing
 volatile bool buffer_ready = false;
@@ -135,105 +207,81 @@ volatile bool buffer_ready = false;
 // FFT buffer for frequency domain analysis
 Complex fft_buffer[FFT_SIZE];
 
+// Detected notes, loudest first, handed to the interrupter voice allocator
+float note_freqs[MAX_NOTES];
+float note_mags[MAX_NOTES];
+
+// Magnitude spectrum (bins 0 to FFT_SIZE/2 - 1) and the band levels built
+// from it for the FPGA display
+float mag_buffer[FFT_SIZE / 2];
+uint8_t band_levels[FPGA_NUM_BANDS];
+uint8_t bar_levels[FPGA_NUM_BARS];
+
+// Square wave fallback buckets on the FPGA, log spaced (~5.2 semitones each
+// from 100 Hz to 2 kHz) instead of the linear ~167 Hz reset table. The
+// fallback only lights the display once level frames stop arriving, so the
+// table is loaded once at startup and not kept up to date.
+float bucket_edges[FPGA_NUM_BANDS - 1];
+
+// Set once the post-mortem history dump has been requested
+int history_dumped = 0;
+
+#if TELEMETRY_ENABLE
+// Telemetry frame, owned by DMA until usartDMABusy() clears
+DMA_BUFFER uint8_t telemetry_frame[TELEMETRY_SPECTRUM_BYTES(MAX_NOTES, FFT_SIZE / 2, FPGA_NUM_BANDS)];
+uint32_t telemetry_skipped = 0;
+#endif
+
 /*******************************************************************************
- * FAST FOURIER TRANSFORM (FFT) IMPLEMENTATION
- * Algorithm: Cooley-Tukey Radix-2 Decimation-in-Time FFT
- * Complexity: O(N log N) where N = FFT_SIZE
+ * INTERRUPT SERVICE ROUTINES
  ******************************************************************************/
 
 /**
- * @brief Performs in-place Fast Fourier Transform
- * @param data Pointer to complex data array (length n, must be power of 2)
- * @param n Number of samples (must be power of 2)
+ * @brief DMA1 Channel 1 Interrupt (transfer complete, half transfer, error)
  *
- * ALGORITHM:
- *   1. Bit-reversal permutation: Reorder input for in-place computation
- *   2. Cooley-Tukey butterfly operations: Combine frequency components
+ * TRIGGER: When DMA has filled the entire adc_buffer (256 samples), when it
+ *          is half full, or on a bus error
+ * FREQUENCY: ~62 Hz (TC + HT at 8000 Hz sample rate / 256 samples)
+ * ACTION: Sets buffer_ready flag for main loop to process, counts every flag
+ *         in the acquisition health stats
  *
- * MATHEMATICAL BASIS:
- *   X[k] = Σ(n=0 to N-1) x[n] * e^(-j*2π*k*n/N)
- *   where X[k] is the frequency domain representation
+ * NOTE: HTIE is enabled in initDMA_ADC(), so HTIF has to be cleared here too
+ *       or the interrupt keeps re-entering.
  */
-void fft_compute(Complex* data, int n) {
-    int i, j;
-
-    // STEP 1: Bit-Reversal Permutation
-    // Reorders array elements so FFT can be computed in-place
-    // Example (n=8): [0,1,2,3,4,5,6,7] → [0,4,2,6,1,5,3,7]
-    for (i = 1, j = 0; i < n; i++) {
-        int bit = n >> 1;
-
-        // Calculate bit-reversed index
-        for (; j >= bit; bit >>= 1) {
-            j -= bit;
-        }
-        j += bit;
+void DMA1_Channel1_IRQHandler(void) {
+    // Channel 1 flags are ISR bits [3:0]: GIF, TCIF, HTIF, TEIF
+    uint32_t flags = DMA1->ISR & 0xF;
 
-        // Swap elements if needed
-        if (i < j) {
-            Complex temp = data[i];
-            data[i] = data[j];
-            data[j] = temp;
-        }
-    }
+    // Clear everything we saw in one write (CGIF clears all four)
+    DMA1->IFCR |= flags;
 
-    // STEP 2: Cooley-Tukey FFT Butterfly Operations
-    // Process in stages: pairs, then groups of 4, 8, 16, etc.
-    for (int len = 2; len <= n; len <<= 1) {
-        // Calculate twiddle factor for this stage
-        // w = e^(-j*2π/len) = cos(-2π/len) + j*sin(-2π/len)
-        float angle = -2.0f * M_PI / len;
-        Complex wlen = {cosf(angle), sinf(angle)};
-
-        // Process each group of size 'len'
-        for (i = 0; i < n; i += len) {
-            Complex w = {1.0f, 0.0f};  // w^0 = 1
-
-            // Butterfly operations within this group
-            for (j = 0; j < len / 2; j++) {
-                // Extract the two elements for butterfly
-                Complex u = data[i + j];
-
-                // Complex multiplication: v = data[i + j + len/2] * w
-                Complex v = {
-                    data[i + j + len/2].real * w.real - data[i + j + len/2].imag * w.imag,
-                    data[i + j + len/2].real * w.imag + data[i + j + len/2].imag * w.real
-                };
-
-                // Butterfly combination
-                data[i + j].real = u.real + v.real;
-                data[i + j].imag = u.imag + v.imag;
-                data[i + j + len/2].real = u.real - v.real;
-                data[i + j + len/2].imag = u.imag - v.imag;
-
-                // Update twiddle factor: w = w * wlen
-                float w_temp = w.real;
-                w.real = w.real * wlen.real - w.imag * wlen.imag;
-                w.imag = w_temp * wlen.imag + w.imag * wlen.real;
-            }
-        }
+    acqHealthDMAFlags(flags);
+
+#if LATENCY_TEST
+    // Half Transfer (HTIF1, bit 2): first half is done, then the second
+    if (flags & (1 << 2)) latencyScan(adc_buffer, FFT_SIZE / 2);
+    if (flags & (1 << 1)) latencyScan(adc_buffer + FFT_SIZE / 2, FFT_SIZE / 2);
+#endif
+
+    // Transfer Complete (TCIF1, bit 1): a full frame is ready
+    if (flags & (1 << 1)) {
+        // If the last frame was never picked up it is lost now
+        acqHealthFrameProduced(buffer_ready);
+
+        // Signal main loop that buffer is ready for FFT processing
+        buffer_ready = true;
     }
 }
 
-/*******************************************************************************
- * INTERRUPT SERVICE ROUTINES
- ******************************************************************************/
-
 /**
- * @brief DMA1 Channel 1 Transfer Complete Interrupt
+ * @brief ADC1 Interrupt (overrun only)
  *
- * TRIGGER: When DMA has filled the entire adc_buffer (256 samples)
- * FREQUENCY: ~31 Hz (8000 Hz sample rate / 256 samples)
- * ACTION: Sets buffer_ready flag for main loop to process
+ * OVRMOD = 1 silently overwrites the data register when DMA falls behind,
+ * so this is the only place a lost sample shows up.
  */
-void DMA1_Channel1_IRQHandler(void) {
-    // Check if Transfer Complete flag is set (TCIF1, bit 1)
-    if (DMA1->ISR & (1 << 1)) {
-        // Clear the flag by writing 1 to CTCIF1 (bit 1)
-        DMA1->IFCR |= (1 << 1);
-
-        // Signal main loop that buffer is ready for FFT processing
-        buffer_ready = true;
+void ADC1_IRQHandler(void) {
+    if (clearADCOverrun()) {
+        acqHealthADCOverrun();
     }
 }
 
@@ -245,17 +293,16 @@ void DMA1_Channel1_IRQHandler(void) {
  * @brief Initialize system clocks and peripherals
  *
  * CONFIGURATION:
- *   - Enables instruction cache, data cache, and prefetch buffer
+ *   - Voltage range 1 and flash wait states for HCLK_HZ, prefetch and
+ *     instruction / data cache on (configureFlash), then the 80 MHz PLL
  *   - Enables GPIOA clock for PA6 and PA9
  *   - Configures GPIO pins for analog input and digital output
  *   - Enables Floating Point Unit (FPU) for fast math operations
  */
 void initSystem(void) {
-    // Enable Flash performance features for 80 MHz operation
-    // Bit 8: ICEN (Instruction cache enable)
-    // Bit 9: DCEN (Data cache enable)
-    // Bit 10: PRFTEN (Prefetch enable)
-    FLASH->ACR |= (1 << 8) | (1 << 9) | (1 << 10);
+    // Wait states go up before the clock does
+    configureFlash(HCLK_HZ, 0);
+    configureClock();
 
     // Enable GPIOA clock (AHB2 bus)
     // Bit 0: GPIOAEN
@@ -330,6 +377,10 @@ void initADC_DMA(void) {
     // ISER[0] bit 11: DMA1_Channel1_IRQn (IRQ 11)
     NVIC->ISER[0] |= (1 << 11);
 
+    // Enable ADC1 interrupt in NVIC for overrun counting
+    // ISER[0] bit 18: ADC1_IRQn (IRQ 18)
+    NVIC->ISER[0] |= (1 << 18);
+
     // Enable ADC clock (AHB2 bus)
     // Bit 13: ADCEN
     RCC->AHB2ENR |= (1 << 13);
@@ -376,6 +427,9 @@ void initADC_DMA(void) {
     // Value 010 = 12.5 ADC clock cycles sampling time
     ADC1->SMPR2 |= (2U << 3);
 
+    // Count overruns (OVR) instead of losing samples silently
+    enableADCOverrunIRQ();
+
     // Start ADC conversions (ADSTART bit 2)
     ADC1->CR |= (1 << 2);
 
@@ -383,6 +437,78 @@ void initADC_DMA(void) {
     enableDMA_ADC();
 }
 
+/**
+ * @brief Initialize USART2 and its DMA channel for the telemetry stream
+ *
+ * DMA1 Channel 7 (USART2_TX) runs at low priority, behind the ADC and the
+ * FPGA link, and its interrupt only hands the buffer back.
+ */
+void initTelemetry(void) {
+    initUSART(TELEMETRY_BAUD);
+
+    // ISER[0] bit 17: DMA1_Channel7_IRQn (IRQ 17)
+    NVIC->ISER[0] |= (1 << 17);
+}
+
+#if GOLDEN_TARGET
+/**
+ * @brief Golden vector loop, never returns
+ *
+ * Every TELEMETRY_VECTOR frame from host/golden replaces adc_buffer and goes
+ * through the same calls as the main loop, timed with the DWT from
+ * fftNormalize to fftDetect. The answer is a TELEMETRY_RESULT frame with the
+ * same sequence number and the cycles as its timestamp. The host waits for
+ * each answer, so nothing arrives while a block is processed.
+ */
+void goldenLoop(void) {
+    static uint8_t rx[2 * TELEMETRY_VECTOR_BYTES(FFT_SIZE)];
+    DMA_BUFFER static uint8_t tx[TELEMETRY_SPECTRUM_BYTES(MAX_NOTES, FFT_SIZE / 2, 0)];
+    size_t rx_len = 0;
+
+    initDWT();
+    printf("Golden vector target: waiting for host/golden -t\n");
+
+    while (1) {
+        uint8_t c;
+        if (!usartReceiveChar(&c)) continue;
+        rx[rx_len++] = c;
+
+        TelemetryFrame frame;
+        size_t used;
+        int found = telemetryFind(rx, rx_len, &frame, &used);
+        if (found == 0 && used == 0) {
+            if (rx_len < sizeof(rx)) continue;
+            used = rx_len;                  // full of junk, start over
+        }
+
+        if (found == 1 && telemetryVector(&frame, adc_buffer, FFT_SIZE) == FFT_SIZE) {
+            uint32_t start = DWT_CYCLES();
+            fftNormalize(adc_buffer, fft_buffer, FFT_SIZE);
+            fft_compute(fft_buffer, FFT_SIZE);
+            int play_count = fftFindNotes(fft_buffer, FFT_SIZE, SAMPLE_RATE, MAG_THRESHOLD,
+                                          FREQ_THRESHOLD, mag_buffer, note_freqs, note_mags,
+                                          MAX_NOTES);
+            float dominant_mag;
+            float dominant = fftDominant(mag_buffer, FFT_SIZE / 2,
+                                         (float)SAMPLE_RATE / FFT_SIZE, &dominant_mag);
+            int detected = fftDetect(dominant, dominant_mag, FREQ_THRESHOLD, MAG_THRESHOLD);
+            uint32_t cycles = DWT_CYCLES() - start;
+
+            int len = telemetryPackResult(tx, frame.seq, cycles,
+                                          detected ? TELEMETRY_FLAG_DETECTED : 0,
+                                          note_freqs, note_mags, play_count,
+                                          mag_buffer, FFT_SIZE / 2);
+            usartSendDMA(tx, len);
+            while (usartDMABusy());
+        }
+
+        // Keep whatever came after the frame
+        for (size_t i = used; i < rx_len; i++) rx[i - used] = rx[i];
+        rx_len -= used;
+    }
+}
+#endif
+
 /*******************************************************************************
  * MAIN PROGRAM
  ******************************************************************************/
@@ -413,10 +539,30 @@ void initADC_DMA(void) {
  *   Bin 128: 4000 Hz (Nyquist limit)
  */
 int main(void) {
+    memlayoutInit();     // .ramfunc / DMA buffers (GCC build only)
+
     // Initialize all hardware subsystems
     initSystem();        // Clocks, GPIO, FPU
+#if GOLDEN_TARGET
+    initTelemetry();     // USART2 both ways, no ADC / coil / FPGA
+    goldenLoop();
+#endif
+    initAcqHealth(FFT_SIZE, SAMPLE_RATE);  // Pipeline counters (before IRQs)
+    PROFILE_INIT(zoneNames, NUM_ZONES);
+#if LATENCY_TEST
+    initLatency(latencyNames, NUM_LAT_OUTPUTS, SAMPLE_RATE, LATENCY_THRESHOLD);
+#endif
     initADC_DMA();       // ADC and DMA (MUST be before timer!)
     initTimer_ADC();     // TIM6 trigger at 8 kHz
+#if !COIL_ON_FPGA
+    initInterrupter();   // Coil voices on TIM2/TIM1/TIM15
+#endif
+    initFPGALink();      // SPI1 + DMA1_Ch3 to the LED display
+    fpgaLogBucketEdges(FREQ_THRESHOLD, 2000.0f, bucket_edges);
+    fpgaSendBucketTable(bucket_edges);
+#if TELEMETRY_ENABLE
+    initTelemetry();     // USART2 + DMA1_Ch7 to the host
+#endif
 
     printf("\n========================================\n");
     printf("  FFT VALIDATION MODE\n");
@@ -427,59 +573,154 @@ int main(void) {
     printf("Update Rate: %.1f Hz\n", (float)SAMPLE_RATE / FFT_SIZE);
     printf("\nLED ON: Frequency > %.0f Hz\n", FREQ_THRESHOLD);
     printf("LED OFF: Frequency < %.0f Hz\n\n", FREQ_THRESHOLD);
+    printf("HCLK %lu MHz, range %d, flash ACR 0x%03lx (%lu wait states)\n",
+           HCLK_HZ / 1000000UL, pwrRange(), (unsigned long)FLASH->ACR,
+           (unsigned long)(FLASH->ACR & FLASH_ACR_LATENCY));
+    memlayoutPrint();
+    printf("\n");
 
     // Main processing loop
     while(1) {
         // Wait for DMA interrupt to signal buffer is full
         if (buffer_ready) {
+            PROFILE_END(ZONE_WAIT);
             buffer_ready = false;  // Clear flag
+            acqHealthFrameStart();
+#if TELEMETRY_ENABLE
+            uint32_t frame_cycles = DWT_CYCLES();
+            uint16_t frame_seq = (uint16_t)acqHealth()->framesProduced;
+#endif
 
             // STEP 1: Convert ADC samples to normalized complex numbers
-            // ADC range: 0-4095 (12-bit)
-            // Normalize to: -1.0 to +1.0 (centered at 2048 = 1.65V)
-            for (int i = 0; i < FFT_SIZE; i++) {
-                fft_buffer[i].real = ((float)adc_buffer[i] - 2048.0f) / 2048.0f;
-                fft_buffer[i].imag = 0.0f;  // No imaginary component (real signal)
-            }
+            PROFILE_BEGIN(ZONE_NORMALIZE);
+            fftNormalize(adc_buffer, fft_buffer, FFT_SIZE);
+            PROFILE_END(ZONE_NORMALIZE);
+
+#if FPGA_SEND_SAMPLES
+            // Raw block to the FPGA spectrum engine, copied out now before
+            // DMA wraps around onto it
+            fpgaSendSamples(adc_buffer);
+#endif
 
             // STEP 2: Perform FFT
             // Transforms time domain samples → frequency domain components
+            PROFILE_BEGIN(ZONE_FFT);
             fft_compute(fft_buffer, FFT_SIZE);
+            PROFILE_END(ZONE_FFT);
+
+            // STEP 3: Find the loudest notes (local maxima, loudest first).
+            // Nothing at or below FREQ_THRESHOLD is a candidate: DC / rumble
+            // is not something to play and must not take a voice.
+            PROFILE_BEGIN(ZONE_PEAKS);
+            int play_count = fftFindNotes(fft_buffer, FFT_SIZE, SAMPLE_RATE, MAG_THRESHOLD,
+                                          FREQ_THRESHOLD, mag_buffer, note_freqs, note_mags,
+                                          MAX_NOTES);
+            PROFILE_END(ZONE_PEAKS);
+
+            // Hand the note list to the coil voices. Pulses come from the
+            // timers (or the FPGA), this only moves preload registers.
+            PROFILE_BEGIN(ZONE_OUTPUT);
+#if COIL_ON_FPGA
+            fpgaSendVoices(note_freqs, play_count, INTERRUPTER_PULSE_US,
+                           INTERRUPTER_MAX_DUTY_PERMILLE);
+            while (fpgaLinkBusy());     // levels frame goes right after
+#else
+            interrupterSetNotes(note_freqs, play_count);
+#endif
 
-            // STEP 3: Find dominant frequency
-            // Calculate magnitude for each frequency bin and find maximum
-            float max_mag = 0.0f;
-            int max_bin = 0;
-
-            // Only check bins 1 to FFT_SIZE/2 (skip DC, use Nyquist limit)
-            for (int i = 1; i < FFT_SIZE / 2; i++) {
-                // Magnitude = sqrt(real² + imag²)
-                float real = fft_buffer[i].real;
-                float imag = fft_buffer[i].imag;
-                float mag = sqrtf(real * real + imag * imag);
-
-                if (mag > max_mag) {
-                    max_mag = mag;
-                    max_bin = i;
-                }
+            // Band levels for the LED display. DMA does the transfer, the
+            // frame is dropped if the last one is somehow still going.
+#if !FPGA_SEND_SAMPLES
+            fpgaBandLevels(mag_buffer, FFT_SIZE / 2,
+                           (float)SAMPLE_RATE / FFT_SIZE, MAG_THRESHOLD,
+                           band_levels);
+#if LATENCY_TEST
+            // A dropped frame never reached the FPGA, so it is not a reaction
+            if (fpgaSendLevels(band_levels) == 0) {
+                int lit = 0;
+                for (int i = 0; i < FPGA_NUM_BANDS; i++) lit |= band_levels[i];
+                latencyOutput(LAT_FPGA, lit != 0);
             }
+#else
+            fpgaSendLevels(band_levels);
+#endif
+#if FPGA_SEND_BARS
+            fpgaBarLevels(mag_buffer, FFT_SIZE / 2, MAG_THRESHOLD, bar_levels);
+            while (fpgaLinkBusy());     // right behind the levels frame
+            fpgaSendBars(bar_levels);
+#endif
+#endif
 
-            // Convert bin number to frequency in Hz
-            // Frequency = bin_number × (SAMPLE_RATE / FFT_SIZE)
-            float freq = (float)max_bin * SAMPLE_RATE / FFT_SIZE;
-
-            // STEP 4: LED Control Logic
-            // Turn ON if:
-            //   - Frequency > 100 Hz (avoid DC and low-frequency noise)
-            //   - Magnitude > 10.0 (avoid background noise)
-            if (freq > FREQ_THRESHOLD && max_mag > MAG_THRESHOLD) {
-                digitalWrite(LED_PIN, GPIO_HIGH);
-                printf("Detected: %d Hz (Mag: %d) -> LED ON\n",
-                       (int)freq, (int)max_mag);
+            // STEP 4: LED Control Logic, on the single dominant bin
+            float dominant_mag;
+            float dominant = fftDominant(mag_buffer, FFT_SIZE / 2,
+                                         (float)SAMPLE_RATE / FFT_SIZE, &dominant_mag);
+            int detected = fftDetect(dominant, dominant_mag, FREQ_THRESHOLD, MAG_THRESHOLD);
+            digitalWrite(LED_PIN, detected ? GPIO_HIGH : GPIO_LOW);
+#if LATENCY_TEST
+            latencyOutput(LAT_LED, detected);
+#endif
+#if TELEMETRY_ENABLE
+            // Whole spectrum to the host, never waits on the UART
+            if (!usartDMABusy()) {
+                int len = telemetryPackSpectrum(telemetry_frame, frame_seq, frame_cycles,
+                                                detected ? TELEMETRY_FLAG_DETECTED : 0,
+                                                note_freqs, note_mags, play_count,
+                                                mag_buffer, FFT_SIZE / 2,
+                                                band_levels, FPGA_NUM_BANDS);
+                usartSendDMA(telemetry_frame, len);
             } else {
-                digitalWrite(LED_PIN, GPIO_LOW);
-                // No print for OFF state to reduce UART traffic
+                telemetry_skipped++;
+            }
+#endif
+            PROFILE_END(ZONE_OUTPUT);
+
+            // No print for OFF state to reduce UART traffic
+            if (detected) {
+                printf("Detected: %d Hz (Mag: %d, %d notes) -> LED ON\n",
+                       (int)dominant, (int)dominant_mag, play_count);
+            }
+
+            acqHealthFrameEnd();
+
+#if FPGA_HISTORY_ON_DROP
+            if (!history_dumped && acqHealth()->framesDropped != 0) {
+                while (fpgaLinkBusy());
+                fpgaHistoryDump(0);
+                history_dumped = 1;
+            }
+#endif
+
+            // Worst case interrupterSetNotes time and pipeline health, every
+            // 256 frames (~8 s). Printed after the frame so it is not timed.
+            if ((acqHealth()->framesProcessed & 0xFF) == 0) {
+#if !COIL_ON_FPGA
+                const InterrupterStats* istats = interrupterStats();
+                printf("interrupterSetNotes: last %lu max %lu cycles\n",
+                       (unsigned long)istats->lastCycles,
+                       (unsigned long)istats->maxCycles);
+#endif
+                acqHealthPrint();
+                PROFILE_PRINT();
+                PROFILE_RESET();
+#if LATENCY_TEST
+                // Every TC frame is processed, so the hop is one buffer
+                printf("LAT FFT %d, hop %d, %d Hz, %s\n", FFT_SIZE, FFT_SIZE,
+                       SAMPLE_RATE, FFT_BACKEND);
+                latencyPrint();
+#endif
+
+                printf("FPGA frames: %lu sent, %lu dropped\n",
+                       (unsigned long)fpgaFramesSent(),
+                       (unsigned long)fpgaFramesDropped());
+#if TELEMETRY_ENABLE
+                printf("Telemetry frames skipped (UART busy): %lu\n",
+                       (unsigned long)telemetry_skipped);
+#endif
             }
+
+            // Time until the next frame is ready, prints included
+            PROFILE_BEGIN(ZONE_WAIT);
         }
     }
 